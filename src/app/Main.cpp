@@ -1,19 +1,271 @@
 #include "core/Graph.h"
+#include "core/Metrics.h"
+#include "core/NodeOrder.h"
+#include "route/HierarchicalRouter.h"
+#include "route/KShortestPaths.h"
+#include "route/MultiPlaneSpf.h"
 #include "route/Router.h"
+#include "route/TrafficEngineering.h"
 #include "io/JsonImporter.h"
 #include "io/JsonExporter.h"
+#include "io/ChangeJournal.h"
+#include "io/Checkpoint.h"
+#include "io/RouteArchive.h"
+#include "io/RoutePublisher.h"
+#include "io/RouteSegment.h"
+#include "io/TraceReader.h"
+#include "sim/HysteresisSweep.h"
+#include "sim/Mobility.h"
+#include "sim/OlsrSim.h"
+#include "sim/TraceReplay.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <random>
+#include <cstdio>
+#include <filesystem>
 #include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace olsr;
 
 extern int run_gui(int argc, char** argv);
 
+// "0.1,0.3,0.5" -> {0.1, 0.3, 0.5}
+static std::vector<double> parseList(const char* s) {
+    std::vector<double> out;
+    char* end = nullptr;
+    while (*s) {
+        out.push_back(std::strtod(s, &end));
+        if (end == s) break;
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return out;
+}
+
+// "1:5,2:7" lists pairs; "random:n" draws n distinct-endpoint pairs with a fixed seed.
+static std::vector<PathQuery> parsePairs(const std::string& spec, const Graph& g) {
+    std::vector<PathQuery> out;
+    if (spec.rfind("random:", 0) == 0) {
+        const size_t count = std::strtoul(spec.c_str() + 7, nullptr, 10);
+        const size_t n = g.nodes().size();
+        if (n < 2) return out;
+        std::mt19937_64 rng(1);
+        while (out.size() < count) {
+            const NodeId s = g.nodes()[rng() % n].id;
+            const NodeId t = g.nodes()[rng() % n].id;
+            if (s != t) out.push_back({s, t});
+        }
+        return out;
+    }
+    const char* p = spec.c_str();
+    char* end = nullptr;
+    while (*p) {
+        const unsigned long s = std::strtoul(p, &end, 10);
+        if (end == p || *end != ':') break;
+        p = end + 1;
+        const unsigned long t = std::strtoul(p, &end, 10);
+        if (end == p) break;
+        out.push_back({static_cast<NodeId>(s), static_cast<NodeId>(t)});
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return out;
+}
+
+#ifndef _WIN32
+// One reader process of --shm-stress: random tables and single lookups
+// against the segment until the deadline. Every result must come from one
+// generation: rows pass their checksum, each next hop is itself a 1-hop
+// route of the same row, and generations never go backwards.
+static int shmReader(const std::string& name, std::vector<NodeId> ids, uint32_t index, double seconds) {
+    RouteSegmentReader reader;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (!reader.open(name) || reader.generation() == 0) {
+        if (std::chrono::steady_clock::now() > deadline) return 1;
+        usleep(1000);
+    }
+    std::mt19937_64 rng(index + 1);
+    std::vector<SegmentRoute> row;
+    uint64_t tables = 0, lookups = 0, errors = 0, firstGen = 0, lastGen = 0;
+    auto seen = [&](uint64_t gen) {
+        if (gen < lastGen) ++errors;
+        lastGen = std::max(lastGen, gen);
+        if (!firstGen) firstGen = gen;
+    };
+    while (std::chrono::steady_clock::now() < deadline) {
+        const NodeId src = ids[rng() % ids.size()];
+        uint64_t gen = 0;
+        if (reader.table(src, row, &gen)) {
+            ++tables;
+            seen(gen);
+            for (const SegmentRoute& e : row) {
+                if (e.hops == 1) {
+                    errors += e.nextHop != e.destination;
+                    continue;
+                }
+                auto hop = std::lower_bound(row.begin(), row.end(), e.nextHop,
+                                            [](const SegmentRoute& a, NodeId id) { return a.destination < id; });
+                errors += hop == row.end() || hop->destination != e.nextHop || hop->hops != 1;
+            }
+        }
+        for (int k = 0; k < 64; ++k) {
+            SegmentRoute e{};
+            const NodeId dst = ids[rng() % ids.size()];
+            if (!reader.lookup(src, dst, e, &gen)) continue;
+            ++lookups;
+            seen(gen);
+            errors += e.hops == 1 && e.nextHop != dst;
+        }
+    }
+    errors += reader.checksumFailures();
+    std::printf("  reader %u: %llu tables, %llu lookups, generations %llu-%llu, %llu retries, %llu errors\n", index,
+                static_cast<unsigned long long>(tables), static_cast<unsigned long long>(lookups),
+                static_cast<unsigned long long>(firstGen), static_cast<unsigned long long>(lastGen),
+                static_cast<unsigned long long>(reader.retries()), static_cast<unsigned long long>(errors));
+    std::fflush(stdout);
+    return errors ? 1 : 0;
+}
+#endif
+
+// --shm-stress: reader processes against a writer that jams (takes down) and
+// unjams random links, applies each change and publishes the result.
+static int runShmStress(Graph& g, Router& router, RoutePublisher& pub, const std::string& name, double seconds,
+                        uint32_t readers) {
+#ifdef _WIN32
+    (void)g, (void)router, (void)pub, (void)name, (void)seconds, (void)readers;
+    std::cerr << "--shm-stress needs POSIX shared memory\n";
+    return 1;
+#else
+    std::vector<NodeId> ids;
+    for (const Node& n : g.nodes()) ids.push_back(n.id);
+    if (ids.empty()) return 0;
+    std::vector<pid_t> children;
+    for (uint32_t k = 0; k < readers; ++k) {
+        std::fflush(stdout);
+        const pid_t pid = fork();
+        if (pid == 0) _exit(shmReader(name, ids, k, seconds));
+        if (pid > 0) children.push_back(pid);
+    }
+    std::mt19937_64 rng(7);
+    std::vector<std::pair<NodeId, NodeId>> jammed;
+    uint64_t publications = 0;
+    uint64_t rows = 0;
+    double worstMs = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::duration<double>(seconds);
+    std::string err;
+    while (std::chrono::steady_clock::now() < deadline) {
+        g.begin();
+        if (jammed.size() < 4 && !g.links().empty()) {
+            const Link& l = g.links()[rng() % g.links().size()];
+            if (l.status == LinkStatus::UP && g.setLinkStatus(l.u, l.v, LinkStatus::DOWN)) jammed.emplace_back(l.u, l.v);
+        } else if (!jammed.empty()) {
+            g.setLinkStatus(jammed.front().first, jammed.front().second, LinkStatus::UP);
+            jammed.erase(jammed.begin());
+        }
+        const GraphChangeLog log = g.commit();
+        auto t0 = std::chrono::steady_clock::now();
+        router.applyChanges(g, log);
+        if (!pub.publish(g, router, &err)) {
+            std::cerr << "Publish failed: " << err << "\n";
+            break;
+        }
+        worstMs = std::max(worstMs, 1e3 * std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+        ++publications;
+        rows += pub.rowsWritten();
+    }
+    // Leave the topology as loaded for the rest of the run.
+    g.begin();
+    for (auto [u, v] : jammed) g.setLinkStatus(u, v, LinkStatus::UP);
+    router.applyChanges(g, g.commit());
+    pub.publish(g, router, &err);
+    int failed = 0;
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Shared-memory stress: %llu generations in %.2f s (worst recompute+publish %.2f ms, %.1f of %zu "
+                "rows rewritten each), %u readers, %d failed\n",
+                static_cast<unsigned long long>(publications), wall, worstMs,
+                publications ? double(rows) / double(publications) : 0.0, ids.size(), readers, failed);
+    return failed ? 1 : 0;
+#endif
+}
+
+static void printMetrics() {
+    std::printf("Peak RSS: %.1f MiB\n", metrics::peakRssBytes() / (1024.0 * 1024.0));
+    if (!metrics::enabled()) {
+        std::cout << "Metrics: compiled out (OLSR_LITE_ENABLE_METRICS=OFF)\n";
+        return;
+    }
+    const metrics::Snapshot s = metrics::snapshot();
+    std::cout << "Metrics:\n";
+    for (size_t c = 0; c < metrics::kCounters; ++c) {
+        std::printf("  %-18s %14llu\n", metrics::name(static_cast<metrics::Counter>(c)),
+                    static_cast<unsigned long long>(s.counters[c]));
+    }
+    std::printf("  %-18s %8s %10s %10s %10s %10s\n", "phase", "count", "total ms", "p50 us", "p99 us", "max us");
+    for (size_t p = 0; p < metrics::kPhases; ++p) {
+        const metrics::PhaseStats& ph = s.phases[p];
+        if (ph.count == 0) continue;
+        std::printf("  %-18s %8llu %10.3f %10.1f %10.1f %10.1f\n", metrics::name(static_cast<metrics::Phase>(p)),
+                    static_cast<unsigned long long>(ph.count), ph.totalNs * 1e-6, ph.percentileNs(0.5) * 1e-3,
+                    ph.percentileNs(0.99) * 1e-3, ph.maxNs * 1e-3);
+    }
+}
+
 int main(int argc, char** argv) {
     std::string topoPath;
     std::string exportPath;
     bool noGui = false;
+    RouteBackend backend = RouteBackend::Auto;
+    RoutePolicy policy = RoutePolicy::Shortest;
+    bool policyGiven = false;
+    double delta = 0.0;
+    double simMs = 0.0;
+    OlsrSimParams simParams;
+    bool withMpr = false;
+    std::string trafficPath;
+    uint32_t teIterations = 0;
+    std::string replayPath;
+    ReplayParams replayParams;
+    uint32_t sweepRuns = 0;
+    SweepGrid sweepGrid;
+    JitterModel jitter;
+    bool showMetrics = false;
+    uint32_t benchRuns = 0;
+    std::string changesPath;
+    std::string traceOutPath;
+    bool compressTables = false;
+    std::string packedPath;
+    uint32_t kPaths = 0;
+    std::string pathPairs;
+    PathMode pathMode = PathMode::Loopless;
+    bool hierarchical = false;
+    AreaParams areaParams;
+    std::string planeName;
+    NodeOrdering nodeOrdering = NodeOrdering::Import;
+    double mobilitySeconds = 0.0;
+    MobilityParams mobilityParams;
+    std::string mobilityTracePath;
+    bool mobilityRoutes = true;
+    std::string publishName;
+    double shmStressSeconds = 0.0;
+    uint32_t shmReaders = 4;
+    std::string journalPath;
+    std::string checkpointPath;
+    uint64_t checkpointEvery = 0;
+    std::string recoverPath;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--topo" && i + 1 < argc) {
@@ -22,43 +274,736 @@ int main(int argc, char** argv) {
             exportPath = argv[++i];
         } else if (arg == "--no-gui") {
             noGui = true;
+        } else if (arg == "--backend" && i + 1 < argc) {
+            std::string b = argv[++i];
+            if (b == "dijkstra") backend = RouteBackend::Dijkstra;
+            else if (b == "fw") backend = RouteBackend::FloydWarshall;
+            else if (b == "delta") backend = RouteBackend::DeltaStepping;
+            else if (b == "bfs") backend = RouteBackend::HopCount;
+            else if (b == "auto") backend = RouteBackend::Auto;
+            else {
+                std::cerr << "Unknown backend: " << b << "\n";
+                return 1;
+            }
+        } else if (arg == "--policy" && i + 1 < argc) {
+            const std::string p = argv[++i];
+            if (!parseRoutePolicy(p, policy)) {
+                std::cerr << "Unknown routing policy: " << p << "\n";
+                return 1;
+            }
+            policyGiven = true;
+        } else if (arg == "--delta" && i + 1 < argc) {
+            delta = std::strtod(argv[++i], nullptr);
+            if (!std::isfinite(delta) || delta <= 0.0) {
+                std::cerr << "--delta must be a positive bucket width: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--sim" && i + 1 < argc) {
+            simMs = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--sim-loss" && i + 1 < argc) {
+            simParams.lossProb = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--sim-latency" && i + 1 < argc) {
+            simParams.latencyMs = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--sim-no-spf") {
+            simParams.spfDelayMs = -1.0;
+        } else if (arg == "--sim-mpr") {
+            simParams.useMpr = true;
+        } else if (arg == "--mpr") {
+            withMpr = true;
+        } else if (arg == "--traffic" && i + 1 < argc) {
+            trafficPath = argv[++i];
+        } else if (arg == "--te" && i + 1 < argc) {
+            teIterations = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--replay-step-ms" && i + 1 < argc) {
+            replayParams.stepMs = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--replay-no-hyst") {
+            replayParams.hysteresis = false;
+        } else if (arg == "--sweep" && i + 1 < argc) {
+            sweepRuns = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--sweep-alpha" && i + 1 < argc) {
+            sweepGrid.alpha = parseList(argv[++i]);
+        } else if (arg == "--sweep-theta-up" && i + 1 < argc) {
+            sweepGrid.thetaUp = parseList(argv[++i]);
+        } else if (arg == "--sweep-theta-down" && i + 1 < argc) {
+            sweepGrid.thetaDown = parseList(argv[++i]);
+        } else if (arg == "--sweep-hold" && i + 1 < argc) {
+            sweepGrid.holdMs = parseList(argv[++i]);
+        } else if (arg == "--sweep-duration" && i + 1 < argc) {
+            jitter.durationMs = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--sweep-sigma" && i + 1 < argc) {
+            jitter.sigma = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--sweep-observers" && i + 1 < argc) {
+            jitter.observers = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--sweep-seed" && i + 1 < argc) {
+            jitter.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--changes" && i + 1 < argc) {
+            changesPath = argv[++i];
+        } else if (arg == "--bench" && i + 1 < argc) {
+            benchRuns = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--areas" && i + 1 < argc) {
+            std::string a = argv[++i];
+            if (a == "declared") areaParams.useDeclared = true;
+            else if (a == "auto") areaParams.useDeclared = false;
+            else {
+                std::cerr << "Unknown area mode: " << a << "\n";
+                return 1;
+            }
+            hierarchical = true;
+        } else if (arg == "--plane" && i + 1 < argc) {
+            planeName = argv[++i];
+        } else if (arg == "--reorder" && i + 1 < argc) {
+            std::string o = argv[++i];
+            if (o == "bfs") nodeOrdering = NodeOrdering::Bfs;
+            else if (o == "rcm") nodeOrdering = NodeOrdering::Rcm;
+            else if (o == "hilbert") nodeOrdering = NodeOrdering::Hilbert;
+            else if (o == "import") nodeOrdering = NodeOrdering::Import;
+            else {
+                std::cerr << "Unknown node order: " << o << "\n";
+                return 1;
+            }
+        } else if (arg == "--area-size" && i + 1 < argc) {
+            areaParams.targetSize = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--compress-tables") {
+            compressTables = true;
+        } else if (arg == "--export-packed" && i + 1 < argc) {
+            packedPath = argv[++i];
+        } else if (arg == "--packed-info" && i + 1 < argc) {
+            RouteArchive archive;
+            std::string err;
+            if (!archive.read(argv[++i], &err)) {
+                std::cerr << "Error reading route archive: " << err << "\n";
+                return 1;
+            }
+            const double flat = double(archive.routeCount()) * sizeof(RouteEntry);
+            std::printf("%zu tables, %zu routes: %.2f MiB packed vs %.2f MiB flat (%.1fx)\n", archive.tableCount(),
+                        archive.routeCount(), archive.bytes() / (1024.0 * 1024.0), flat / (1024.0 * 1024.0),
+                        archive.bytes() ? flat / archive.bytes() : 0.0);
+            return 0;
+        } else if (arg == "--mobility" && i + 1 < argc) {
+            mobilitySeconds = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--mobility-trace" && i + 1 < argc) {
+            mobilityTracePath = argv[++i];
+        } else if (arg == "--mobility-range" && i + 1 < argc) {
+            mobilityParams.range = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--mobility-speed" && i + 1 < argc) {
+            const std::vector<double> v = parseList(argv[++i]);
+            if (!v.empty()) mobilityParams.minSpeed = mobilityParams.maxSpeed = v.front();
+            if (v.size() > 1) mobilityParams.maxSpeed = v[1];
+        } else if (arg == "--mobility-pause" && i + 1 < argc) {
+            mobilityParams.pauseMs = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--mobility-tick-ms" && i + 1 < argc) {
+            mobilityParams.tickMs = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--mobility-levels" && i + 1 < argc) {
+            mobilityParams.weightLevels = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--mobility-no-routes") {
+            mobilityRoutes = false;
+        } else if (arg == "--publish" && i + 1 < argc) {
+            publishName = argv[++i];
+        } else if (arg == "--shm-stress" && i + 1 < argc) {
+            shmStressSeconds = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--shm-readers" && i + 1 < argc) {
+            shmReaders = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journalPath = argv[++i];
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpointPath = argv[++i];
+        } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+            checkpointEvery = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--recover" && i + 1 < argc) {
+            recoverPath = argv[++i];
+        } else if (arg == "--k-paths" && i + 1 < argc) {
+            kPaths = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--path-pairs" && i + 1 < argc) {
+            pathPairs = argv[++i];
+        } else if (arg == "--path-disjoint") {
+            pathMode = PathMode::EdgeDisjoint;
+        } else if (arg == "--metrics") {
+            showMetrics = true;
+        } else if (arg == "--trace-out" && i + 1 < argc) {
+            traceOutPath = argv[++i];
+        } else if (arg == "--trace-to-bin" && i + 2 < argc) {
+            std::string in = argv[++i];
+            std::string out = argv[++i];
+            std::string err;
+            if (!TraceReader::writeBinary(in, out, &err)) {
+                std::cerr << "Trace conversion failed: " << err << "\n";
+                return 1;
+            }
+            std::cout << "Wrote binary trace " << out << "\n";
+            return 0;
         }
     }
 
     if (!noGui) {
         return run_gui(argc, argv);
     }
+    if (!traceOutPath.empty()) {
+        if (!metrics::enabled()) std::cerr << "--trace-out ignored: built without OLSR_LITE_ENABLE_METRICS\n";
+        metrics::startTrace();
+    }
+
+    auto configure = [&](Router& r) {
+        r.setBackend(backend);
+        r.setPolicy(policy);
+        r.deltaEngine().setDelta(delta);
+        if (compressTables) r.setTableStorage(TableStorage::Compressed);
+    };
+    Router router;
+    configure(router);
 
     Graph g;
-    if (!topoPath.empty()) {
+    uint64_t checkpointLsn = 0;
+    bool routesRestored = false;
+    if (!recoverPath.empty()) {
+        // Warm restart: the checkpoint, then whatever the journal logged after it.
+        auto start = std::chrono::steady_clock::now();
+        CheckpointInfo info;
+        std::string err;
+        if (!Checkpoint::read(recoverPath, g, hierarchical ? nullptr : &router, &info, &err)) {
+            std::cerr << "Error reading checkpoint: " << err << "\n";
+            return 1;
+        }
+        auto mid = std::chrono::steady_clock::now();
+        checkpointLsn = info.lsn;
+        routesRestored = info.routes > 0;
+        // The run continues under the checkpoint's policy. Tables computed
+        // under another one than --policy asks for are recomputed instead.
+        if (policyGiven && policy != info.policy) {
+            if (routesRestored) {
+                std::cerr << "Checkpoint routes follow policy " << routePolicyName(info.policy) << "; recomputing for "
+                          << routePolicyName(policy) << "\n";
+            }
+            routesRestored = false;
+        }
+        if (!policyGiven) policy = info.policy;
+        router.setPolicy(policy);
+        JournalReplayStats js;
+        std::error_code ec;
+        if (!journalPath.empty() && std::filesystem::exists(journalPath, ec)) {
+            // One transaction over the whole tail: the routes are brought
+            // up to date once, from the net change.
+            g.begin();
+            if (!ChangeJournal::replay(journalPath, info.lsn, g, nullptr, &js, &err)) {
+                std::cerr << "Error replaying journal: " << err << "\n";
+                return 1;
+            }
+            const GraphChangeLog log = g.commit();
+            if (routesRestored) router.applyChanges(g, log);
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::printf("Recovered checkpoint at LSN %llu: %zu nodes, %zu links, %zu routes, %.2f MiB in %.3f s\n",
+                    static_cast<unsigned long long>(info.lsn), info.nodes, info.links, info.routes,
+                    info.bytes / (1024.0 * 1024.0), std::chrono::duration<double>(mid - start).count());
+        std::printf("  replayed %llu journal records (%llu link changes, %llu already checkpointed)%s in %.3f s; "
+                    "%.3f s total\n",
+                    static_cast<unsigned long long>(js.records), static_cast<unsigned long long>(js.linkChanges),
+                    static_cast<unsigned long long>(js.skipped), js.tornTail ? ", torn tail dropped" : "",
+                    std::chrono::duration<double>(end - mid).count(),
+                    std::chrono::duration<double>(end - start).count());
+        checkpointLsn = std::max(checkpointLsn, js.lastLsn);
+    } else if (!topoPath.empty()) {
         JsonImporter imp;
         std::string err;
         if (!imp.loadTopology(topoPath, g, &err)) {
             std::cerr << "Error loading topology: " << err << "\n";
             return 1;
         }
+        // The topology says what its weights mean; --policy overrides it.
+        if (!policyGiven && parseRoutePolicy(imp.policy(), policy)) router.setPolicy(policy);
+        if (imp.heavyLinks() && policy != RoutePolicy::Reliable) {
+            std::cerr << imp.heavyLinks() << " links weigh " << kCostLimit
+                      << " or more: the cost grid ends there, so paths over them compare as equal\n";
+        }
     } else {
         // Minimal default graph: 2 nodes, 1 link
         auto n1 = g.addNode("R1", 100, 100);
         auto n2 = g.addNode("R2", 200, 100);
         g.addLink(n1, n2, 1.0);
     }
+    auto printPartition = [&g](const char* when) {
+        const Connectivity& conn = g.connectivity();
+        if (!conn.partitioned()) return;
+        std::printf("Partitioned %s: %u components, largest %zu of %zu nodes\n", when, conn.componentCount(),
+                    conn.components().front().size(), g.nodes().size());
+    };
+    printPartition("at load");
 
-    Router router;
-    router.recomputeAll(g);
+    // Node storage order for SPF locality. --bench keeps the import order
+    // around to time against.
+    static const char* kOrderNames[] = {"import", "bfs", "rcm", "hilbert"};
+    Graph importOrder;
+    if (nodeOrdering != NodeOrdering::Import) {
+        if (benchRuns > 0 && !hierarchical) importOrder = g;
+        auto start = std::chrono::steady_clock::now();
+        reorderNodes(g, nodeOrdering);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("Reordered %zu nodes (%s) in %.3f s\n", g.nodes().size(),
+                    kOrderNames[static_cast<int>(nodeOrdering)], wall);
+    }
+
+    // The two-level router replaces the flat N^2 tables for routes and export.
+    HierarchicalRouter hier(areaParams);
+    if (hierarchical && policy != RoutePolicy::Shortest) {
+        std::cerr << "Routing policy " << routePolicyName(policy) << " ignored: hierarchical routes are shortest paths\n";
+    }
+    if (hierarchical) {
+        auto start = std::chrono::steady_clock::now();
+        hier.recomputeAll(g);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t smallest = g.nodes().size(), largest = 0;
+        for (uint32_t a = 0; a < hier.areaCount(); ++a) {
+            const size_t sz = hier.areaNodes(a).size();
+            smallest = std::min(smallest, sz);
+            largest = std::max(largest, sz);
+        }
+        const double flat = double(g.nodes().size()) * double(g.nodes().size());
+        std::printf("Hierarchical routing (%s areas): %u areas of %zu-%zu nodes, %zu border routers, "
+                    "%zu backbone edges in %.3f s\n",
+                    hier.declared() ? "declared" : "automatic", hier.areaCount(), hier.areaCount() ? smallest : 0,
+                    largest, hier.borderCount(), hier.backboneEdges(), wall);
+        std::printf("  %zu table cells (%.2f MiB) vs %.0f for flat tables (%.1f%%)\n", hier.tableEntries(),
+                    hier.memoryBytes() / (1024.0 * 1024.0), flat,
+                    flat > 0.0 ? 100.0 * double(hier.tableEntries()) / flat : 0.0);
+        if (areaParams.useDeclared && !hier.declared()) {
+            std::cerr << "Not every node declares an area; partitioned automatically\n";
+        }
+    } else if (!routesRestored) {
+        auto start = std::chrono::steady_clock::now();
+        router.recomputeAll(g);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (compressTables) {
+            const double flat = double(router.routeCount()) * sizeof(RouteEntry);
+            std::printf("Compressed route tables: %zu routes in %.2f MiB vs %.2f MiB flat (%.1fx), %.3f s\n",
+                        router.routeCount(), router.tableBytes() / (1024.0 * 1024.0), flat / (1024.0 * 1024.0),
+                        router.tableBytes() ? flat / router.tableBytes() : 0.0, wall);
+        }
+    }
+
+    // Every metric plane of the topology from one traversal per source;
+    // --plane picks the one that is exported and printed.
+    MultiPlaneRouter planes;
+    uint32_t plane = 0;
+    if (!planeName.empty()) {
+        const int p = g.planeIndex(planeName);
+        if (p < 0) {
+            std::cerr << "Unknown metric plane: " << planeName << "\n";
+            return 1;
+        }
+        plane = static_cast<uint32_t>(p);
+        if (hierarchical && plane > 0) std::cerr << "--plane ignored: hierarchical routing uses plane 0\n";
+    }
+    if (g.planeCount() > 1 && !hierarchical) {
+        auto start = std::chrono::steady_clock::now();
+        planes.recomputeAll(g);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::string names;
+        for (uint32_t p = 0; p < g.planeCount(); ++p) names += (p ? ", " : "") + g.planeName(p);
+        std::printf("Metric planes (%s): routed together in %.3f s, %.2f scans per vertex\n", names.c_str(), wall,
+                    planes.scansPerVertex());
+    }
+    const bool planeTables = plane > 0 && planes.planeCount() > plane;
+    if (planeTables && policy != RoutePolicy::Shortest) {
+        std::cerr << "Routing policy " << routePolicyName(policy) << " ignored for plane " << planeName
+                  << ": metric planes route by shortest paths\n";
+    }
+
+    if (benchRuns > 0 && hierarchical) {
+        const metrics::Snapshot before = metrics::snapshot();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t k = 0; k < benchRuns; ++k) hier.recomputeAll(g);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const metrics::Snapshot after = metrics::snapshot();
+        std::printf("Hierarchical recompute x%u: %.3f ms each", benchRuns, 1e3 * wall / benchRuns);
+        if (metrics::enabled()) {
+            std::printf(", %.0f allocations / %.0f bytes each",
+                        double(after[metrics::Counter::Allocations] - before[metrics::Counter::Allocations]) / benchRuns,
+                        double(after[metrics::Counter::AllocatedBytes] - before[metrics::Counter::AllocatedBytes]) / benchRuns);
+        }
+        std::printf("; peak RSS %.1f MiB\n", metrics::peakRssBytes() / (1024.0 * 1024.0));
+    } else if (benchRuns > 0) {
+        const metrics::Snapshot before = metrics::snapshot();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t k = 0; k < benchRuns; ++k) router.recomputeAll(g);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const metrics::Snapshot after = metrics::snapshot();
+        static const char* kBackendNames[] = {"auto", "dijkstra", "fw", "delta", "bfs"};
+        std::printf("Recompute x%u (%s%s%s): %.3f ms each", benchRuns,
+                    kBackendNames[static_cast<int>(router.lastBackend())],
+                    policy == RoutePolicy::Shortest ? "" : ", ",
+                    policy == RoutePolicy::Shortest ? "" : routePolicyName(policy), 1e3 * wall / benchRuns);
+        if (metrics::enabled()) {
+            std::printf(", %.0f allocations / %.0f bytes each",
+                        double(after[metrics::Counter::Allocations] - before[metrics::Counter::Allocations]) / benchRuns,
+                        double(after[metrics::Counter::AllocatedBytes] - before[metrics::Counter::AllocatedBytes]) / benchRuns);
+        }
+        std::printf("; route arena %.2f MiB in %zu block(s); peak RSS %.1f MiB\n",
+                    router.arena().bytesReserved() / (1024.0 * 1024.0), router.arena().blockCount(),
+                    metrics::peakRssBytes() / (1024.0 * 1024.0));
+        if (nodeOrdering != NodeOrdering::Import) {
+            // Fresh routers on both orders, one warm-up recompute each.
+            auto measure = [&](const Graph& graph, double& ms, uint64_t& misses) {
+                Router r;
+                configure(r);
+                r.recomputeAll(graph);
+                metrics::CacheMissCounter counter;
+                auto t0 = std::chrono::steady_clock::now();
+                for (uint32_t k = 0; k < benchRuns; ++k) r.recomputeAll(graph);
+                ms = 1e3 * std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / benchRuns;
+                misses = counter.read() / benchRuns;
+                return counter.valid();
+            };
+            double msBefore = 0.0, msAfter = 0.0;
+            uint64_t missBefore = 0, missAfter = 0;
+            bool counted = measure(importOrder, msBefore, missBefore);
+            counted = measure(g, msAfter, missAfter) && counted;
+            std::printf("Node order %s vs import: recompute %.3f ms vs %.3f ms (%.2fx)", kOrderNames[static_cast<int>(nodeOrdering)],
+                        msAfter, msBefore, msAfter > 0.0 ? msBefore / msAfter : 0.0);
+            if (counted) {
+                std::printf(", cache misses %.2fM vs %.2fM (%.2fx)\n", missAfter * 1e-6, missBefore * 1e-6,
+                            missAfter ? double(missBefore) / double(missAfter) : 0.0);
+            } else {
+                std::printf(", cache misses unavailable (perf events not permitted)\n");
+            }
+        }
+        if (planes.planeCount() > 1) {
+            start = std::chrono::steady_clock::now();
+            for (uint32_t k = 0; k < benchRuns; ++k) planes.recomputeAll(g);
+            const double together = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            // The alternative: one graph copy and one full recompute per plane.
+            start = std::chrono::steady_clock::now();
+            for (uint32_t k = 0; k < benchRuns; ++k) {
+                for (uint32_t p = 0; p < g.planeCount(); ++p) {
+                    Graph copy = g;
+                    for (Link& l : copy.links()) l.weight = l.metric(p);
+                    Router single;
+                    single.setBackend(backend);
+                    single.recomputeAll(copy);
+                }
+            }
+            const double separate = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::printf("Multi-plane recompute x%u: %.3f ms each vs %.3f ms for %u separate recomputes (%.2fx)\n",
+                        benchRuns, 1e3 * together / benchRuns, 1e3 * separate / benchRuns, g.planeCount(),
+                        together > 0.0 ? separate / together : 0.0);
+        }
+    }
+
+    // Write-ahead journal of every committed transaction below, with
+    // checkpoints that let --recover skip the cold start.
+    ChangeJournal journal;
+    if (!journalPath.empty()) {
+        std::string err;
+        // A cold start does not continue the state an existing journal
+        // describes, so it starts a new one.
+        std::error_code ec;
+        if (recoverPath.empty() && std::filesystem::file_size(journalPath, ec) > 0 && !ec) {
+            std::cerr << "Journal " << journalPath << " restarted: without --recover its records do not apply\n";
+        }
+        const bool opened = recoverPath.empty() ? journal.create(journalPath, checkpointLsn, &err)
+                                                : journal.open(journalPath, checkpointLsn, &err);
+        if (!opened) {
+            std::cerr << "Error opening journal: " << err << "\n";
+            return 1;
+        }
+    }
+    // A replaced journal starts past the LSNs it replaced.
+    const uint64_t journalBase = journal.isOpen() ? journal.lastLsn() : checkpointLsn;
+    bool routesCurrent = !hierarchical;
+    uint64_t sinceCheckpoint = 0;
+    double checkpointSeconds = 0.0;
+    uint32_t checkpoints = 0;
+    auto writeCheckpoint = [&]() -> bool {
+        auto start = std::chrono::steady_clock::now();
+        std::string err;
+        const uint64_t lsn = journal.isOpen() ? journal.lastLsn() : checkpointLsn;
+        if (!Checkpoint::write(g, routesCurrent ? &router : nullptr, router.policy(), lsn, checkpointPath, &err)) {
+            std::cerr << "Checkpoint failed: " << err << "\n";
+            return false;
+        }
+        // Everything up to lsn is in the checkpoint now.
+        if (journal.isOpen() && !journal.truncate()) {
+            std::cerr << "Journal truncation failed\n";
+            return false;
+        }
+        sinceCheckpoint = 0;
+        ++checkpoints;
+        checkpointSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    };
+    auto journalCommit = [&](const GraphChangeLog& log) {
+        if (!journal.isOpen() || journal.append(g, log) == 0) return true;
+        if (checkpointEvery == 0 || checkpointPath.empty() || ++sinceCheckpoint < checkpointEvery) return true;
+        return writeCheckpoint();
+    };
+
+    if (!changesPath.empty()) {
+        JsonImporter imp;
+        std::vector<GraphEdit> edits;
+        std::string err;
+        if (!imp.loadChanges(changesPath, edits, &err)) {
+            std::cerr << "Error loading change set: " << err << "\n";
+            return 1;
+        }
+        if (imp.heavyLinks() && policy != RoutePolicy::Reliable) {
+            std::cerr << imp.heavyLinks() << " changed links weigh " << kCostLimit
+                      << " or more: the cost grid ends there, so paths over them compare as equal\n";
+        }
+        const uint32_t componentsBefore = g.connectivity().componentCount();
+        auto start = std::chrono::steady_clock::now();
+        g.begin();
+        size_t rejected = 0;
+        for (const GraphEdit& e : edits) rejected += !g.apply(e);
+        const GraphChangeLog log = g.commit();
+        if (!journalCommit(log)) return 2;
+        size_t sources = g.nodes().size();
+        if (hierarchical) hier.recomputeAll(g);
+        else sources = router.applyChanges(g, log);
+        if (planes.planeCount() > 0) planes.recomputeAll(g);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Applied " << log.operations << " of " << edits.size() << " edits (" << rejected << " rejected, "
+                  << log.links.size() << " links changed) in one transaction; recomputed " << sources << " of "
+                  << g.nodes().size() << " sources in " << wall << " s\n";
+        if (g.connectivity().componentCount() != componentsBefore) {
+            if (g.connectivity().partitioned()) printPartition("after changes");
+            else std::cout << "Connected again after changes\n";
+        }
+    }
+
+    if (mobilitySeconds > 0.0 && mobilityParams.tickMs > 0.0) {
+        MobilityModel mobility(g, mobilityParams);
+        std::string err;
+        if (!mobilityTracePath.empty() && !mobility.loadTrace(mobilityTracePath, &err)) {
+            std::cerr << "Error loading position trace: " << err << "\n";
+            return 1;
+        }
+        const uint64_t ticks = static_cast<uint64_t>(std::ceil(mobilitySeconds * 1000.0 / mobilityParams.tickMs));
+        const bool incremental = mobilityRoutes && !hierarchical;
+        double routeMs = 0.0, worstTickMs = 0.0;
+        size_t sources = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t t = 0; t < ticks; ++t) {
+            auto t0 = std::chrono::steady_clock::now();
+            const GraphChangeLog log = mobility.tick();
+            auto t1 = std::chrono::steady_clock::now();
+            if (incremental) sources += router.applyChanges(g, log);
+            else routesCurrent = false;
+            auto t2 = std::chrono::steady_clock::now();
+            if (!journalCommit(log)) return 2;
+            routeMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+            worstTickMs = std::max(worstTickMs, std::chrono::duration<double, std::milli>(t2 - t0).count());
+        }
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (hierarchical && mobilityRoutes) hier.recomputeAll(g);
+        if (planes.planeCount() > 0) planes.recomputeAll(g);
+        const MobilityStats& st = mobility.stats();
+        const double perTick = ticks ? 1.0 / double(ticks) : 0.0;
+        std::printf("Mobility (%s): %llu ticks of %.0f ms in %.3f s wall (%.0f ticks/s), range %.3g, "
+                    "mean degree %.2f\n",
+                    mobilityTracePath.empty() ? "random waypoint" : "trace", static_cast<unsigned long long>(ticks),
+                    mobilityParams.tickMs, wall, wall > 0.0 ? ticks / wall : 0.0, mobility.range(),
+                    g.nodes().empty() ? 0.0 : 2.0 * double(mobility.linkCount()) / double(g.nodes().size()));
+        std::printf("  per tick: %.1f links added, %.1f removed, %.1f reweighted, %.1f pairs checked; "
+                    "%.3f ms discovery, %.3f ms graph, %.3f ms routes (%.1f sources); worst tick %.3f ms\n",
+                    st.linksAdded * perTick, st.linksRemoved * perTick, st.weightChanges * perTick,
+                    st.candidates * perTick, st.discoveryMs * perTick, st.applyMs * perTick, routeMs * perTick,
+                    sources * perTick, worstTickMs);
+        if (st.malformed) std::cout << "  " << st.malformed << " malformed trace lines skipped\n";
+    }
+
+    if (!checkpointPath.empty() && !writeCheckpoint()) return 2;
+    if (journal.isOpen() && journal.lastLsn() > journalBase) {
+        journal.sync();
+        std::printf("Journal: %llu records up to LSN %llu in %llu group commits, %.2f KiB written",
+                    static_cast<unsigned long long>(journal.lastLsn() - journalBase),
+                    static_cast<unsigned long long>(journal.lastLsn()),
+                    static_cast<unsigned long long>(journal.groupCommits()), journal.bytesWritten() / 1024.0);
+        if (checkpoints) std::printf("; %u checkpoints in %.3f s", checkpoints, checkpointSeconds);
+        std::printf("\n");
+    } else if (checkpoints) {
+        std::printf("Checkpoint written to %s in %.3f s\n", checkpointPath.c_str(), checkpointSeconds);
+    }
+
+    MprSelector mpr;
+    if (withMpr) {
+        mpr.computeAll(g);
+        FloodingStats fs = mpr.floodingStats();
+        std::cout << "MPR flooding: " << fs.mprForwards << " forwards vs " << fs.pureForwards
+                  << " with pure flooding (" << 100.0 * fs.reduction() << "% fewer)\n";
+    }
+
+    if (simMs > 0.0) {
+        OlsrSimulator sim(simParams);
+        sim.reset(g);
+        auto start = std::chrono::steady_clock::now();
+        sim.runUntil(simMs);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const OlsrSimStats& st = sim.stats();
+        std::cout << "Simulated " << simMs << " ms: " << st.events << " events in " << wall << " s ("
+                  << (wall > 0.0 ? st.events / wall : 0.0) << " events/s)\n"
+                  << "  hello=" << st.helloSent << " tc_originated=" << st.tcOriginated
+                  << " tc_forwarded=" << st.tcForwarded << " tc_received=" << st.tcReceived
+                  << " duplicates=" << st.tcDuplicates << " dropped=" << st.dropped << "\n"
+                  << "  lsdb_updates=" << st.lsdbUpdates << " spf_runs=" << st.spfRuns
+                  << " last_lsdb_update_ms=" << st.lastLsdbUpdateMs
+                  << " converged=" << (sim.lsdbConverged() ? "yes" : "no") << "\n";
+    }
+
+    LinkLoadEngine loads;
+    if (!trafficPath.empty()) {
+        TrafficMatrix tm;
+        JsonImporter imp;
+        std::string err;
+        if (!imp.loadTraffic(trafficPath, tm, &err)) {
+            std::cerr << "Error loading traffic: " << err << "\n";
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        loads.compute(g, tm);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Link loads for " << tm.demands.size() << " demands in " << wall << " s: max_load="
+                  << loads.maxLoad() << " max_utilization=" << loads.maxUtilization()
+                  << " unroutable=" << loads.unroutable() << "\n";
+
+        if (teIterations > 0) {
+            TeParams tp;
+            tp.maxIterations = teIterations;
+            TrafficEngineer te(tp);
+            TeResult res = te.run(g, tm);
+            for (size_t k = 0; k < res.iterations.size(); ++k) {
+                const TeIteration& it = res.iterations[k];
+                std::cout << "  te iteration " << k << ": max_utilization=" << it.maxUtilization
+                          << " changed_links=" << it.changedLinks << " changed_trees=" << it.changedTrees
+                          << " wall_ms=" << it.wallMs << "\n";
+            }
+            std::cout << "TE " << (res.converged ? "converged" : "stopped") << " after "
+                      << res.iterations.size() - 1 << " iterations; keeping iteration " << res.bestIteration
+                      << " (max_utilization=" << res.iterations[res.bestIteration].maxUtilization << ")\n";
+            router.recomputeAll(g);
+            loads.compute(g, tm);
+        }
+    }
+
+    if (!replayPath.empty()) {
+        TraceReplayer replay(g, router, replayParams);
+        std::string err;
+        if (!replay.run(replayPath, &err)) {
+            std::cerr << "Error replaying trace: " << err << "\n";
+            return 1;
+        }
+        const ReplayStats& st = replay.stats();
+        std::cout << "Replayed " << st.events << " events (" << st.virtualMs << " virtual ms) in " << st.wallS
+                  << " s (" << st.eventsPerSecond() << " events/s)\n"
+                  << "  skipped=" << st.skipped << " malformed=" << st.malformed << " steps=" << st.steps
+                  << " recomputes=" << st.recomputes << " route_changes=" << st.routeChanges << "\n"
+                  << "  status_flips=" << st.statusFlips << " flap_rate=" << st.flapRate(g.links().size())
+                  << "/link/h recompute_us p50=" << st.latencyP50Us << " p99=" << st.latencyP99Us
+                  << " max=" << st.latencyMaxUs << "\n";
+    }
+
+    if (sweepRuns > 0) {
+        HysteresisSweep sweep(jitter);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SweepResult> results = sweep.run(g, sweepGrid, sweepRuns);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Hysteresis sweep: " << results.size() << " sets x " << sweepRuns << " runs in " << wall
+                  << " s (" << sweep.runStateBytes(g) << " bytes of state per run)\n"
+                  << "     alpha  theta_up theta_dn   hold_ms    flaps spurious   routes   faults   missed  conv_ms   max_ms\n";
+        for (const SweepResult& r : results) {
+            char line[192];
+            std::snprintf(line, sizeof(line), "%c %8.3f %9.3f %8.3f %9.0f %8.1f %8.1f %8.1f %8.1f %8.1f %8.0f %8.0f\n",
+                          r.pareto ? '*' : ' ', r.params.alpha, r.params.thetaUp, r.params.thetaDown,
+                          r.params.holdMs, r.flapsPerRun, r.spuriousPerRun, r.routeChangesPerRun, r.faultsPerRun,
+                          r.missedPerRun, r.meanConvergenceMs, r.maxConvergenceMs);
+            std::cout << line;
+        }
+        std::cout << "(* = no other set has both fewer flaps and faster convergence)\n";
+    }
+
+    PathBatch paths;
+    if (kPaths > 0) {
+        paths.mode = pathMode;
+        paths.k = kPaths;
+        paths.queries = parsePairs(pathPairs.empty() ? "random:100" : pathPairs, g);
+        auto start = std::chrono::steady_clock::now();
+        KShortestPaths().compute(g, paths);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t found = 0;
+        for (const auto& p : paths.paths) found += p.size();
+        std::printf("%s paths, k=%u: %zu pairs, %zu paths in %.3f s (%.3f ms per pair)\n",
+                    pathMode == PathMode::EdgeDisjoint ? "Edge-disjoint" : "Loopless", kPaths,
+                    paths.queries.size(), found, wall,
+                    paths.queries.empty() ? 0.0 : 1e3 * wall / paths.queries.size());
+        if (exportPath.empty() && !paths.queries.empty()) {
+            std::cout << "Paths from " << paths.queries.front().src << " to " << paths.queries.front().dst << ":\n";
+            for (const KPath& p : paths.paths.front()) {
+                std::cout << "  cost=" << p.cost << " hops=" << p.hops() << " via";
+                for (NodeId v : p.nodes) std::cout << ' ' << v;
+                std::cout << "\n";
+            }
+        }
+    }
+
+    if ((!publishName.empty() || shmStressSeconds > 0.0) && hierarchical) {
+        std::cerr << "--publish ignored: hierarchical routing keeps no flat tables\n";
+    } else if (!publishName.empty() || shmStressSeconds > 0.0) {
+        const std::string name = publishName.empty() ? "olsr_lite_routes" : publishName;
+        RoutePublisher pub(name);
+        std::string err;
+        auto start = std::chrono::steady_clock::now();
+        if (!pub.publish(g, router, &err)) {
+            std::cerr << "Publish failed: " << err << "\n";
+            return 2;
+        }
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("Published generation %llu to %s: %zu nodes, %.2f MiB segment, %.3f s\n",
+                    static_cast<unsigned long long>(pub.generation()), routeSegmentPath(name).c_str(),
+                    g.nodes().size(), pub.bytes() / (1024.0 * 1024.0), wall);
+        if (shmStressSeconds > 0.0) {
+            const int rc = runShmStress(g, router, pub, name, shmStressSeconds, shmReaders);
+            if (publishName.empty()) RoutePublisher::remove(name);
+            if (rc != 0) return rc;
+        }
+    }
+
+    if (!hierarchical) {
+        if (const size_t saturated = router.saturatedRoutes()) {
+            std::cerr << saturated << " routes cost " << kCostLimit
+                      << " or more: their totals are past the cost grid and compare as equal\n";
+        }
+    }
+
+    if (!packedPath.empty()) {
+        std::string err;
+        if (!RouteArchive::write(g, router, packedPath, &err)) {
+            std::cerr << "Packed export failed: " << err << "\n";
+            return 2;
+        }
+        std::cout << "Exported packed routes to " << packedPath << "\n";
+    }
 
     if (!exportPath.empty()) {
         JsonExporter exp;
+        if (withMpr) exp.attachMpr(&mpr);
+        if (!trafficPath.empty()) exp.attachLoads(&loads);
+        if (hierarchical) exp.attachHierarchy(&hier);
+        if (kPaths > 0) exp.attachPaths(&paths);
+        if (planeTables) exp.attachPlanes(&planes, plane);
         if (!exp.exportRoutes(g, router, exportPath)) {
             std::cerr << "Export failed: " << exportPath << "\n";
             return 2;
         }
         std::cout << "Exported routes to " << exportPath << "\n";
     } else {
-        // Print routing table for node 1 if exists
+        // Print routing table for node 1 if exists (the lowest id, whatever
+        // the storage order)
         if (!g.nodes().empty()) {
-            NodeId src = g.nodes().front().id;
-            auto tbl = router.table(src);
+            NodeId src = std::min_element(g.nodes().begin(), g.nodes().end(), [](const Node& a, const Node& b) {
+                return a.id < b.id;
+            })->id;
+            RouteTable composed;
+            if (hierarchical) composed = hier.table(src);
+            auto tbl = hierarchical ? &composed : planeTables ? planes.table(plane, src) : router.table(src);
             if (tbl) {
                 std::cout << "Routes from node " << src << ":\n";
                 for (const auto& e : *tbl) {
@@ -69,6 +1014,17 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (!traceOutPath.empty() && metrics::enabled()) {
+        metrics::stopTrace();
+        std::string err;
+        if (!metrics::writeChromeTrace(traceOutPath, &err)) {
+            std::cerr << err << "\n";
+            return 2;
+        }
+        std::cout << "Wrote " << metrics::traceEventCount() << " trace events to " << traceOutPath << "\n";
+    }
+    if (showMetrics) printMetrics();
+
     return 0;
 }
 
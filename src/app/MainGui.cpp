@@ -1,5 +1,7 @@
 #include "core/Graph.h"
 #include "route/Router.h"
+#include "io/ChangeJournal.h"
+#include "io/Checkpoint.h"
 #include "io/JsonImporter.h"
 #include "ui/UiOverlay.h"
 
@@ -9,6 +11,8 @@
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 
 using namespace olsr;
@@ -17,14 +21,66 @@ static void glfwErrorCallback(int error, const char* desc) {
     std::cerr << "GLFW Error " << error << ": " << desc << "\n";
 }
 
+// Warm restart as in the CLI: the checkpoint, then the journal records after
+// it in one transaction. Sets lsn to the position reached; false on failure.
+static bool recoverState(const std::string& checkpointPath, const std::string& journalPath, Graph& g, Router& router,
+                         uint64_t& lsn) {
+    CheckpointInfo info;
+    std::string err;
+    if (!Checkpoint::read(checkpointPath, g, &router, &info, &err)) {
+        std::cerr << "Error reading checkpoint: " << err << "\n";
+        return false;
+    }
+    router.setPolicy(info.policy);
+    JournalReplayStats js;
+    std::error_code ec;
+    g.begin();
+    if (!journalPath.empty() && std::filesystem::exists(journalPath, ec) &&
+        !ChangeJournal::replay(journalPath, info.lsn, g, nullptr, &js, &err)) {
+        std::cerr << "Error replaying journal: " << err << "\n";
+        return false;
+    }
+    const GraphChangeLog log = g.commit();
+    if (info.routes > 0) router.applyChanges(g, log);
+    else router.recomputeAll(g);
+    lsn = std::max(info.lsn, js.lastLsn);
+    return true;
+}
+
 int run_gui(int argc, char** argv) {
     std::string topoPath;
+    std::string journalPath;
+    std::string checkpointPath;
+    std::string recoverPath;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--topo" && i + 1 < argc) topoPath = argv[++i];
+        if (arg == "--journal" && i + 1 < argc) journalPath = argv[++i];
+        if (arg == "--checkpoint" && i + 1 < argc) checkpointPath = argv[++i];
+        if (arg == "--recover" && i + 1 < argc) recoverPath = argv[++i];
         if (arg == "--no-gui") return 0; // if explicitly disabled, just skip
     }
 
+    Graph g;
+    Router router;
+    uint64_t lsn = 0;
+    if (!recoverPath.empty() && !recoverState(recoverPath, journalPath, g, router, lsn)) return 1;
+    // Every edit made in the window is journaled; a cold start begins a new log.
+    ChangeJournal journal;
+    if (!journalPath.empty()) {
+        std::string err;
+        std::error_code ec;
+        if (recoverPath.empty() && std::filesystem::file_size(journalPath, ec) > 0 && !ec) {
+            std::cerr << "Journal " << journalPath << " restarted: without --recover its records do not apply\n";
+        }
+        const bool opened = recoverPath.empty() ? journal.create(journalPath, 0, &err)
+                                                : journal.open(journalPath, lsn, &err);
+        if (!opened) {
+            std::cerr << "Error opening journal: " << err << "\n";
+            return 1;
+        }
+    }
+
     glfwSetErrorCallback(glfwErrorCallback);
     if (!glfwInit()) return 1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -47,19 +103,32 @@ int run_gui(int argc, char** argv) {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
 
-    Graph g;
-    if (!topoPath.empty()) {
+    if (recoverPath.empty() && !topoPath.empty()) {
         JsonImporter imp; std::string err;
         if (!imp.loadTopology(topoPath, g, &err)) {
             std::cerr << "Error loading topology: " << err << "\n";
+        } else {
+            // The topology says what its weights mean.
+            RoutePolicy policy = RoutePolicy::Shortest;
+            parseRoutePolicy(imp.policy(), policy);
+            router.setPolicy(policy);
+            if (imp.heavyLinks() && policy != RoutePolicy::Reliable) {
+                std::cerr << imp.heavyLinks() << " links weigh " << kCostLimit
+                          << " or more: the cost grid ends there, so paths over them compare as equal\n";
+            }
         }
-    } else {
+    } else if (recoverPath.empty()) {
         auto n1 = g.addNode("R1", 200, 200);
         auto n2 = g.addNode("R2", 400, 200);
         g.addLink(n1, n2, 1.0);
     }
-    Router router; router.recomputeAll(g);
+    if (recoverPath.empty()) router.recomputeAll(g);
+    if (const size_t saturated = router.saturatedRoutes()) {
+        std::cerr << saturated << " routes cost " << kCostLimit
+                  << " or more: their totals are past the cost grid and compare as equal\n";
+    }
     UiOverlay ui(g, router);
+    ui.attachJournal(&journal);
 
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
@@ -96,6 +165,17 @@ int run_gui(int argc, char** argv) {
         glfwSwapBuffers(window);
     }
 
+    if (!checkpointPath.empty()) {
+        std::string err;
+        const uint64_t at = journal.isOpen() ? journal.lastLsn() : lsn;
+        if (!Checkpoint::write(g, ui.routesCurrent() ? &router : nullptr, router.policy(), at, checkpointPath,
+                               &err)) {
+            std::cerr << "Checkpoint failed: " << err << "\n";
+        } else if (journal.isOpen() && !journal.truncate()) {
+            std::cerr << "Journal truncation failed\n";
+        }
+    }
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
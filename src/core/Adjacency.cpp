@@ -0,0 +1,71 @@
+#include "core/Adjacency.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace olsr {
+
+Adjacency Adjacency::build(const Graph& g) {
+    Adjacency a;
+    a.assign(g);
+    return a;
+}
+
+void Adjacency::assign(const Graph& g) {
+    Adjacency& a = *this;
+    const auto& nodes = g.nodes();
+    const auto& links = g.links();
+    const uint32_t n = static_cast<uint32_t>(nodes.size());
+    // The id index is only rebuilt when the node set changed; rebuilding it
+    // costs one hash node allocation per vertex.
+    bool sameNodes = a.ids.size() == n && a.index.size() == n;
+    for (uint32_t i = 0; sameNodes && i < n; ++i) sameNodes = a.ids[i] == nodes[i].id;
+    if (!sameNodes) {
+        a.ids.clear();
+        a.index.clear();
+        a.ids.reserve(n);
+        a.index.reserve(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            a.ids.push_back(nodes[i].id);
+            a.index.emplace(nodes[i].id, i);
+        }
+        // Tables list destinations by id; walking byId spares reordered
+        // graphs a sort per table.
+        a.byId.resize(n);
+        std::iota(a.byId.begin(), a.byId.end(), 0u);
+        std::sort(a.byId.begin(), a.byId.end(), [&](uint32_t x, uint32_t y) { return a.ids[x] < a.ids[y]; });
+    }
+
+    // Two passes: count degrees, then scatter half-edges in link order so that
+    // neighbor order matches the order DijkstraEngine scans Graph::links().
+    a.offsets.assign(n + 1, 0);
+    std::vector<std::pair<uint32_t, uint32_t>> ends(links.size(), {n, n});
+    for (size_t li = 0; li < links.size(); ++li) {
+        const Link& l = links[li];
+        if (l.status != LinkStatus::UP) continue;
+        auto iu = a.index.find(l.u);
+        auto iv = a.index.find(l.v);
+        if (iu == a.index.end() || iv == a.index.end()) continue;
+        ends[li] = {iu->second, iv->second};
+        ++a.offsets[iu->second + 1];
+        ++a.offsets[iv->second + 1];
+    }
+    for (uint32_t i = 0; i < n; ++i) a.offsets[i + 1] += a.offsets[i];
+
+    const size_t m = a.offsets[n];
+    a.targets.resize(m);
+    a.weights.resize(m);
+    a.linkIndex.resize(m);
+    std::vector<uint32_t> fill(a.offsets.begin(), a.offsets.end() - 1);
+    for (size_t li = 0; li < links.size(); ++li) {
+        auto [u, v] = ends[li];
+        if (u == n) continue;
+        const double w = links[li].weight;
+        uint32_t pu = fill[u]++;
+        a.targets[pu] = v; a.weights[pu] = w; a.linkIndex[pu] = static_cast<uint32_t>(li);
+        uint32_t pv = fill[v]++;
+        a.targets[pv] = u; a.weights[pv] = w; a.linkIndex[pv] = static_cast<uint32_t>(li);
+    }
+}
+
+} // namespace olsr
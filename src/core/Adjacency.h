@@ -0,0 +1,30 @@
+#pragma once
+
+#include "core/Graph.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace olsr {
+
+// Dense CSR snapshot of the UP links of a Graph. Nodes are addressed by their
+// position in Graph::nodes(); ids maps back to the external NodeId.
+struct Adjacency {
+    std::vector<NodeId> ids;                      // index -> NodeId
+    std::unordered_map<NodeId, uint32_t> index;   // NodeId -> index
+    std::vector<uint32_t> byId;                   // indices in NodeId order; route tables follow it
+    std::vector<uint32_t> offsets;                // row offsets, size() + 1 entries
+    std::vector<uint32_t> targets;                // neighbor index per half-edge
+    std::vector<double> weights;                  // weight per half-edge
+    std::vector<uint32_t> linkIndex;              // position in Graph::links() per half-edge
+
+    static Adjacency build(const Graph& g);
+    // Rebuilds in place, reusing the existing buffers.
+    void assign(const Graph& g);
+
+    uint32_t size() const { return static_cast<uint32_t>(ids.size()); }
+    uint32_t degree(uint32_t i) const { return offsets[i + 1] - offsets[i]; }
+    size_t halfEdges() const { return targets.size(); }
+};
+
+} // namespace olsr
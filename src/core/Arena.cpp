@@ -0,0 +1,65 @@
+#include "core/Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace olsr {
+
+Arena::Arena(size_t initialBlock) : nextBlock_(std::max<size_t>(initialBlock, 256)) {}
+
+Arena::~Arena() {
+    for (const Block& b : blocks_) ::operator delete(b.data);
+}
+
+void Arena::addBlock(size_t minBytes) {
+    const size_t size = std::max(nextBlock_, minBytes);
+    Block b{static_cast<char*>(::operator new(size)), size};
+    blocks_.push_back(b);
+    ++blockAllocs_;
+    reserved_ += size;
+    cur_ = b.data;
+    end_ = b.data + size;
+    nextBlock_ = size * 2;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t align) {
+    auto aligned = [&] {
+        const uintptr_t p = reinterpret_cast<uintptr_t>(cur_);
+        return reinterpret_cast<char*>((p + align - 1) & ~(uintptr_t(align) - 1));
+    };
+    char* p = cur_ ? aligned() : nullptr;
+    if (!p || p + bytes > end_) {
+        addBlock(bytes + align);
+        p = aligned();
+    }
+    cur_ = p + bytes;
+    used_ += bytes;
+    return p;
+}
+
+void Arena::reset() {
+    if (blocks_.size() > 1) {
+        // Room for what the generation used, plus slack for alignment and growth.
+        const size_t want = used_ + used_ / 8 + 4096;
+        for (const Block& b : blocks_) ::operator delete(b.data);
+        blocks_.clear();
+        reserved_ = 0;
+        nextBlock_ = want;
+        addBlock(want);
+    } else if (!blocks_.empty()) {
+        cur_ = blocks_.front().data;
+        end_ = cur_ + blocks_.front().size;
+    }
+    used_ = 0;
+}
+
+void Arena::release() {
+    for (const Block& b : blocks_) ::operator delete(b.data);
+    blocks_.clear();
+    cur_ = end_ = nullptr;
+    reserved_ = 0;
+    used_ = 0;
+}
+
+} // namespace olsr
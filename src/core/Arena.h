@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace olsr {
+
+// Monotonic memory resource for data that lives exactly one generation, e.g.
+// the route tables of one recomputeAll. Deallocation is a no-op; reset()
+// retires everything at once. After a generation that needed several blocks,
+// reset() replaces them with a single block of the size it used, so a steady
+// workload settles into one allocation per arena lifetime. Not thread-safe.
+class Arena : public std::pmr::memory_resource {
+public:
+    explicit Arena(size_t initialBlock = 64 * 1024);
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Invalidates every pointer handed out since the last reset.
+    void reset();
+    // Like reset(), but returns every block to the heap.
+    void release();
+
+    size_t bytesUsed() const { return used_; }       // current generation
+    size_t bytesReserved() const { return reserved_; }
+    size_t blockCount() const { return blocks_.size(); }
+    size_t blockAllocations() const { return blockAllocs_; } // lifetime total
+
+private:
+    void* do_allocate(size_t bytes, size_t align) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void addBlock(size_t minBytes);
+
+    struct Block {
+        char* data;
+        size_t size;
+    };
+    std::vector<Block> blocks_;
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+    size_t nextBlock_;
+    size_t used_ = 0;
+    size_t reserved_ = 0;
+    size_t blockAllocs_ = 0;
+};
+
+} // namespace olsr
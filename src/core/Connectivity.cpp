@@ -0,0 +1,124 @@
+#include "core/Connectivity.h"
+
+#include "core/Graph.h"
+#include "core/Metrics.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace olsr {
+
+static uint64_t linkKey(NodeId a, NodeId b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+void Connectivity::rebuild(const Graph& g) {
+    OLSR_COUNT(ConnectivityRebuilds, 1);
+    NodeId maxId = 0;
+    for (const Node& n : g.nodes()) maxId = std::max(maxId, n.id);
+    parent_.assign(static_cast<size_t>(maxId) + 1, kAbsent);
+    size_.assign(parent_.size(), 1);
+    forestDegree_.assign(parent_.size(), 0);
+    forest_.clear();
+    count_ = 0;
+    for (const Node& n : g.nodes()) {
+        if (parent_[n.id] != kAbsent) continue;
+        parent_[n.id] = n.id;
+        ++count_;
+    }
+    for (const Link& l : g.links()) {
+        if (l.status == LinkStatus::UP && known(l.u) && known(l.v)) unite(l.u, l.v);
+    }
+    // Flatten so every later lookup starts one step from its root.
+    for (size_t i = 0; i < parent_.size(); ++i) {
+        if (parent_[i] != kAbsent) parent_[i] = find(static_cast<NodeId>(i));
+    }
+    stale_ = false;
+    ++rebuilds_;
+}
+
+NodeId Connectivity::find(NodeId id) const {
+    while (parent_[id] != id) id = parent_[id];
+    return id;
+}
+
+void Connectivity::unite(NodeId u, NodeId v) {
+    NodeId a = find(u), b = find(v);
+    if (a == b) return;
+    if (size_[a] < size_[b]) std::swap(a, b);
+    parent_[b] = a;
+    size_[a] += size_[b];
+    forest_.insert(linkKey(u, v));
+    ++forestDegree_[u];
+    ++forestDegree_[v];
+    --count_;
+}
+
+void Connectivity::linkUp(NodeId u, NodeId v) {
+    if (stale_ || !known(u) || !known(v)) return;
+    unite(u, v);
+}
+
+void Connectivity::linkDown(NodeId u, NodeId v) {
+    if (stale_) return;
+    if (forest_.count(linkKey(u, v))) stale_ = true;
+}
+
+void Connectivity::nodeAdded(NodeId id) {
+    if (stale_) return;
+    if (id >= parent_.size()) {
+        parent_.resize(static_cast<size_t>(id) + 1, kAbsent);
+        size_.resize(parent_.size(), 1);
+        forestDegree_.resize(parent_.size(), 0);
+    }
+    if (parent_[id] != kAbsent) {
+        stale_ = true;
+        return;
+    }
+    parent_[id] = id;
+    size_[id] = 1;
+    ++count_;
+}
+
+void Connectivity::nodeRemoved(NodeId id) {
+    if (stale_ || !known(id)) return;
+    // A node in a larger component carries at least one forest link.
+    if (forestDegree_[id] != 0 || parent_[id] != id) {
+        stale_ = true;
+        return;
+    }
+    parent_[id] = kAbsent;
+    --count_;
+}
+
+bool Connectivity::connected(NodeId u, NodeId v) const {
+    return known(u) && known(v) && find(u) == find(v);
+}
+
+NodeId Connectivity::component(NodeId id) const {
+    return known(id) ? find(id) : 0;
+}
+
+uint32_t Connectivity::componentSize(NodeId id) const {
+    return known(id) ? size_[find(id)] : 0;
+}
+
+std::vector<std::vector<NodeId>> Connectivity::components() const {
+    std::vector<std::vector<NodeId>> out;
+    std::unordered_map<NodeId, uint32_t> slot;
+    slot.reserve(count_);
+    for (size_t i = 0; i < parent_.size(); ++i) {
+        if (parent_[i] == kAbsent) continue;
+        const NodeId id = static_cast<NodeId>(i);
+        auto [it, inserted] = slot.try_emplace(find(id), static_cast<uint32_t>(out.size()));
+        if (inserted) out.emplace_back();
+        out[it->second].push_back(id);
+    }
+    std::sort(out.begin(), out.end(), [](const std::vector<NodeId>& a, const std::vector<NodeId>& b) {
+        return a.size() != b.size() ? a.size() > b.size() : a.front() < b.front();
+    });
+    return out;
+}
+
+} // namespace olsr
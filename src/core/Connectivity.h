@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace olsr {
+
+class Graph;
+using NodeId = uint32_t;
+
+// Connected components of the UP links. A union-find (union by size, so a
+// lookup walks O(log n) parents) absorbs links coming up and nodes being
+// added incrementally, and a spanning forest is kept alongside it: losing a
+// link outside the forest cannot split anything and is ignored, losing a
+// forest link (or a node carrying one) marks the structure stale and the next
+// query rebuilds it from the graph in O(N + E). Graph owns one of these and
+// feeds it from its mutators; use Graph::connectivity() rather than calling
+// the update hooks directly.
+class Connectivity {
+public:
+    void rebuild(const Graph& g);
+    void invalidate() { stale_ = true; }
+    bool stale() const { return stale_; }
+
+    // Update hooks; no-ops while stale.
+    void linkUp(NodeId u, NodeId v);
+    void linkDown(NodeId u, NodeId v);
+    void nodeAdded(NodeId id);
+    void nodeRemoved(NodeId id);
+
+    // Queries assume !stale(). Unknown ids are in no component.
+    bool connected(NodeId u, NodeId v) const;
+    // Representative node of id's component, 0 for unknown ids.
+    NodeId component(NodeId id) const;
+    uint32_t componentSize(NodeId id) const;
+    uint32_t componentCount() const { return count_; }
+    bool partitioned() const { return count_ > 1; }
+    // Members of every component, largest first, ties by smallest member;
+    // each list is ascending.
+    std::vector<std::vector<NodeId>> components() const;
+
+    uint64_t rebuilds() const { return rebuilds_; }
+
+private:
+    static constexpr uint32_t kAbsent = UINT32_MAX;
+
+    bool known(NodeId id) const { return id < parent_.size() && parent_[id] != kAbsent; }
+    NodeId find(NodeId id) const;
+    void unite(NodeId u, NodeId v);
+
+    std::vector<uint32_t> parent_;       // indexed by NodeId; kAbsent if no such node
+    std::vector<uint32_t> size_;         // component size, valid at roots
+    std::vector<uint32_t> forestDegree_; // forest links per node
+    std::unordered_set<uint64_t> forest_;
+    uint32_t count_ = 0;
+    bool stale_ = true;
+    uint64_t rebuilds_ = 0;
+};
+
+} // namespace olsr
@@ -1,6 +1,7 @@
 #include "core/Graph.h"
 
 #include <algorithm>
+#include <unordered_set>
 
 namespace olsr {
 
@@ -8,21 +9,45 @@ static bool sameUndirected(NodeId a, NodeId b, NodeId c, NodeId d) {
     return (a == c && b == d) || (a == d && b == c);
 }
 
+static uint64_t linkKey(NodeId a, NodeId b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
 NodeId Graph::addNode(std::string label, float x, float y) {
     NodeId newId = static_cast<NodeId>(nodes_.size() + 1);
     nodes_.push_back(Node{newId, std::move(label), x, y, true});
+    conn_.nodeAdded(newId);
+    if (txnActive_) {
+        txn_.addedNodes.push_back(newId);
+        ++txn_.operations;
+    }
     return newId;
 }
 
 bool Graph::removeNode(NodeId id) {
-    auto it = std::remove_if(links_.begin(), links_.end(), [id](const Link& l){
-        return l.u == id || l.v == id;
+    if (txnActive_) {
+        for (const Link& l : links_) {
+            if (l.u != id && l.v != id) continue;
+            recordLinkBefore(l.u, l.v, &l);
+            recordLinkAfter(l.u, l.v, nullptr, false); // part of this one operation
+        }
+    }
+    auto it = std::remove_if(links_.begin(), links_.end(), [this, id](const Link& l){
+        if (l.u != id && l.v != id) return false;
+        if (l.status == LinkStatus::UP) conn_.linkDown(l.u, l.v);
+        return true;
     });
     links_.erase(it, links_.end());
 
     auto nit = std::remove_if(nodes_.begin(), nodes_.end(), [id](const Node& n){ return n.id == id; });
     if (nit == nodes_.end()) return false;
     nodes_.erase(nit, nodes_.end());
+    conn_.nodeRemoved(id);
+    if (txnActive_) {
+        txn_.removedNodes.push_back(id);
+        ++txn_.operations;
+    }
     return true;
 }
 
@@ -32,15 +57,31 @@ bool Graph::addLink(NodeId u, NodeId v, double weight) {
     for (const auto& l : links_) {
         if (sameUndirected(l.u, l.v, u, v)) return false; // prevent duplicates
     }
+    recordLinkBefore(u, v, nullptr);
     links_.push_back(Link{u, v, weight, weight, LinkStatus::UP, false});
+    links_.back().metrics.fill(weight);
+    conn_.linkUp(u, v);
+    recordLinkAfter(u, v, &links_.back());
     return true;
 }
 
+bool Graph::removeLink(NodeId u, NodeId v) {
+    for (auto it = links_.begin(); it != links_.end(); ++it) {
+        if (sameUndirected(it->u, it->v, u, v)) {
+            recordLinkBefore(u, v, &*it);
+            if (it->status == LinkStatus::UP) conn_.linkDown(u, v);
+            links_.erase(it);
+            recordLinkAfter(u, v, nullptr);
+            return true;
+        }
+    }
+    return false;
+}
+
 bool Graph::setLinkStatus(NodeId u, NodeId v, LinkStatus st) {
     for (auto& l : links_) {
         if (sameUndirected(l.u, l.v, u, v)) {
-            l.status = st;
-            l.manually_jammed = (st == LinkStatus::DOWN);
+            setStatus(l, st);
             return true;
         }
     }
@@ -50,14 +91,184 @@ bool Graph::setLinkStatus(NodeId u, NodeId v, LinkStatus st) {
 bool Graph::setLinkWeight(NodeId u, NodeId v, double w) {
     for (auto& l : links_) {
         if (sameUndirected(l.u, l.v, u, v)) {
-            l.weight = w;
-            if (!l.jammed) l.orig_weight = w;
+            setWeight(l, w);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Graph::setStatus(Link& l, LinkStatus st) {
+    recordLinkBefore(l.u, l.v, &l);
+    if (l.status != st) {
+        if (st == LinkStatus::UP) conn_.linkUp(l.u, l.v);
+        else conn_.linkDown(l.u, l.v);
+    }
+    l.status = st;
+    l.manually_jammed = (st == LinkStatus::DOWN);
+    recordLinkAfter(l.u, l.v, &l);
+}
+
+void Graph::setWeight(Link& l, double w) {
+    recordLinkBefore(l.u, l.v, &l);
+    l.weight = w;
+    if (!l.jammed) l.orig_weight = w;
+    recordLinkAfter(l.u, l.v, &l);
+}
+
+int Graph::addPlane(const std::string& name) {
+    const int existing = planeIndex(name);
+    if (existing >= 0) return existing;
+    if (planes_.size() >= kMaxMetricPlanes) return -1;
+    planes_.push_back(name);
+    const uint32_t p = static_cast<uint32_t>(planes_.size() - 1);
+    for (Link& l : links_) l.metrics[p - 1] = l.weight;
+    return static_cast<int>(p);
+}
+
+int Graph::planeIndex(const std::string& name) const {
+    for (size_t i = 0; i < planes_.size(); ++i) {
+        if (planes_[i] == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool Graph::setLinkMetric(NodeId u, NodeId v, uint32_t plane, double w) {
+    if (plane == 0) return setLinkWeight(u, v, w);
+    if (plane >= planes_.size()) return false;
+    for (auto& l : links_) {
+        if (sameUndirected(l.u, l.v, u, v)) {
+            l.metrics[plane - 1] = w;
             return true;
         }
     }
     return false;
 }
 
+bool Graph::apply(const GraphEdit& e) {
+    switch (e.op) {
+    case GraphEdit::Op::SetWeight: return setLinkWeight(e.u, e.v, e.weight);
+    case GraphEdit::Op::SetStatus: return setLinkStatus(e.u, e.v, e.status);
+    case GraphEdit::Op::AddLink: return addLink(e.u, e.v, e.weight);
+    case GraphEdit::Op::RemoveLink: return removeLink(e.u, e.v);
+    case GraphEdit::Op::AddNode: addNode(e.label, e.x, e.y); return true;
+    case GraphEdit::Op::RemoveNode: return removeNode(e.u);
+    }
+    return false;
+}
+
+size_t Graph::applyBatch(const std::vector<GraphEdit>& edits) {
+    std::unordered_map<uint64_t, uint32_t> index; // live links by key
+    std::unordered_set<NodeId> ids;
+    std::vector<uint8_t> dead;                     // removed, compacted at the end
+    bool indexed = false;
+    auto compact = [&] {
+        if (!indexed) return;
+        size_t kept = 0;
+        for (size_t i = 0; i < links_.size(); ++i) {
+            if (dead[i]) continue;
+            if (kept != i) links_[kept] = std::move(links_[i]);
+            ++kept;
+        }
+        links_.resize(kept);
+        index.clear();
+        ids.clear();
+        dead.clear();
+        indexed = false;
+    };
+
+    size_t applied = 0;
+    for (const GraphEdit& e : edits) {
+        if (e.op == GraphEdit::Op::AddNode || e.op == GraphEdit::Op::RemoveNode) {
+            compact();
+            applied += apply(e);
+            continue;
+        }
+        if (!indexed) {
+            index.reserve(links_.size() + edits.size());
+            for (uint32_t i = 0; i < links_.size(); ++i) index.emplace(linkKey(links_[i].u, links_[i].v), i);
+            ids.reserve(nodes_.size());
+            for (const Node& n : nodes_) ids.insert(n.id);
+            dead.assign(links_.size(), 0);
+            indexed = true;
+        }
+        const uint64_t key = linkKey(e.u, e.v);
+        auto it = index.find(key);
+        if (e.op == GraphEdit::Op::AddLink) {
+            if (it != index.end() || e.u == e.v || !ids.count(e.u) || !ids.count(e.v)) continue;
+            recordLinkBefore(e.u, e.v, nullptr);
+            links_.push_back(Link{e.u, e.v, e.weight, e.weight, LinkStatus::UP, false});
+            links_.back().metrics.fill(e.weight);
+            dead.push_back(0);
+            index.emplace(key, static_cast<uint32_t>(links_.size() - 1));
+            conn_.linkUp(e.u, e.v);
+            recordLinkAfter(e.u, e.v, &links_.back());
+            ++applied;
+            continue;
+        }
+        if (it == index.end()) continue;
+        Link& l = links_[it->second];
+        if (e.op == GraphEdit::Op::RemoveLink) {
+            recordLinkBefore(e.u, e.v, &l);
+            if (l.status == LinkStatus::UP) conn_.linkDown(l.u, l.v);
+            dead[it->second] = 1;
+            index.erase(it);
+            recordLinkAfter(e.u, e.v, nullptr);
+        } else if (e.op == GraphEdit::Op::SetWeight) {
+            setWeight(l, e.weight);
+        } else {
+            setStatus(l, e.status);
+        }
+        ++applied;
+    }
+    compact();
+    return applied;
+}
+
+void Graph::begin() {
+    if (txnActive_) return;
+    txnActive_ = true;
+    txn_ = GraphChangeLog{};
+    txnIndex_.clear();
+}
+
+GraphChangeLog Graph::commit() {
+    if (!txnActive_) return {};
+    txnActive_ = false;
+    txnIndex_.clear();
+    auto& links = txn_.links;
+    links.erase(std::remove_if(links.begin(), links.end(), [](const LinkChange& c) {
+        return c.existedBefore == c.existsAfter &&
+               (!c.existsAfter || (c.oldWeight == c.newWeight && c.oldStatus == c.newStatus));
+    }), links.end());
+    return std::move(txn_);
+}
+
+void Graph::recordLinkBefore(NodeId u, NodeId v, const Link* l) {
+    if (!txnActive_) return;
+    auto [it, inserted] = txnIndex_.try_emplace(linkKey(u, v), static_cast<uint32_t>(txn_.links.size()));
+    if (!inserted) return; // keep the state from before the first edit
+    LinkChange c{u, v, l != nullptr, l != nullptr, 0.0, 0.0, LinkStatus::UP, LinkStatus::UP};
+    if (l) {
+        c.u = l->u;
+        c.v = l->v;
+        c.oldWeight = c.newWeight = l->weight;
+        c.oldStatus = c.newStatus = l->status;
+    }
+    txn_.links.push_back(c);
+}
+
+void Graph::recordLinkAfter(NodeId u, NodeId v, const Link* l, bool countOp) {
+    if (!txnActive_) return;
+    LinkChange& c = txn_.links[txnIndex_.at(linkKey(u, v))];
+    c.existsAfter = l != nullptr;
+    if (l) {
+        c.newWeight = l->weight;
+        c.newStatus = l->status;
+    }
+    if (countOp) ++txn_.operations;
+}
+
 const Link* Graph::findLink(NodeId u, NodeId v) const {
     for (const auto& l : links_) {
         if (sameUndirected(l.u, l.v, u, v)) return &l;
@@ -65,6 +276,25 @@ const Link* Graph::findLink(NodeId u, NodeId v) const {
     return nullptr;
 }
 
+const Connectivity& Graph::connectivity() const {
+    if (conn_.stale()) conn_.rebuild(*this);
+    return conn_;
+}
+
+bool Graph::permuteNodes(const std::vector<uint32_t>& order) {
+    if (order.size() != nodes_.size()) return false;
+    std::vector<bool> used(order.size(), false);
+    for (uint32_t i : order) {
+        if (i >= order.size() || used[i]) return false;
+        used[i] = true;
+    }
+    std::vector<Node> moved;
+    moved.reserve(nodes_.size());
+    for (uint32_t i : order) moved.push_back(std::move(nodes_[i]));
+    nodes_ = std::move(moved);
+    return true;
+}
+
 bool Graph::nodeExists(NodeId id) const {
     for (const auto& n : nodes_) if (n.id == id) return true;
     return false;
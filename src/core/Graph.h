@@ -1,7 +1,11 @@
 #pragma once
 
+#include "core/Connectivity.h"
+
+#include <array>
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <optional>
 
@@ -15,10 +19,15 @@ struct Node {
     float x;
     float y;
     bool up = true;
+    int32_t area = -1;  // declared routing area; -1 = none
 };
 
 enum class LinkStatus { UP, DOWN };
 
+// Metric planes: alternative weight sets routed side by side (latency, ETX,
+// monetary cost, ...). Plane 0 is Link::weight; see Graph::addPlane.
+constexpr uint32_t kMaxMetricPlanes = 8;
+
 struct Link {
     NodeId u;
     NodeId v;
@@ -27,6 +36,48 @@ struct Link {
     LinkStatus status = LinkStatus::UP;
     bool jammed = false;
     bool manually_jammed = false;  // true if user manually jammed this link
+    double capacity = 0.0;         // traffic units per direction; 0 = unknown
+    std::array<double, kMaxMetricPlanes - 1> metrics{}; // planes 1.. (plane 0 is weight)
+
+    double metric(uint32_t plane) const { return plane == 0 ? weight : metrics[plane - 1]; }
+};
+
+// Net effect of a transaction on one link: state before the first and after
+// the last edit to it. A link that did not exist on that side has exists*
+// false (added, or removed with removeLink/removeNode).
+struct LinkChange {
+    NodeId u;
+    NodeId v;
+    bool existedBefore;
+    bool existsAfter;
+    double oldWeight;
+    double newWeight;
+    LinkStatus oldStatus;
+    LinkStatus newStatus;
+};
+
+struct GraphChangeLog {
+    std::vector<LinkChange> links;  // one entry per touched link
+    std::vector<NodeId> addedNodes;
+    std::vector<NodeId> removedNodes;
+    size_t operations = 0;          // successful mutating calls
+
+    // Node set changed: every table has to be redone.
+    bool structural() const { return !addedNodes.empty() || !removedNodes.empty(); }
+    bool empty() const { return links.empty() && !structural(); }
+};
+
+// One scripted mutation, e.g. a line of a change-set file.
+struct GraphEdit {
+    enum class Op { SetWeight, SetStatus, AddLink, RemoveLink, AddNode, RemoveNode };
+    Op op = Op::SetWeight;
+    NodeId u = 0;  // link endpoints; u alone for RemoveNode
+    NodeId v = 0;
+    double weight = 1.0;
+    LinkStatus status = LinkStatus::UP;
+    std::string label;
+    float x = 0.0f;
+    float y = 0.0f;
 };
 
 class Graph {
@@ -41,14 +92,66 @@ public:
     bool addLink(NodeId u, NodeId v, double weight);
     bool setLinkStatus(NodeId u, NodeId v, LinkStatus st);
     bool setLinkWeight(NodeId u, NodeId v, double w);
+    bool removeLink(NodeId u, NodeId v);
     const Link* findLink(NodeId u, NodeId v) const;
+    bool apply(const GraphEdit& e);
+    // Same effect as apply() on each edit in turn, but link edits find their
+    // link through one index built per call instead of a scan per edit, and
+    // removals are compacted once at the end. Returns the edits that applied.
+    size_t applyBatch(const std::vector<GraphEdit>& edits);
+
+    // Named metric planes; plane 0 ("weight") always exists. addPlane returns
+    // the index of an existing plane of that name, -1 once kMaxMetricPlanes
+    // are in use, and seeds a new plane with every link's current weight.
+    // Links added later start with their weight on every plane. Edits to
+    // planes other than 0 are not recorded by transactions.
+    int addPlane(const std::string& name);
+    int planeIndex(const std::string& name) const;
+    uint32_t planeCount() const { return static_cast<uint32_t>(planes_.size()); }
+    const std::string& planeName(uint32_t plane) const { return planes_[plane]; }
+    bool setLinkMetric(NodeId u, NodeId v, uint32_t plane, double w);
+
+    // Between begin() and commit() the mutators above also record what they
+    // change; edits to the same link collapse into one LinkChange and edits
+    // that cancel out are dropped. Direct writes through links()/nodes() are
+    // not recorded. begin() inside a transaction is a no-op.
+    void begin();
+    GraphChangeLog commit();
+    bool inTransaction() const { return txnActive_; }
+
+    // Components of the UP links, kept current by the mutators above and
+    // rebuilt here when a removal left them stale. Direct status writes
+    // through links() must be followed by invalidateConnectivity().
+    const Connectivity& connectivity() const;
+    void invalidateConnectivity() { conn_.invalidate(); }
+
+    // Moves the node at position order[i] to position i. Ids and links are
+    // untouched, so only dense indices (Adjacency) see the change; it is not
+    // recorded by transactions. False, with nothing moved, unless order is a
+    // permutation of 0..N-1. See core/NodeOrder.h for orders that help SPF
+    // locality.
+    bool permuteNodes(const std::vector<uint32_t>& order);
 
     // Utility
     bool nodeExists(NodeId id) const;
 
 private:
+    // Bodies of setLinkStatus/setLinkWeight once the link is found.
+    void setStatus(Link& l, LinkStatus st);
+    void setWeight(Link& l, double w);
+    // Called before a link is modified; `l` is null for a link being added.
+    void recordLinkBefore(NodeId u, NodeId v, const Link* l);
+    void recordLinkAfter(NodeId u, NodeId v, const Link* l, bool countOp = true);
+
     std::vector<Node> nodes_;
     std::vector<Link> links_;
+    std::vector<std::string> planes_{"weight"};
+
+    bool txnActive_ = false;
+    GraphChangeLog txn_;
+    std::unordered_map<uint64_t, uint32_t> txnIndex_; // normalized (u,v) -> txn_.links slot
+
+    mutable Connectivity conn_;
 };
 
 } // namespace olsr
@@ -0,0 +1,335 @@
+#include "core/Metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <new>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace olsr::metrics {
+
+namespace {
+
+constexpr const char* kCounterNames[kCounters] = {
+    "spf_runs", "heap_pushes", "heap_pops", "relaxations",
+    "bytes_imported", "bytes_exported", "hysteresis_flips", "sim_events",
+    "allocations", "allocated_bytes", "connectivity_rebuilds",
+};
+
+constexpr const char* kPhaseNames[kPhases] = {
+    "recompute_all", "recompute_source", "apply_changes", "spf", "all_pairs", "delta_stepping",
+    "mpr", "link_loads", "te_iteration", "hysteresis", "sim_run",
+    "replay_step", "import", "export", "areas", "k_paths", "multi_plane",
+    "ms_bfs", "publish", "mobility", "checkpoint", "recover",
+};
+
+} // namespace
+
+const char* name(Counter c) { return kCounterNames[static_cast<size_t>(c)]; }
+const char* name(Phase p) { return kPhaseNames[static_cast<size_t>(p)]; }
+
+double PhaseStats::percentileNs(double p) const {
+    if (count == 0) return 0.0;
+    const uint64_t rank = static_cast<uint64_t>(std::clamp(p, 0.0, 1.0) * static_cast<double>(count - 1));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+        seen += buckets[b];
+        if (seen > rank) {
+            const double lo = b == 0 ? 0.0 : static_cast<double>(uint64_t{1} << b);
+            const double hi = static_cast<double>(uint64_t{1} << (b + 1));
+            return std::min(0.5 * (lo + hi), static_cast<double>(maxNs));
+        }
+    }
+    return static_cast<double>(maxNs);
+}
+
+size_t peakRssBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize;
+    return 0;
+#else
+    rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#if defined(__APPLE__)
+    return static_cast<size_t>(ru.ru_maxrss);        // bytes
+#else
+    return static_cast<size_t>(ru.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+}
+
+CacheMissCounter::CacheMissCounter() {
+#if defined(__linux__)
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+}
+
+CacheMissCounter::~CacheMissCounter() {
+#if defined(__linux__)
+    if (fd_ >= 0) close(fd_);
+#endif
+}
+
+uint64_t CacheMissCounter::read() const {
+    uint64_t value = 0;
+#if defined(__linux__)
+    if (fd_ >= 0 && ::read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) value = 0;
+#endif
+    return value;
+}
+
+#if OLSR_METRICS
+
+namespace {
+
+// Upper bound on buffered trace events across all threads (~24 MB).
+constexpr size_t kMaxTraceEvents = size_t{1} << 20;
+
+struct Registry {
+    std::mutex mu;
+    std::deque<ThreadMetrics> slots; // deque: stable addresses
+    std::vector<ThreadMetrics*> free;
+    std::atomic<uint64_t> lastNs[kPhases] = {};
+    std::atomic<bool> tracing{false};
+    std::atomic<size_t> traceEvents{0};
+    uint64_t traceStartNs = 0;
+};
+
+Registry& registry() {
+    // Never destroyed: worker threads may release their slot after static teardown began.
+    alignas(Registry) static unsigned char storage[sizeof(Registry)];
+    static Registry* r = new (storage) Registry();
+    return *r;
+}
+
+// Allocations made before a thread has a slot (or during static init/exit).
+std::atomic<uint64_t> gUnownedAllocs{0};
+std::atomic<uint64_t> gUnownedBytes{0};
+
+struct SlotRelease {
+    ~SlotRelease() {
+        ThreadMetrics* t = tlsMetrics;
+        if (!t) return;
+        tlsMetrics = nullptr;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lk(r.mu);
+        r.free.push_back(t);
+    }
+};
+
+inline void countAlloc(size_t bytes) {
+    if (ThreadMetrics* t = tlsMetrics) {
+        bump(t->counters[static_cast<size_t>(Counter::Allocations)], 1);
+        bump(t->counters[static_cast<size_t>(Counter::AllocatedBytes)], bytes);
+    } else {
+        gUnownedAllocs.fetch_add(1, std::memory_order_relaxed);
+        gUnownedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+ThreadMetrics& registerThread() {
+    static thread_local SlotRelease release;
+    (void)release;
+    Registry& r = registry();
+    ThreadMetrics* t;
+    {
+        std::lock_guard<std::mutex> lk(r.mu);
+        if (!r.free.empty()) {
+            t = r.free.back();
+            r.free.pop_back();
+        } else {
+            t = &r.slots.emplace_back();
+            t->tid = static_cast<uint32_t>(r.slots.size());
+        }
+    }
+    tlsMetrics = t;
+    return *t;
+}
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record(Phase p, uint64_t startNs, uint64_t durNs) {
+    ThreadMetrics& t = local();
+    const size_t i = static_cast<size_t>(p);
+    ThreadMetrics::Hist& h = t.phases[i];
+    bump(h.count, 1);
+    bump(h.totalNs, durNs);
+    if (durNs > h.maxNs.load(std::memory_order_relaxed)) h.maxNs.store(durNs, std::memory_order_relaxed);
+    const size_t b = durNs == 0 ? 0 : std::min<size_t>(kBuckets - 1, static_cast<size_t>(std::bit_width(durNs)) - 1);
+    bump(h.buckets[b], 1);
+
+    Registry& r = registry();
+    r.lastNs[i].store(durNs, std::memory_order_relaxed);
+    if (r.tracing.load(std::memory_order_relaxed) &&
+        r.traceEvents.fetch_add(1, std::memory_order_relaxed) < kMaxTraceEvents) {
+        std::lock_guard<std::mutex> lk(t.traceMu);
+        t.trace.push_back({p, startNs, durNs});
+    }
+}
+
+Snapshot snapshot() {
+    Snapshot s;
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lk(r.mu);
+    for (const ThreadMetrics& t : r.slots) {
+        for (size_t c = 0; c < kCounters; ++c) s.counters[c] += t.counters[c].load(std::memory_order_relaxed);
+        for (size_t p = 0; p < kPhases; ++p) {
+            const ThreadMetrics::Hist& h = t.phases[p];
+            PhaseStats& o = s.phases[p];
+            o.count += h.count.load(std::memory_order_relaxed);
+            o.totalNs += h.totalNs.load(std::memory_order_relaxed);
+            o.maxNs = std::max(o.maxNs, h.maxNs.load(std::memory_order_relaxed));
+            for (size_t b = 0; b < kBuckets; ++b) o.buckets[b] += h.buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+    for (size_t p = 0; p < kPhases; ++p) s.phases[p].lastNs = r.lastNs[p].load(std::memory_order_relaxed);
+    s.counters[static_cast<size_t>(Counter::Allocations)] += gUnownedAllocs.load(std::memory_order_relaxed);
+    s.counters[static_cast<size_t>(Counter::AllocatedBytes)] += gUnownedBytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+void reset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lk(r.mu);
+    for (ThreadMetrics& t : r.slots) {
+        for (auto& c : t.counters) c.store(0, std::memory_order_relaxed);
+        for (auto& h : t.phases) {
+            h.count.store(0, std::memory_order_relaxed);
+            h.totalNs.store(0, std::memory_order_relaxed);
+            h.maxNs.store(0, std::memory_order_relaxed);
+            for (auto& b : h.buckets) b.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (auto& l : r.lastNs) l.store(0, std::memory_order_relaxed);
+    gUnownedAllocs.store(0, std::memory_order_relaxed);
+    gUnownedBytes.store(0, std::memory_order_relaxed);
+}
+
+void startTrace() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lk(r.mu);
+    for (ThreadMetrics& t : r.slots) {
+        std::lock_guard<std::mutex> tl(t.traceMu);
+        t.trace.clear();
+    }
+    r.traceEvents.store(0, std::memory_order_relaxed);
+    r.traceStartNs = nowNs();
+    r.tracing.store(true, std::memory_order_release);
+}
+
+void stopTrace() { registry().tracing.store(false, std::memory_order_release); }
+
+bool tracing() { return registry().tracing.load(std::memory_order_relaxed); }
+
+size_t traceEventCount() {
+    return std::min(registry().traceEvents.load(std::memory_order_relaxed), kMaxTraceEvents);
+}
+
+bool writeChromeTrace(const std::string& path, std::string* errorMsg) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        if (errorMsg) *errorMsg = "Failed to open trace output: " + path;
+        return false;
+    }
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lk(r.mu);
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", f);
+    bool first = true;
+    for (ThreadMetrics& t : r.slots) {
+        std::lock_guard<std::mutex> tl(t.traceMu);
+        std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s%u\"}}",
+                     first ? "" : ",\n", t.tid, t.tid == 1 ? "main-" : "worker-", t.tid);
+        first = false;
+        for (const TraceEvent& e : t.trace) {
+            const double ts = static_cast<double>(e.startNs - std::min(e.startNs, r.traceStartNs)) * 1e-3;
+            std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"olsr\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         name(e.phase), t.tid, ts, static_cast<double>(e.durNs) * 1e-3);
+        }
+    }
+    std::fputs("\n],\"otherData\":{", f);
+    Snapshot s;
+    for (const ThreadMetrics& t : r.slots) {
+        for (size_t c = 0; c < kCounters; ++c) s.counters[c] += t.counters[c].load(std::memory_order_relaxed);
+    }
+    for (size_t c = 0; c < kCounters; ++c) {
+        std::fprintf(f, "%s\"%s\":\"%llu\"", c ? "," : "", kCounterNames[c],
+                     static_cast<unsigned long long>(s.counters[c]));
+    }
+    std::fputs("}}\n", f);
+    const bool ok = std::ferror(f) == 0;
+    if (std::fclose(f) != 0 || !ok) {
+        if (errorMsg) *errorMsg = "Failed to write trace output: " + path;
+        return false;
+    }
+    return true;
+}
+
+#else
+
+Snapshot snapshot() { return {}; }
+void reset() {}
+void startTrace() {}
+void stopTrace() {}
+bool tracing() { return false; }
+size_t traceEventCount() { return 0; }
+bool writeChromeTrace(const std::string& path, std::string* errorMsg) {
+    if (errorMsg) *errorMsg = "Metrics are compiled out (OLSR_LITE_ENABLE_METRICS=OFF); no trace for " + path;
+    return false;
+}
+
+#endif
+
+} // namespace olsr::metrics
+
+#if OLSR_METRICS
+
+// Global allocation counting. Lives in this translation unit so it is linked
+// whenever any instrumented code is.
+
+void* operator new(std::size_t n) {
+    olsr::metrics::countAlloc(n);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return ::operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+    olsr::metrics::countAlloc(n);
+    return std::malloc(n ? n : 1);
+}
+void* operator new[](std::size_t n, const std::nothrow_t& t) noexcept { return ::operator new(n, t); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif
@@ -0,0 +1,192 @@
+#pragma once
+
+// Low-overhead instrumentation: per-thread counters, per-phase duration
+// histograms and an optional Chrome trace-event recorder. Hot paths use the
+// OLSR_COUNT / OLSR_PHASE macros, which expand to nothing when the library is
+// built with OLSR_METRICS=0 (CMake: OLSR_LITE_ENABLE_METRICS=OFF); the query
+// functions below then report zeros.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef OLSR_METRICS
+#define OLSR_METRICS 1
+#endif
+
+namespace olsr::metrics {
+
+enum class Counter : uint32_t {
+    SpfRuns,
+    HeapPushes,
+    HeapPops,
+    Relaxations,
+    BytesImported,
+    BytesExported,
+    HysteresisFlips,
+    SimEvents,
+    Allocations,
+    AllocatedBytes,
+    ConnectivityRebuilds,
+    kCount
+};
+
+enum class Phase : uint32_t {
+    RecomputeAll,
+    RecomputeSource,
+    ApplyChanges,
+    Spf,
+    AllPairs,
+    DeltaStepping,
+    Mpr,
+    LinkLoads,
+    TeIteration,
+    Hysteresis,
+    SimRun,
+    ReplayStep,
+    Import,
+    Export,
+    Areas,
+    KPaths,
+    MultiPlane,
+    HopCountBfs,
+    Publish,
+    Mobility,
+    Checkpoint,
+    Recover,
+    kCount
+};
+
+constexpr size_t kCounters = static_cast<size_t>(Counter::kCount);
+constexpr size_t kPhases = static_cast<size_t>(Phase::kCount);
+constexpr size_t kBuckets = 48; // bucket b holds durations in [2^b, 2^(b+1)) ns
+
+const char* name(Counter c);
+const char* name(Phase p);
+
+struct PhaseStats {
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t lastNs = 0; // most recent duration on any thread
+    std::array<uint64_t, kBuckets> buckets{};
+
+    // Approximate (bucket midpoint) percentile, p in [0, 1].
+    double percentileNs(double p) const;
+};
+
+struct Snapshot {
+    std::array<uint64_t, kCounters> counters{};
+    std::array<PhaseStats, kPhases> phases{};
+
+    uint64_t operator[](Counter c) const { return counters[static_cast<size_t>(c)]; }
+    const PhaseStats& operator[](Phase p) const { return phases[static_cast<size_t>(p)]; }
+};
+
+constexpr bool enabled() { return OLSR_METRICS != 0; }
+
+// Peak resident set size of the process in bytes (0 if unknown). Available
+// regardless of OLSR_METRICS.
+size_t peakRssBytes();
+
+// Hardware cache misses of the calling thread, and of threads it starts while
+// the counter is open, from perf_event_open on Linux. Available regardless of
+// OLSR_METRICS; valid() is false where the platform, kernel settings or a
+// container deny access.
+class CacheMissCounter {
+public:
+    CacheMissCounter();
+    ~CacheMissCounter();
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    bool valid() const { return fd_ >= 0; }
+    // Misses since construction; 0 if !valid().
+    uint64_t read() const;
+
+private:
+    int fd_ = -1;
+};
+
+// Sums every thread's counters; safe to call while other threads record.
+Snapshot snapshot();
+void reset();
+
+// Phase scopes are additionally buffered as trace events while recording.
+void startTrace();
+void stopTrace();
+bool tracing();
+size_t traceEventCount();
+// Chrome trace-event JSON (chrome://tracing, Perfetto) of the recorded events.
+bool writeChromeTrace(const std::string& path, std::string* errorMsg = nullptr);
+
+#if OLSR_METRICS
+
+struct TraceEvent {
+    Phase phase;
+    uint64_t startNs;
+    uint64_t durNs;
+};
+
+// One per thread, never freed; a slot is handed to a new thread once its
+// owner exits so totals survive thread churn.
+struct ThreadMetrics {
+    struct Hist {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> maxNs{0};
+        std::atomic<uint64_t> buckets[kBuckets] = {};
+    };
+    std::atomic<uint64_t> counters[kCounters] = {};
+    Hist phases[kPhases];
+    uint32_t tid = 0;
+    std::mutex traceMu;
+    std::vector<TraceEvent> trace;
+};
+
+inline thread_local ThreadMetrics* tlsMetrics = nullptr;
+ThreadMetrics& registerThread();
+inline ThreadMetrics& local() {
+    ThreadMetrics* t = tlsMetrics;
+    return t ? *t : registerThread();
+}
+
+// Single writer per slot: a relaxed load/store pair, no locked instruction.
+inline void bump(std::atomic<uint64_t>& a, uint64_t n) {
+    a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+inline void add(Counter c, uint64_t n) { bump(local().counters[static_cast<size_t>(c)], n); }
+
+uint64_t nowNs();
+void record(Phase p, uint64_t startNs, uint64_t durNs);
+
+class ScopedPhase {
+public:
+    explicit ScopedPhase(Phase p) : phase_(p), start_(nowNs()) {}
+    ~ScopedPhase() { record(phase_, start_, nowNs() - start_); }
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    Phase phase_;
+    uint64_t start_;
+};
+
+#define OLSR_METRICS_CAT2(a, b) a##b
+#define OLSR_METRICS_CAT(a, b) OLSR_METRICS_CAT2(a, b)
+#define OLSR_COUNT(counter, n) ::olsr::metrics::add(::olsr::metrics::Counter::counter, static_cast<uint64_t>(n))
+#define OLSR_PHASE(phase) \
+    ::olsr::metrics::ScopedPhase OLSR_METRICS_CAT(olsrPhase_, __LINE__)(::olsr::metrics::Phase::phase)
+
+#else
+
+#define OLSR_COUNT(counter, n) ((void)sizeof(n)) // unevaluated; keeps locals "used"
+#define OLSR_PHASE(phase) ((void)0)
+
+#endif
+
+} // namespace olsr::metrics
@@ -0,0 +1,159 @@
+#include "core/NodeOrder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+namespace olsr {
+
+namespace {
+
+// Neighbour positions over every link, each row sorted by NodeId.
+struct Rows {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> nbrs;
+
+    uint32_t degree(uint32_t v) const { return offsets[v + 1] - offsets[v]; }
+};
+
+Rows buildRows(const Graph& g) {
+    const auto& nodes = g.nodes();
+    const uint32_t n = static_cast<uint32_t>(nodes.size());
+    std::unordered_map<NodeId, uint32_t> pos;
+    pos.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) pos.emplace(nodes[i].id, i);
+
+    std::vector<std::pair<uint32_t, uint32_t>> ends;
+    ends.reserve(g.links().size());
+    Rows r;
+    r.offsets.assign(n + 1, 0);
+    for (const Link& l : g.links()) {
+        auto iu = pos.find(l.u);
+        auto iv = pos.find(l.v);
+        if (iu == pos.end() || iv == pos.end()) continue;
+        ends.emplace_back(iu->second, iv->second);
+        ++r.offsets[iu->second + 1];
+        ++r.offsets[iv->second + 1];
+    }
+    for (uint32_t i = 0; i < n; ++i) r.offsets[i + 1] += r.offsets[i];
+    r.nbrs.resize(r.offsets[n]);
+    std::vector<uint32_t> fill(r.offsets.begin(), r.offsets.end() - 1);
+    for (auto [u, v] : ends) {
+        r.nbrs[fill[u]++] = v;
+        r.nbrs[fill[v]++] = u;
+    }
+    for (uint32_t v = 0; v < n; ++v) {
+        std::sort(r.nbrs.begin() + r.offsets[v], r.nbrs.begin() + r.offsets[v + 1],
+                  [&](uint32_t a, uint32_t b) { return nodes[a].id < nodes[b].id; });
+    }
+    return r;
+}
+
+// One BFS per component, each rooted at its lowest-degree node. With
+// byDegree the children of a vertex are queued in increasing degree
+// (Cuthill-McKee).
+std::vector<uint32_t> breadthFirst(const Graph& g, bool byDegree) {
+    const auto& nodes = g.nodes();
+    const uint32_t n = static_cast<uint32_t>(nodes.size());
+    const Rows r = buildRows(g);
+    std::vector<uint32_t> roots(n);
+    std::iota(roots.begin(), roots.end(), 0u);
+    std::sort(roots.begin(), roots.end(), [&](uint32_t a, uint32_t b) {
+        return r.degree(a) != r.degree(b) ? r.degree(a) < r.degree(b) : nodes[a].id < nodes[b].id;
+    });
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    std::vector<bool> queued(n, false);
+    for (uint32_t root : roots) {
+        if (queued[root]) continue;
+        queued[root] = true;
+        order.push_back(root);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            const uint32_t v = order[head];
+            const size_t first = order.size();
+            for (uint32_t k = r.offsets[v]; k < r.offsets[v + 1]; ++k) {
+                const uint32_t u = r.nbrs[k];
+                if (queued[u]) continue;
+                queued[u] = true;
+                order.push_back(u);
+            }
+            if (byDegree) {
+                std::stable_sort(order.begin() + first, order.end(),
+                                 [&](uint32_t a, uint32_t b) { return r.degree(a) < r.degree(b); });
+            }
+        }
+    }
+    return order;
+}
+
+// Distance along a Hilbert curve filling a 2^16 x 2^16 grid.
+uint64_t hilbertIndex(uint32_t x, uint32_t y) {
+    constexpr uint32_t kSide = 1u << 16;
+    uint64_t d = 0;
+    for (uint32_t s = kSide / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) ? 1 : 0;
+        const uint32_t ry = (y & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = kSide - 1 - x;
+                y = kSide - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+std::vector<uint32_t> hilbert(const Graph& g) {
+    const auto& nodes = g.nodes();
+    const uint32_t n = static_cast<uint32_t>(nodes.size());
+    float minX = 0, minY = 0, maxX = 0, maxY = 0;
+    bool any = false;
+    for (const Node& nd : nodes) {
+        if (!std::isfinite(nd.x) || !std::isfinite(nd.y)) continue;
+        minX = any ? std::min(minX, nd.x) : nd.x;
+        maxX = any ? std::max(maxX, nd.x) : nd.x;
+        minY = any ? std::min(minY, nd.y) : nd.y;
+        maxY = any ? std::max(maxY, nd.y) : nd.y;
+        any = true;
+    }
+    // One scale for both axes keeps the curve's cells square.
+    const double span = std::max({static_cast<double>(maxX) - minX, static_cast<double>(maxY) - minY, 1e-9});
+    auto cell = [&](float c, float lo) -> uint32_t {
+        if (!std::isfinite(c)) return 0;
+        return static_cast<uint32_t>(std::clamp((c - lo) / span, 0.0, 1.0) * 65535.0);
+    };
+    std::vector<std::pair<uint64_t, uint32_t>> keyed(n);
+    for (uint32_t i = 0; i < n; ++i) keyed[i] = {hilbertIndex(cell(nodes[i].x, minX), cell(nodes[i].y, minY)), i};
+    std::sort(keyed.begin(), keyed.end(), [&](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first < b.first : nodes[a.second].id < nodes[b.second].id;
+    });
+    std::vector<uint32_t> order(n);
+    for (uint32_t i = 0; i < n; ++i) order[i] = keyed[i].second;
+    return order;
+}
+
+} // namespace
+
+std::vector<uint32_t> nodeOrder(const Graph& g, NodeOrdering o) {
+    if (o == NodeOrdering::Bfs) return breadthFirst(g, false);
+    if (o == NodeOrdering::Hilbert) return hilbert(g);
+    if (o == NodeOrdering::Rcm) {
+        std::vector<uint32_t> order = breadthFirst(g, true);
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+    std::vector<uint32_t> order(g.nodes().size());
+    std::iota(order.begin(), order.end(), 0u);
+    return order;
+}
+
+void reorderNodes(Graph& g, NodeOrdering o) {
+    g.permuteNodes(nodeOrder(g, o));
+}
+
+} // namespace olsr
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "core/Graph.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace olsr {
+
+// Storage orders for Graph::nodes(). Import order scatters a node's
+// neighbours across the dense arrays every SPF walks; these place them close
+// together so neighbouring vertices share cache lines and pages.
+enum class NodeOrdering {
+    Import,  // leave as loaded
+    Bfs,     // breadth-first from a low-degree node of each component
+    Rcm,     // reverse Cuthill-McKee: BFS by increasing degree, reversed
+    Hilbert  // Hilbert curve over Node::x/y
+};
+
+// Position permutation for Graph::permuteNodes. Orders use every link,
+// whatever its status, so the layout does not depend on the current faults;
+// ties go to the lower NodeId.
+std::vector<uint32_t> nodeOrder(const Graph& g, NodeOrdering o);
+
+// Applies nodeOrder(g, o) in place.
+void reorderNodes(Graph& g, NodeOrdering o);
+
+} // namespace olsr
@@ -0,0 +1,84 @@
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+
+namespace olsr {
+
+static thread_local bool tlsInPool = false;
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned w = 1; w < threads; ++w) {
+        workers_.emplace_back([this, w]{ workerLoop(w); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(size_t count, const RangeFn& fn, size_t grain) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    if (workers_.empty() || tlsInPool || count <= grain) {
+        fn(0, count, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(submitMu_);
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        fn_ = &fn;
+        count_ = count;
+        grain_ = grain;
+        next_.store(0, std::memory_order_relaxed);
+        active_ = static_cast<unsigned>(workers_.size());
+        ++generation_;
+    }
+    cv_.notify_all();
+
+    tlsInPool = true;
+    runChunks(0);
+    tlsInPool = false;
+
+    std::unique_lock<std::mutex> lk(mu_);
+    doneCv_.wait(lk, [this]{ return active_ == 0; });
+    fn_ = nullptr;
+}
+
+void ThreadPool::runChunks(unsigned worker) {
+    for (;;) {
+        size_t b = next_.fetch_add(grain_, std::memory_order_relaxed);
+        if (b >= count_) break;
+        (*fn_)(b, std::min(b + grain_, count_), worker);
+    }
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    tlsInPool = true;
+    uint64_t seen = 0;
+    for (;;) {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [&]{ return stop_ || generation_ != seen; });
+        if (stop_) return;
+        seen = generation_;
+        lk.unlock();
+
+        runChunks(worker);
+
+        lk.lock();
+        if (--active_ == 0) doneCv_.notify_one();
+    }
+}
+
+} // namespace olsr
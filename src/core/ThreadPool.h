@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace olsr {
+
+// Small persistent worker pool used by the parallel routing backends.
+class ThreadPool {
+public:
+    // Body receives a half-open chunk [begin, end) and the executing worker slot
+    // in [0, size()); slot 0 is the calling thread.
+    using RangeFn = std::function<void(size_t begin, size_t end, unsigned worker)>;
+
+    explicit ThreadPool(unsigned threads = 0); // 0 = hardware concurrency
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static ThreadPool& shared();
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Splits [0, count) into chunks of `grain` and blocks until all are done.
+    // Calls made from inside a pool task run inline on the caller.
+    void parallelFor(size_t count, const RangeFn& fn, size_t grain = 1);
+
+private:
+    void workerLoop(unsigned worker);
+    void runChunks(unsigned worker);
+
+    std::vector<std::thread> workers_;
+    std::mutex submitMu_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::condition_variable doneCv_;
+    uint64_t generation_ = 0;
+    unsigned active_ = 0;
+    bool stop_ = false;
+
+    const RangeFn* fn_ = nullptr;
+    size_t count_ = 0;
+    size_t grain_ = 1;
+    std::atomic<size_t> next_{0};
+};
+
+} // namespace olsr
@@ -1,5 +1,7 @@
 #include "hyst/Hysteresis.h"
 
+#include "core/Metrics.h"
+
 // #include <imgui.h>
 
 namespace olsr {
@@ -13,7 +15,30 @@ const HysteresisState* HysteresisController::state(NodeId u, NodeId v) const {
     return &it->second;
 }
 
+void HysteresisController::update(HysteresisState& st, double weight, double nowMs) const {
+    // EMA filter
+    st.filtered = params_.alpha * weight + (1.0 - params_.alpha) * st.filtered;
+
+    // Status transitions with thresholds and hold-down
+    bool canFlip = (nowMs - st.lastChangeMs) >= params_.holdMs;
+    if (st.status == LinkStatus::UP) {
+        if (st.filtered >= params_.thetaUp && canFlip) {
+            st.status = LinkStatus::DOWN;
+            st.lastChangeMs = nowMs;
+            OLSR_COUNT(HysteresisFlips, 1);
+        }
+    } else {
+        if (st.filtered <= params_.thetaDown && canFlip) {
+            st.status = LinkStatus::UP;
+            st.lastChangeMs = nowMs;
+            OLSR_COUNT(HysteresisFlips, 1);
+        }
+    }
+}
+
 void HysteresisController::apply(Graph& g, double nowMs, double dtMs) {
+    OLSR_PHASE(Hysteresis);
+    bool flipped = false;
     for (auto& l : g.links()) {
         auto key = norm(l.u, l.v);
         auto& st = linkState_[key];
@@ -25,27 +50,14 @@ void HysteresisController::apply(Graph& g, double nowMs, double dtMs) {
             continue;
         }
         
-        // EMA filter
-        st.filtered = params_.alpha * l.weight + (1.0 - params_.alpha) * st.filtered;
-
-        // Status transitions with thresholds and hold-down
-        bool canFlip = (nowMs - st.lastChangeMs) >= params_.holdMs;
-        if (st.status == LinkStatus::UP) {
-            if (st.filtered >= params_.thetaUp && canFlip) {
-                st.status = LinkStatus::DOWN;
-                st.lastChangeMs = nowMs;
-            }
-        } else {
-            if (st.filtered <= params_.thetaDown && canFlip) {
-                st.status = LinkStatus::UP;
-                st.lastChangeMs = nowMs;
-            }
-        }
+        update(st, l.weight, nowMs);
 
         // Apply to graph copy (do not overwrite original weight except for status)
+        flipped |= l.status != st.status;
         l.status = st.status;
         l.weight = st.filtered;
     }
+    if (flipped) g.invalidateConnectivity();
 }
 
 } // namespace olsr
@@ -25,6 +25,8 @@ public:
 
     // Update internal state for all links and optionally write filtered values back to graph
     void apply(Graph& g, double nowMs, double dtMs);
+    // One filter step for a single link's state; apply() runs this per link.
+    void update(HysteresisState& st, double weight, double nowMs) const;
 
     void setParams(const HysteresisParams& p) { params_ = p; }
     const HysteresisParams& params() const { return params_; }
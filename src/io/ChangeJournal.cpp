@@ -0,0 +1,413 @@
+#include "io/ChangeJournal.h"
+
+#include "core/Metrics.h"
+#include "io/MappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace olsr {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'L', 'S', 'R', 'W', 'A', 'L', '1'};
+constexpr size_t kHeaderBytes = sizeof(kMagic) + 8;
+constexpr size_t kRecordHeaderBytes = 8;
+
+// Link flags
+constexpr uint8_t kExistsAfter = 1;
+constexpr uint8_t kUp = 2;
+constexpr uint8_t kExistedBefore = 4;
+constexpr uint8_t kWeightChanged = 8;
+constexpr uint8_t kStatusChanged = 16;
+
+template <class T> void put(std::vector<uint8_t>& out, T v) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &v, sizeof(T));
+}
+
+template <class T> bool get(const uint8_t*& p, const uint8_t* end, T& v) {
+    if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+uint32_t fnv1a(const uint8_t* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool syncFile(std::FILE* f) {
+    if (std::fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Walks the records of a mapped journal. fn(payload, bytes) sees each intact
+// record; returns the offset just past the last one.
+template <class Fn> size_t scanRecords(const uint8_t* base, size_t size, Fn&& fn) {
+    size_t pos = kHeaderBytes;
+    while (size - pos >= kRecordHeaderBytes) {
+        uint32_t bytes = 0, sum = 0;
+        std::memcpy(&bytes, base + pos, 4);
+        std::memcpy(&sum, base + pos + 4, 4);
+        if (bytes < 8 || size - pos - kRecordHeaderBytes < bytes) break;
+        const uint8_t* payload = base + pos + kRecordHeaderBytes;
+        if (fnv1a(payload, bytes) != sum) break;
+        if (!fn(payload, bytes)) break;
+        pos += kRecordHeaderBytes + bytes;
+    }
+    return pos;
+}
+
+bool isJournal(const MappedFile& file) {
+    return file.size() >= kHeaderBytes && std::memcmp(file.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+// LSN of the last intact record of a mapped journal (the base LSN if it has
+// none); returns the offset just past that record.
+size_t lastRecord(const MappedFile& file, uint64_t& last) {
+    const auto* base = reinterpret_cast<const uint8_t*>(file.data());
+    std::memcpy(&last, base + sizeof(kMagic), 8);
+    return scanRecords(base, file.size(), [&](const uint8_t* p, uint32_t) {
+        std::memcpy(&last, p, 8);
+        return true;
+    });
+}
+
+} // namespace
+
+ChangeJournal::~ChangeJournal() { close(); }
+
+bool ChangeJournal::open(const std::string& path, uint64_t afterLsn, std::string* errorMsg) {
+    close();
+    path_ = path;
+    failed_ = false;
+    uint64_t last = 0;
+    std::error_code ec;
+    const bool existing = std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) > 0;
+    if (existing) {
+        MappedFile file;
+        if (!file.open(path, errorMsg)) return false;
+        if (!isJournal(file)) {
+            if (errorMsg) *errorMsg = "Not a change journal";
+            return false;
+        }
+        const size_t end = lastRecord(file, last);
+        const size_t size = file.size();
+        file.close();
+        if (end < size) std::filesystem::resize_file(path, end, ec); // torn tail
+        file_ = std::fopen(path.c_str(), "ab");
+    } else {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (file_ && !writeHeader(afterLsn)) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+    if (!file_) {
+        if (errorMsg) *errorMsg = "Failed to open journal " + path;
+        return false;
+    }
+    lastLsn_ = durableLsn_ = std::max(last, afterLsn);
+    groups_ = bytes_ = 0;
+    stop_ = false;
+    writer_ = std::thread([this] { writerLoop(); });
+    return true;
+}
+
+bool ChangeJournal::create(const std::string& path, uint64_t baseLsn, std::string* errorMsg) {
+    close();
+    const std::string target = path; // path may be path_
+    // Skip one LSN past the replaced log, so that no checkpoint taken before
+    // this point can be replayed against the new one.
+    {
+        MappedFile file;
+        uint64_t last = 0;
+        if (file.open(target) && isJournal(file)) {
+            lastRecord(file, last);
+            baseLsn = std::max(baseLsn, last + 1);
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove(target, ec);
+    if (ec) {
+        if (errorMsg) *errorMsg = "Failed to replace journal " + target;
+        return false;
+    }
+    return open(target, baseLsn, errorMsg);
+}
+
+bool ChangeJournal::writeHeader(uint64_t baseLsn) {
+    std::vector<uint8_t> header(kMagic, kMagic + sizeof(kMagic));
+    put(header, baseLsn);
+    return std::fwrite(header.data(), 1, header.size(), file_) == header.size() && syncFile(file_);
+}
+
+void ChangeJournal::close() {
+    if (!file_) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+uint64_t ChangeJournal::append(const Graph& g, const GraphChangeLog& log) {
+    if (!file_ || log.empty()) return 0;
+    const auto& nodes = g.nodes();
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t start = pending_.size();
+    put<uint32_t>(pending_, 0); // length and checksum, patched below
+    put<uint32_t>(pending_, 0);
+    const uint64_t lsn = ++lastLsn_;
+    put(pending_, lsn);
+    put(pending_, static_cast<uint32_t>(log.addedNodes.size()));
+    put(pending_, static_cast<uint32_t>(log.removedNodes.size()));
+    put(pending_, static_cast<uint32_t>(log.links.size()));
+    for (NodeId id : log.addedNodes) {
+        // New nodes sit at the back.
+        auto it = std::find_if(nodes.rbegin(), nodes.rend(), [id](const Node& n) { return n.id == id; });
+        const bool found = it != nodes.rend();
+        put(pending_, id);
+        put(pending_, found ? it->x : 0.0f);
+        put(pending_, found ? it->y : 0.0f);
+        const std::string& label = found ? it->label : std::string();
+        put(pending_, static_cast<uint32_t>(label.size()));
+        pending_.insert(pending_.end(), label.begin(), label.end());
+    }
+    for (NodeId id : log.removedNodes) put(pending_, id);
+    for (const LinkChange& c : log.links) {
+        put(pending_, c.u);
+        put(pending_, c.v);
+        uint8_t flags = 0;
+        if (c.existsAfter) flags |= kExistsAfter;
+        if (c.newStatus == LinkStatus::UP) flags |= kUp;
+        if (c.existedBefore) flags |= kExistedBefore;
+        if (c.existedBefore && c.oldWeight != c.newWeight) flags |= kWeightChanged;
+        if (c.existedBefore && c.oldStatus != c.newStatus) flags |= kStatusChanged;
+        put(pending_, flags);
+        put(pending_, c.newWeight);
+    }
+    const uint32_t bytes = static_cast<uint32_t>(pending_.size() - start - kRecordHeaderBytes);
+    const uint32_t sum = fnv1a(pending_.data() + start + kRecordHeaderBytes, bytes);
+    std::memcpy(pending_.data() + start, &bytes, 4);
+    std::memcpy(pending_.data() + start + 4, &sum, 4);
+    wake_.notify_one();
+    return lsn;
+}
+
+void ChangeJournal::writerLoop() {
+    std::vector<uint8_t> batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (pending_.empty()) break; // stopping with nothing left
+        // Everything appended while the last group was on its way goes out
+        // in this one, under a single fsync.
+        batch.swap(pending_);
+        const uint64_t lsn = lastLsn_;
+        writing_ = true;
+        lock.unlock();
+        const bool ok = std::fwrite(batch.data(), 1, batch.size(), file_) == batch.size() && syncFile(file_);
+        lock.lock();
+        writing_ = false;
+        if (ok) {
+            durableLsn_ = lsn;
+            ++groups_;
+            bytes_ += batch.size();
+        } else {
+            failed_ = true;
+        }
+        batch.clear();
+        durable_.notify_all();
+    }
+}
+
+bool ChangeJournal::sync() {
+    if (!file_) return false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    const uint64_t target = lastLsn_;
+    durable_.wait(lock, [&] { return failed_ || durableLsn_ >= target; });
+    return !failed_;
+}
+
+bool ChangeJournal::truncate() {
+    if (!sync()) return false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    durable_.wait(lock, [this] { return !writing_ && pending_.empty(); });
+    std::fclose(file_);
+    file_ = std::fopen(path_.c_str(), "wb");
+    if (!file_ || !writeHeader(lastLsn_)) {
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+uint64_t ChangeJournal::lastLsn() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastLsn_;
+}
+
+uint64_t ChangeJournal::durableLsn() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return durableLsn_;
+}
+
+uint64_t ChangeJournal::groupCommits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return groups_;
+}
+
+uint64_t ChangeJournal::bytesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+bool ChangeJournal::replay(const std::string& path, uint64_t afterLsn, Graph& g,
+                           const std::function<void(const GraphChangeLog&)>& onCommit, JournalReplayStats* stats,
+                           std::string* errorMsg) {
+    OLSR_PHASE(Recover);
+    JournalReplayStats st;
+    MappedFile file;
+    if (!file.open(path, errorMsg)) return false;
+    if (!isJournal(file)) {
+        if (errorMsg) *errorMsg = "Not a change journal";
+        return false;
+    }
+    const auto* base = reinterpret_cast<const uint8_t*>(file.data());
+    uint64_t baseLsn = 0;
+    std::memcpy(&baseLsn, base + sizeof(kMagic), 8);
+    if (baseLsn > afterLsn) {
+        if (errorMsg) {
+            *errorMsg = "Journal starts after LSN " + std::to_string(baseLsn) + " but the checkpoint covers LSN " +
+                        std::to_string(afterLsn) + "; the records in between are gone";
+        }
+        return false;
+    }
+    std::string error;
+    std::vector<GraphEdit> edits;
+    // Without onCommit nobody needs the logs, so nothing is recorded and runs
+    // of records that only touch links go to the graph as one batch: one link
+    // index per run instead of per record.
+    const bool perRecord = static_cast<bool>(onCommit);
+    bool open = false;
+    auto flush = [&] {
+        if (!open) return;
+        g.applyBatch(edits);
+        edits.clear();
+        open = false;
+        if (perRecord) onCommit(g.commit());
+    };
+    const size_t end = scanRecords(base, file.size(), [&](const uint8_t* p, uint32_t bytes) {
+        const uint8_t* e = p + bytes;
+        uint64_t lsn = 0;
+        uint32_t added = 0, removed = 0, links = 0;
+        get(p, e, lsn);
+        if (!get(p, e, added) || !get(p, e, removed) || !get(p, e, links)) {
+            error = "Malformed journal record " + std::to_string(lsn);
+            return false;
+        }
+        st.lastLsn = lsn;
+        if (lsn <= afterLsn) {
+            ++st.skipped;
+            return true;
+        }
+        if (added || removed) flush(); // node ids depend on the order
+        if (!open && perRecord) g.begin();
+        open = true;
+        st.linkChanges += links;
+        bool ok = true;
+        for (uint32_t i = 0; i < added && ok; ++i) {
+            NodeId id = 0;
+            float x = 0.0f, y = 0.0f;
+            uint32_t len = 0;
+            ok = get(p, e, id) && get(p, e, x) && get(p, e, y) && get(p, e, len) && static_cast<size_t>(e - p) >= len;
+            if (!ok) break;
+            const NodeId got = g.addNode(std::string(reinterpret_cast<const char*>(p), len), x, y);
+            p += len;
+            if (got != id) {
+                error = "Journal record " + std::to_string(lsn) + " adds node " + std::to_string(id) +
+                        " but the graph assigned " + std::to_string(got) + "; wrong checkpoint?";
+                return false;
+            }
+        }
+        std::vector<NodeId> gone(removed);
+        for (uint32_t i = 0; i < removed && ok; ++i) ok = get(p, e, gone[i]);
+        for (uint32_t i = 0; i < links && ok; ++i) {
+            GraphEdit ed;
+            uint8_t flags = 0;
+            ok = get(p, e, ed.u) && get(p, e, ed.v) && get(p, e, flags) && get(p, e, ed.weight);
+            ed.status = (flags & kUp) ? LinkStatus::UP : LinkStatus::DOWN;
+            if (!(flags & kExistsAfter)) {
+                ed.op = GraphEdit::Op::RemoveLink;
+                edits.push_back(ed);
+                continue;
+            }
+            if (!(flags & kExistedBefore)) {
+                ed.op = GraphEdit::Op::AddLink;
+                edits.push_back(ed);
+                if (ed.status == LinkStatus::UP) continue;
+                ed.op = GraphEdit::Op::SetStatus;
+                edits.push_back(ed);
+                continue;
+            }
+            if (flags & kWeightChanged) {
+                ed.op = GraphEdit::Op::SetWeight;
+                edits.push_back(ed);
+            }
+            if (flags & kStatusChanged) {
+                ed.op = GraphEdit::Op::SetStatus;
+                edits.push_back(ed);
+            }
+        }
+        for (NodeId id : gone) {
+            GraphEdit ed;
+            ed.op = GraphEdit::Op::RemoveNode;
+            ed.u = id;
+            edits.push_back(ed);
+        }
+        if (!ok) {
+            error = "Malformed journal record " + std::to_string(lsn);
+            return false;
+        }
+        ++st.records;
+        if (perRecord || removed) flush();
+        return true;
+    });
+    if (error.empty()) {
+        flush();
+    } else if (open && perRecord) {
+        g.commit(); // what applied so far stays; the caller is told it failed
+    }
+    st.tornTail = error.empty() && end < file.size();
+    if (stats) *stats = st;
+    if (!error.empty()) {
+        if (errorMsg) *errorMsg = error;
+        return false;
+    }
+    return true;
+}
+
+} // namespace olsr
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "core/Graph.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace olsr {
+
+struct JournalReplayStats {
+    uint64_t records = 0;       // transactions re-applied
+    uint64_t skipped = 0;       // records already covered by the checkpoint
+    uint64_t linkChanges = 0;   // link entries in the replayed records
+    uint64_t lastLsn = 0;
+    bool tornTail = false;      // the file ended inside a record
+};
+
+// Append-only log of committed Graph transactions, for warm restart together
+// with Checkpoint.
+//
+// File: the 8-byte magic "OLSRWAL1" and a uint64 base LSN, then one record
+// per transaction: uint32 payload bytes, uint32 FNV-1a of the payload, and
+// the payload { uint64 lsn; uint32 added, removed, links; per added node
+// uint32 id, float x, y, uint32 label bytes, label; per removed node uint32
+// id; per link uint32 u, v, uint8 flags, double weight after }. Flags: bit 0
+// exists after, bit 1 UP after, bit 2 existed before, bit 3 weight changed,
+// bit 4 status changed. Integers are little-endian. A record that fails its
+// length or checksum ends the log (a write torn by a crash).
+//
+// append() serializes the net effect of a transaction (its GraphChangeLog)
+// into memory and returns; a writer thread writes whatever has accumulated
+// and fsyncs once per batch (group commit), so the mutation path never
+// waits for the disk. Node positions moved directly through nodes() and
+// planes other than 0 are not recorded.
+class ChangeJournal {
+public:
+    ChangeJournal() = default;
+    ~ChangeJournal();
+    ChangeJournal(const ChangeJournal&) = delete;
+    ChangeJournal& operator=(const ChangeJournal&) = delete;
+
+    // Opens or creates the journal for appending. LSNs continue after the
+    // last one in an existing log, or after afterLsn (the checkpoint the log
+    // continues) if that is larger. A torn last record is cut off. Returns
+    // true on success.
+    bool open(const std::string& path, uint64_t afterLsn = 0, std::string* errorMsg = nullptr);
+    // Like open(), but replaces any existing log with an empty one based at
+    // baseLsn: for a run that did not start from the state that log continues.
+    // LSNs then start past the replaced log's, with a gap, so checkpoints
+    // taken before the replacement fail to replay it.
+    bool create(const std::string& path, uint64_t baseLsn = 0, std::string* errorMsg = nullptr);
+    // Writes out everything appended and stops the writer.
+    void close();
+    bool isOpen() const { return file_ != nullptr; }
+    const std::string& path() const { return path_; }
+
+    // Queues one committed transaction; g supplies labels and positions of
+    // added nodes. Returns its LSN, or 0 for an empty log.
+    uint64_t append(const Graph& g, const GraphChangeLog& log);
+    // Blocks until every record appended so far is on disk; false after a
+    // write error.
+    bool sync();
+    // Drops every record once a checkpoint covers them; LSNs carry on.
+    bool truncate();
+
+    uint64_t lastLsn() const;
+    uint64_t durableLsn() const;
+    uint64_t groupCommits() const;   // fsyncs so far
+    uint64_t bytesWritten() const;
+
+    // Re-applies the records after `afterLsn` to g, one transaction each, and
+    // hands every commit's log to onCommit (e.g. Router::applyChanges). With
+    // an empty onCommit, records that only touch links are applied in runs,
+    // and inside a transaction of the caller the whole tail collapses into
+    // that transaction's log.
+    // Returns false if the file is not a journal, starts after afterLsn (the
+    // records in between are gone) or a record does not fit g.
+    static bool replay(const std::string& path, uint64_t afterLsn, Graph& g,
+                       const std::function<void(const GraphChangeLog&)>& onCommit,
+                       JournalReplayStats* stats = nullptr, std::string* errorMsg = nullptr);
+
+private:
+    void writerLoop();
+    bool writeHeader(uint64_t baseLsn);
+
+    std::string path_;
+    std::FILE* file_ = nullptr;
+    std::thread writer_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;     // writer: pending data or stop
+    std::condition_variable durable_;  // sync(): a group reached the disk
+    std::vector<uint8_t> pending_;     // appended, not yet handed to the writer
+    uint64_t lastLsn_ = 0;
+    uint64_t durableLsn_ = 0;
+    uint64_t groups_ = 0;
+    uint64_t bytes_ = 0;
+    bool writing_ = false;
+    bool stop_ = false;
+    bool failed_ = false;
+};
+
+} // namespace olsr
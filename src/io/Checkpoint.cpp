@@ -0,0 +1,265 @@
+#include "io/Checkpoint.h"
+
+#include "core/Metrics.h"
+#include "io/MappedFile.h"
+#include "io/RouteArchive.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace olsr {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'L', 'S', 'R', 'C', 'K', 'P', '1'};
+constexpr uint32_t kVersion = 2;
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint16_t planeCount;
+    uint8_t policy;         // RoutePolicy
+    uint8_t pad;
+    uint64_t lsn;
+    uint64_t nodeCount;
+    uint64_t linkCount;
+    uint32_t planeBytes;    // plane names, each NUL-terminated
+    uint32_t labelBytes;
+    uint64_t routesOffset;  // 0: no route section
+    uint64_t routesBytes;
+};
+static_assert(sizeof(CheckpointHeader) == 64, "checkpoint header layout");
+
+struct NodeRecord {
+    uint32_t id;
+    float x, y;
+    int32_t area;
+    uint32_t labelOffset;
+    uint32_t labelLen;
+    uint8_t up;
+    uint8_t pad[7];
+};
+static_assert(sizeof(NodeRecord) == 32, "checkpoint node layout");
+
+struct LinkRecord {
+    uint32_t u, v;
+    double weight;
+    double origWeight;
+    double capacity;
+    double metrics[kMaxMetricPlanes - 1];
+    uint8_t up;
+    uint8_t jammed;
+    uint8_t manuallyJammed;
+    uint8_t pad[7];
+};
+static_assert(sizeof(LinkRecord) == 104, "checkpoint link layout");
+
+template <class T> void writeRaw(std::ostream& os, const T* p, size_t count) {
+    os.write(reinterpret_cast<const char*>(p), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+// Flushes a closed file's data to the disk.
+bool syncPath(const std::string& path, bool directory = false) {
+#ifdef _WIN32
+    if (directory) return true; // renames are durable on NTFS
+    std::FILE* f = std::fopen(path.c_str(), "rb+");
+    if (!f) return false;
+    const bool ok = _commit(_fileno(f)) == 0;
+    std::fclose(f);
+    return ok;
+#else
+    const int fd = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDWR);
+    if (fd < 0) return false;
+    const bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+} // namespace
+
+bool Checkpoint::write(const Graph& g, const Router* r, RoutePolicy policy, uint64_t lsn, const std::string& path,
+                       std::string* errorMsg) {
+    OLSR_PHASE(Checkpoint);
+    const std::string tmp = path + ".tmp";
+    std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) {
+        if (errorMsg) *errorMsg = "Failed to open " + tmp;
+        return false;
+    }
+
+    CheckpointHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.planeCount = static_cast<uint16_t>(g.planeCount());
+    h.policy = static_cast<uint8_t>(policy);
+    h.lsn = lsn;
+    h.nodeCount = g.nodes().size();
+    h.linkCount = g.links().size();
+
+    std::string planes;
+    for (uint32_t p = 0; p < g.planeCount(); ++p) {
+        planes += g.planeName(p);
+        planes += '\0';
+    }
+    h.planeBytes = static_cast<uint32_t>(planes.size());
+
+    std::vector<NodeRecord> nodes(g.nodes().size());
+    std::string labels;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const Node& n = g.nodes()[i];
+        nodes[i] = NodeRecord{n.id, n.x, n.y, n.area, static_cast<uint32_t>(labels.size()),
+                              static_cast<uint32_t>(n.label.size()), n.up, {}};
+        labels += n.label;
+    }
+    h.labelBytes = static_cast<uint32_t>(labels.size());
+
+    std::vector<LinkRecord> links(g.links().size());
+    for (size_t i = 0; i < links.size(); ++i) {
+        const Link& l = g.links()[i];
+        LinkRecord& rec = links[i];
+        rec = LinkRecord{};
+        rec.u = l.u;
+        rec.v = l.v;
+        rec.weight = l.weight;
+        rec.origWeight = l.orig_weight;
+        rec.capacity = l.capacity;
+        std::memcpy(rec.metrics, l.metrics.data(), sizeof(rec.metrics));
+        rec.up = l.status == LinkStatus::UP;
+        rec.jammed = l.jammed;
+        rec.manuallyJammed = l.manually_jammed;
+    }
+
+    writeRaw(ofs, &h, 1);
+    ofs.write(planes.data(), static_cast<std::streamsize>(planes.size()));
+    writeRaw(ofs, nodes.data(), nodes.size());
+    writeRaw(ofs, links.data(), links.size());
+    ofs.write(labels.data(), static_cast<std::streamsize>(labels.size()));
+    if (r) {
+        h.routesOffset = static_cast<uint64_t>(ofs.tellp());
+        h.routesBytes = RouteArchive::write(g, *r, ofs);
+        ofs.seekp(0);
+        writeRaw(ofs, &h, 1);
+    }
+    ofs.close();
+    if (!ofs) {
+        if (errorMsg) *errorMsg = "Write failed";
+        return false;
+    }
+    if (!syncPath(tmp)) {
+        if (errorMsg) *errorMsg = "Failed to sync " + tmp;
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        if (errorMsg) *errorMsg = "Failed to replace " + path + ": " + ec.message();
+        return false;
+    }
+    const std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    syncPath(dir.empty() ? "." : dir.string(), true);
+    OLSR_COUNT(BytesExported, h.routesOffset + h.routesBytes);
+    return true;
+}
+
+bool Checkpoint::read(const std::string& path, Graph& g, Router* r, CheckpointInfo* info, std::string* errorMsg) {
+    OLSR_PHASE(Recover);
+    MappedFile file;
+    if (!file.open(path, errorMsg)) return false;
+    const auto* base = reinterpret_cast<const uint8_t*>(file.data());
+    const size_t size = file.size();
+    CheckpointHeader h{};
+    if (size >= sizeof(h)) std::memcpy(&h, base, sizeof(h));
+    if (size < sizeof(h) || std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+        if (errorMsg) *errorMsg = "Not a checkpoint";
+        return false;
+    }
+    if (h.version != kVersion || h.planeCount == 0 || h.planeCount > kMaxMetricPlanes) {
+        if (errorMsg) *errorMsg = "Unsupported checkpoint version";
+        return false;
+    }
+    if (h.policy > static_cast<uint8_t>(RoutePolicy::Lexicographic)) {
+        if (errorMsg) *errorMsg = "Unknown routing policy in checkpoint";
+        return false;
+    }
+    const auto policy = static_cast<RoutePolicy>(h.policy);
+    const size_t nodesAt = sizeof(h) + h.planeBytes;
+    const size_t linksAt = nodesAt + h.nodeCount * sizeof(NodeRecord);
+    const size_t labelsAt = linksAt + h.linkCount * sizeof(LinkRecord);
+    const size_t graphEnd = labelsAt + h.labelBytes;
+    if (h.nodeCount > size || h.linkCount > size || graphEnd > size ||
+        (h.routesOffset && (h.routesOffset < graphEnd || h.routesBytes > size - h.routesOffset))) {
+        if (errorMsg) *errorMsg = "Truncated checkpoint";
+        return false;
+    }
+
+    Graph out;
+    const char* names = reinterpret_cast<const char*>(base + sizeof(h));
+    const char* namesEnd = names + h.planeBytes;
+    for (uint32_t p = 0; p < h.planeCount; ++p) {
+        const char* nul = static_cast<const char*>(std::memchr(names, '\0', static_cast<size_t>(namesEnd - names)));
+        if (!nul) {
+            if (errorMsg) *errorMsg = "Malformed checkpoint plane names";
+            return false;
+        }
+        if (p > 0) out.addPlane(std::string(names, nul));
+        names = nul + 1;
+    }
+
+    const char* labels = reinterpret_cast<const char*>(base + labelsAt);
+    auto& nodes = out.nodes();
+    nodes.resize(h.nodeCount);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        NodeRecord rec;
+        std::memcpy(&rec, base + nodesAt + i * sizeof(rec), sizeof(rec));
+        if (size_t(rec.labelOffset) + rec.labelLen > h.labelBytes) {
+            if (errorMsg) *errorMsg = "Malformed checkpoint node " + std::to_string(rec.id);
+            return false;
+        }
+        nodes[i] = Node{rec.id, std::string(labels + rec.labelOffset, rec.labelLen), rec.x, rec.y, rec.up != 0,
+                        rec.area};
+    }
+    auto& links = out.links();
+    links.resize(h.linkCount);
+    for (size_t i = 0; i < links.size(); ++i) {
+        LinkRecord rec;
+        std::memcpy(&rec, base + linksAt + i * sizeof(rec), sizeof(rec));
+        Link& l = links[i];
+        l.u = rec.u;
+        l.v = rec.v;
+        l.weight = rec.weight;
+        l.orig_weight = rec.origWeight;
+        l.capacity = rec.capacity;
+        std::memcpy(l.metrics.data(), rec.metrics, sizeof(rec.metrics));
+        l.status = rec.up ? LinkStatus::UP : LinkStatus::DOWN;
+        l.jammed = rec.jammed != 0;
+        l.manually_jammed = rec.manuallyJammed != 0;
+    }
+    out.invalidateConnectivity();
+
+    size_t routes = 0;
+    if (r && h.routesOffset) {
+        RouteArchive archive;
+        const uint8_t* p = base + h.routesOffset;
+        if (!archive.parse(p, p + h.routesBytes, errorMsg)) return false;
+        routes = archive.routeCount();
+        r->restore(archive.takeTables(), policy);
+    }
+    g = std::move(out);
+    if (info) *info = CheckpointInfo{h.lsn, policy, g.nodes().size(), g.links().size(), routes, size};
+    OLSR_COUNT(BytesImported, size);
+    return true;
+}
+
+} // namespace olsr
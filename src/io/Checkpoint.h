@@ -0,0 +1,45 @@
+#pragma once
+
+#include "core/Graph.h"
+#include "route/Router.h"
+
+#include <cstdint>
+#include <string>
+
+namespace olsr {
+
+struct CheckpointInfo {
+    uint64_t lsn = 0;       // last journal record the checkpoint covers
+    RoutePolicy policy = RoutePolicy::Shortest; // what the run routed by
+    size_t nodes = 0;
+    size_t links = 0;
+    size_t routes = 0;      // restored route entries; 0 without a route section
+    size_t bytes = 0;
+};
+
+// Snapshot of graph and route state for warm restart; ChangeJournal replays
+// what happened after it.
+//
+// File: a 64-byte header (magic "OLSRCKP1", version, plane count, routing
+// policy, LSN, node and link counts, plane name and label bytes, offset and
+// size of the route section), the
+// plane names, fixed-size node and link records, the labels, then a
+// RouteArchive. Records are copied straight from and into memory, so a
+// checkpoint is read back by mapping it and is only portable between hosts
+// of the same byte order.
+class Checkpoint {
+public:
+    // Writes g, the tables of r if given, the routing policy of the run and
+    // the journal position lsn. The file goes to path + ".tmp" first, is
+    // synced, and is renamed over path, so a crash leaves the previous
+    // checkpoint intact.
+    static bool write(const Graph& g, const Router* r, RoutePolicy policy, uint64_t lsn, const std::string& path,
+                      std::string* errorMsg = nullptr);
+    // Replaces g with the checkpointed graph and, if r is given and the file
+    // holds routes, installs them with Router::restore under the checkpoint's
+    // policy. Returns true on success.
+    static bool read(const std::string& path, Graph& g, Router* r, CheckpointInfo* info = nullptr,
+                     std::string* errorMsg = nullptr);
+};
+
+} // namespace olsr
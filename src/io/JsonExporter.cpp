@@ -1,5 +1,7 @@
 #include "io/JsonExporter.h"
 
+#include "core/Metrics.h"
+
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <chrono>
@@ -12,7 +14,21 @@ static const char* statusToString(LinkStatus st) {
     return st == LinkStatus::UP ? "UP" : "DOWN";
 }
 
+static json routesToJson(const RouteTable& tbl) {
+    json arr = json::array();
+    for (const auto& e : tbl) {
+        arr.push_back({
+            {"destination", e.destination},
+            {"next_hop", e.next_hop},
+            {"total_cost", e.total_cost},
+            {"hop_count", e.hop_count}
+        });
+    }
+    return arr;
+}
+
 bool JsonExporter::exportRoutes(const Graph& g, const Router& r, const std::string& path) {
+    OLSR_PHASE(Export);
     json j;
     auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()).count();
@@ -20,39 +36,126 @@ bool JsonExporter::exportRoutes(const Graph& g, const Router& r, const std::stri
         {"version", "1.0.0"},
         {"timestamp_ms", now_ms}
     };
+    if (g.planeCount() > 1) {
+        json names = json::array();
+        for (uint32_t p = 0; p < g.planeCount(); ++p) names.push_back(g.planeName(p));
+        j["meta"]["planes"] = names;
+        j["meta"]["plane"] = g.planeName(planes_ && plane_ < g.planeCount() ? plane_ : 0);
+    }
+    // Route costs are bandwidths or probabilities under those policies.
+    if (!planes_ && !hierarchy_ && r.policy() != RoutePolicy::Shortest) {
+        j["meta"]["policy"] = routePolicyName(r.policy());
+    }
 
     j["nodes"] = json::array();
     for (const auto& n : g.nodes()) {
-        j["nodes"].push_back({{"id", n.id}, {"label", n.label}});
+        json jn = {{"id", n.id}, {"label", n.label}};
+        const int32_t area = hierarchy_ ? hierarchy_->areaOf(n.id) : n.area;
+        if (area >= 0) jn["area"] = area;
+        j["nodes"].push_back(jn);
     }
 
+    const bool withLoads = loads_ && loads_->loads().size() == g.links().size();
     j["links"] = json::array();
-    for (const auto& l : g.links()) {
-        j["links"].push_back({
+    for (size_t i = 0; i < g.links().size(); ++i) {
+        const Link& l = g.links()[i];
+        json jl = {
             {"u", l.u}, {"v", l.v}, {"weight", l.weight}, {"status", statusToString(l.status)}
-        });
+        };
+        if (l.capacity > 0.0) jl["capacity"] = l.capacity;
+        if (g.planeCount() > 1) {
+            json metrics = json::object();
+            for (uint32_t p = 1; p < g.planeCount(); ++p) metrics[g.planeName(p)] = l.metric(p);
+            jl["metrics"] = metrics;
+        }
+        if (withLoads) {
+            const LinkLoad& ld = loads_->loads()[i];
+            jl["load_uv"] = ld.forward;
+            jl["load_vu"] = ld.reverse;
+            jl["utilization"] = ld.utilization;
+        }
+        j["links"].push_back(jl);
     }
 
     json routesObj = json::object();
     for (const auto& n : g.nodes()) {
-        const RouteTable* tbl = r.table(n.id);
+        if (hierarchy_) {
+            routesObj[std::to_string(n.id)] = routesToJson(hierarchy_->table(n.id));
+            continue;
+        }
+        const RouteTable* tbl = planes_ ? planes_->table(plane_, n.id) : r.table(n.id);
         if (!tbl) continue;
-        json arr = json::array();
-        for (const auto& e : *tbl) {
-            arr.push_back({
-                {"destination", e.destination},
-                {"next_hop", e.next_hop},
-                {"total_cost", e.total_cost},
-                {"hop_count", e.hop_count}
+        routesObj[std::to_string(n.id)] = routesToJson(*tbl);
+    }
+    j["routes"] = routesObj;
+
+    if (hierarchy_) {
+        json areas = json::array();
+        for (uint32_t a = 0; a < hierarchy_->areaCount(); ++a) {
+            json local = json::object();
+            const std::vector<NodeId> members = hierarchy_->areaNodes(a);
+            for (NodeId id : members) local[std::to_string(id)] = routesToJson(hierarchy_->areaTable(id));
+            areas.push_back({
+                {"id", a},
+                {"nodes", members},
+                {"borders", hierarchy_->areaBorders(a)},
+                {"routes", local}
             });
         }
-        routesObj[std::to_string(n.id)] = arr;
+        j["hierarchy"] = {
+            {"declared", hierarchy_->declared()},
+            {"border_routers", hierarchy_->borderCount()},
+            {"backbone_edges", hierarchy_->backboneEdges()},
+            {"table_entries", hierarchy_->tableEntries()},
+            {"areas", areas}
+        };
+    }
+
+    if (mpr_) {
+        json sets = json::object();
+        for (const auto& n : g.nodes()) {
+            if (const auto* m = mpr_->mprs(n.id)) sets[std::to_string(n.id)] = *m;
+        }
+        FloodingStats fs = mpr_->floodingStats();
+        j["mpr"] = {
+            {"sets", sets},
+            {"flooding", {
+                {"pure_forwards", fs.pureForwards},
+                {"mpr_forwards", fs.mprForwards},
+                {"reduction", fs.reduction()}
+            }}
+        };
+    }
+
+    if (paths_ && paths_->paths.size() == paths_->queries.size()) {
+        json queries = json::array();
+        for (size_t i = 0; i < paths_->queries.size(); ++i) {
+            json arr = json::array();
+            for (const KPath& p : paths_->paths[i]) {
+                arr.push_back({{"nodes", p.nodes}, {"cost", p.cost}, {"hops", p.hops()}});
+            }
+            queries.push_back({{"src", paths_->queries[i].src}, {"dst", paths_->queries[i].dst}, {"paths", arr}});
+        }
+        j["paths"] = {
+            {"mode", paths_->mode == PathMode::EdgeDisjoint ? "edge_disjoint" : "loopless"},
+            {"k", paths_->k},
+            {"queries", queries}
+        };
+    }
+
+    if (withLoads) {
+        j["traffic"] = {
+            {"max_load", loads_->maxLoad()},
+            {"max_utilization", loads_->maxUtilization()},
+            {"unroutable", loads_->unroutable()}
+        };
     }
-    j["routes"] = routesObj;
 
     std::ofstream ofs(path, std::ios::binary);
     if (!ofs.is_open()) return false;
-    ofs << j.dump(2) << '\n';
+    const std::string text = j.dump(2);
+    ofs << text << '\n';
+    OLSR_COUNT(BytesExported, text.size() + 1);
     return true;
 }
 
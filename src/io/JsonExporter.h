@@ -1,6 +1,11 @@
 #pragma once
 
 #include "core/Graph.h"
+#include "route/HierarchicalRouter.h"
+#include "route/KShortestPaths.h"
+#include "route/LinkLoad.h"
+#include "route/Mpr.h"
+#include "route/MultiPlaneSpf.h"
 #include "route/Router.h"
 #include <string>
 
@@ -9,6 +14,29 @@ namespace olsr {
 class JsonExporter {
 public:
     bool exportRoutes(const Graph& g, const Router& r, const std::string& path);
+
+    // Optional sections; pass nullptr to omit.
+    void attachMpr(const MprSelector* mpr) { mpr_ = mpr; }
+    // Loads must have been computed on the exported graph.
+    void attachLoads(const LinkLoadEngine* loads) { loads_ = loads; }
+    // Routes then come from the composed two-level view (the flat Router is
+    // not consulted) and a "hierarchy" section carries the area-local tables.
+    void attachHierarchy(const HierarchicalRouter* h) { hierarchy_ = h; }
+    // Answered k-shortest-path queries, written as a "paths" section.
+    void attachPaths(const PathBatch* paths) { paths_ = paths; }
+    // Routes then come from metric plane `plane` of the multi-plane tables.
+    void attachPlanes(const MultiPlaneRouter* planes, uint32_t plane) {
+        planes_ = planes;
+        plane_ = plane;
+    }
+
+private:
+    const MprSelector* mpr_ = nullptr;
+    const LinkLoadEngine* loads_ = nullptr;
+    const HierarchicalRouter* hierarchy_ = nullptr;
+    const PathBatch* paths_ = nullptr;
+    const MultiPlaneRouter* planes_ = nullptr;
+    uint32_t plane_ = 0;
 };
 
 } // namespace olsr
@@ -1,18 +1,32 @@
 #include "io/JsonImporter.h"
 
+#include "core/Metrics.h"
+#include "route/RoutePolicy.h"
+
 #include <nlohmann/json.hpp>
+#include <algorithm>
 #include <fstream>
+#include <stdexcept>
 
 namespace olsr {
 
 using nlohmann::json;
 
+namespace {
+
+bool offGrid(double w) { return !(w < kCostLimit); }
+
+} // namespace
+
 bool JsonImporter::loadTopology(const std::string& path, Graph& g, std::string* errorMsg) {
+    policy_.clear();
+    heavyLinks_ = 0;
     std::ifstream ifs(path);
     if (!ifs.is_open()) {
         if (errorMsg) *errorMsg = "Failed to open topology file";
         return false;
     }
+    OLSR_PHASE(Import);
     json j;
     try {
         ifs >> j;
@@ -20,8 +34,16 @@ bool JsonImporter::loadTopology(const std::string& path, Graph& g, std::string*
         if (errorMsg) *errorMsg = std::string("Invalid JSON: ") + e.what();
         return false;
     }
+    ifs.clear();
+    ifs.seekg(0, std::ios::end);
+    OLSR_COUNT(BytesImported, std::max<std::streamoff>(0, ifs.tellg()));
 
     try {
+        if (j.contains("policy")) {
+            policy_ = j.at("policy").get<std::string>();
+            RoutePolicy p;
+            if (!parseRoutePolicy(policy_, p)) throw std::runtime_error("unknown routing policy " + policy_);
+        }
         std::vector<NodeId> idMap; // 1-based index -> assigned id
         idMap.resize(1);
         if (j.contains("nodes")) {
@@ -32,6 +54,7 @@ bool JsonImporter::loadTopology(const std::string& path, Graph& g, std::string*
                 float y = n.value("y", 0.0f);
                 while (idMap.size() <= id) idMap.push_back(0);
                 NodeId assigned = g.addNode(label, x, y);
+                g.nodes().back().area = n.value("area", -1);
                 idMap[id] = assigned;
             }
         }
@@ -43,7 +66,21 @@ bool JsonImporter::loadTopology(const std::string& path, Graph& g, std::string*
                 if (u < idMap.size() && v < idMap.size()) {
                     NodeId uu = idMap[u];
                     NodeId vv = idMap[v];
-                    g.addLink(uu, vv, w);
+                    if (!g.addLink(uu, vv, w)) continue;
+                    g.links().back().capacity = l.value("capacity", 0.0);
+                    bool heavy = offGrid(w);
+                    if (l.contains("metrics")) {
+                        for (const auto& [name, value] : l.at("metrics").items()) {
+                            const int plane = g.addPlane(name);
+                            if (plane < 0) throw std::runtime_error("more than 8 metric planes");
+                            Link& nl = g.links().back();
+                            const double m = value.get<double>();
+                            if (plane == 0) nl.weight = nl.orig_weight = m;
+                            else nl.metrics[plane - 1] = m;
+                            heavy = heavy || offGrid(m);
+                        }
+                    }
+                    heavyLinks_ += heavy;
                 }
             }
         }
@@ -54,6 +91,99 @@ bool JsonImporter::loadTopology(const std::string& path, Graph& g, std::string*
     return true;
 }
 
+bool JsonImporter::loadTraffic(const std::string& path, TrafficMatrix& tm, std::string* errorMsg) {
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        if (errorMsg) *errorMsg = "Failed to open traffic file";
+        return false;
+    }
+    OLSR_PHASE(Import);
+    json j;
+    try {
+        ifs >> j;
+    } catch (const std::exception& e) {
+        if (errorMsg) *errorMsg = std::string("Invalid JSON: ") + e.what();
+        return false;
+    }
+    ifs.clear();
+    ifs.seekg(0, std::ios::end);
+    OLSR_COUNT(BytesImported, std::max<std::streamoff>(0, ifs.tellg()));
+
+    try {
+        tm.demands.clear();
+        for (const auto& d : j.at("demands")) {
+            tm.demands.push_back(TrafficDemand{
+                static_cast<NodeId>(d.at("src").get<int>()),
+                static_cast<NodeId>(d.at("dst").get<int>()),
+                d.value("rate", 1.0)});
+        }
+    } catch (const std::exception& e) {
+        if (errorMsg) *errorMsg = std::string("Traffic parse error: ") + e.what();
+        return false;
+    }
+    return true;
+}
+
+bool JsonImporter::loadChanges(const std::string& path, std::vector<GraphEdit>& edits, std::string* errorMsg) {
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        if (errorMsg) *errorMsg = "Failed to open change set";
+        return false;
+    }
+    OLSR_PHASE(Import);
+    json j;
+    try {
+        ifs >> j;
+    } catch (const std::exception& e) {
+        if (errorMsg) *errorMsg = std::string("Invalid JSON: ") + e.what();
+        return false;
+    }
+    ifs.clear();
+    ifs.seekg(0, std::ios::end);
+    OLSR_COUNT(BytesImported, std::max<std::streamoff>(0, ifs.tellg()));
+
+    try {
+        edits.clear();
+        heavyLinks_ = 0;
+        for (const auto& c : j.at("changes")) {
+            GraphEdit e;
+            const std::string op = c.at("op").get<std::string>();
+            if (op == "remove_node") {
+                e.op = GraphEdit::Op::RemoveNode;
+                e.u = static_cast<NodeId>(c.at("id").get<int>());
+            } else if (op == "add_node") {
+                e.op = GraphEdit::Op::AddNode;
+                e.label = c.value("label", std::string("R"));
+                e.x = c.value("x", 0.0f);
+                e.y = c.value("y", 0.0f);
+            } else {
+                e.u = static_cast<NodeId>(c.at("u").get<int>());
+                e.v = static_cast<NodeId>(c.at("v").get<int>());
+                if (op == "weight") {
+                    e.op = GraphEdit::Op::SetWeight;
+                    e.weight = c.at("weight").get<double>();
+                } else if (op == "status") {
+                    e.op = GraphEdit::Op::SetStatus;
+                    e.status = c.at("status").get<std::string>() == "DOWN" ? LinkStatus::DOWN : LinkStatus::UP;
+                } else if (op == "add_link") {
+                    e.op = GraphEdit::Op::AddLink;
+                    e.weight = c.value("weight", 1.0);
+                } else if (op == "remove_link") {
+                    e.op = GraphEdit::Op::RemoveLink;
+                } else {
+                    throw std::runtime_error("unknown op '" + op + "'");
+                }
+                if (e.op == GraphEdit::Op::SetWeight || e.op == GraphEdit::Op::AddLink) heavyLinks_ += offGrid(e.weight);
+            }
+            edits.push_back(std::move(e));
+        }
+    } catch (const std::exception& e) {
+        if (errorMsg) *errorMsg = std::string("Change set parse error: ") + e.what();
+        return false;
+    }
+    return true;
+}
+
 } // namespace olsr
 
 
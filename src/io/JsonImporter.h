@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/Graph.h"
+#include "route/LinkLoad.h"
 #include <string>
 
 namespace olsr {
@@ -9,6 +10,24 @@ class JsonImporter {
 public:
     // Returns true on success
     bool loadTopology(const std::string& path, Graph& g, std::string* errorMsg = nullptr);
+    // The top-level "policy" of the last topology loaded ("shortest",
+    // "widest", "reliable" or "lexicographic"): what its link weights mean.
+    // Empty if it named none.
+    const std::string& policy() const { return policy_; }
+    // Links of the last topology or change set with a weight, in any plane,
+    // of kCostLimit or more (or not a number). The cost grid ends there, so
+    // paths over them compare as equal; see RoutePolicy.h.
+    size_t heavyLinks() const { return heavyLinks_; }
+    // {"demands": [{"src": 1, "dst": 2, "rate": 5.0}, ...]}; ids are graph NodeIds.
+    bool loadTraffic(const std::string& path, TrafficMatrix& tm, std::string* errorMsg = nullptr);
+    // {"changes": [{"op": "weight", "u": 1, "v": 2, "weight": 3.0}, ...]}; ops are
+    // weight, status ("UP"/"DOWN"), add_link, remove_link, add_node
+    // (label, x, y) and remove_node (id). Ids are graph NodeIds.
+    bool loadChanges(const std::string& path, std::vector<GraphEdit>& edits, std::string* errorMsg = nullptr);
+
+private:
+    std::string policy_;
+    size_t heavyLinks_ = 0;
 };
 
 } // namespace olsr
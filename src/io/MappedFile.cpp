@@ -0,0 +1,106 @@
+#include "io/MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace olsr {
+
+MappedFile::~MappedFile() { close(); }
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, std::string* errorMsg) {
+    close();
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (f == INVALID_HANDLE_VALUE) {
+        if (errorMsg) *errorMsg = "Failed to open file";
+        return false;
+    }
+    LARGE_INTEGER sz;
+    GetFileSizeEx(f, &sz);
+    file_ = f;
+    size_ = static_cast<size_t>(sz.QuadPart);
+    if (size_ == 0) return true;
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) {
+        if (errorMsg) *errorMsg = "Failed to map file";
+        close();
+        return false;
+    }
+    mapping_ = m;
+    data_ = static_cast<const char*>(MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+        if (errorMsg) *errorMsg = "Failed to map file";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(static_cast<HANDLE>(mapping_));
+    if (file_) CloseHandle(static_cast<HANDLE>(file_));
+    data_ = nullptr;
+    mapping_ = file_ = nullptr;
+    size_ = released_ = 0;
+}
+
+void MappedFile::release(size_t) {}
+
+#else
+
+bool MappedFile::open(const std::string& path, std::string* errorMsg) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        if (errorMsg) *errorMsg = "Failed to open file";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        if (errorMsg) *errorMsg = "Failed to stat file";
+        close();
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) return true;
+    void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (p == MAP_FAILED) {
+        if (errorMsg) *errorMsg = "Failed to map file";
+        close();
+        return false;
+    }
+    madvise(p, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(p);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+    if (fd_ >= 0) ::close(fd_);
+    data_ = nullptr;
+    fd_ = -1;
+    size_ = released_ = 0;
+}
+
+void MappedFile::release(size_t offset) {
+    // Only whole pages strictly behind the reader, in large strides.
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t end = offset / page * page;
+    if (!data_ || end < released_ + (size_t{64} << 20)) return;
+    madvise(const_cast<char*>(data_) + released_, end - released_, MADV_DONTNEED);
+    released_ = end;
+}
+
+#endif
+
+} // namespace olsr
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace olsr {
+
+// Read-only memory mapping of a whole file. Pages are faulted in on access,
+// so large inputs stream through the page cache instead of being loaded.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns true on success
+    bool open(const std::string& path, std::string* errorMsg = nullptr);
+    void close();
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // Hints that [0, offset) will not be read again so its pages can be dropped.
+    void release(size_t offset);
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t released_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+} // namespace olsr
@@ -0,0 +1,124 @@
+#include "io/RouteArchive.h"
+
+#include "core/Metrics.h"
+#include "io/MappedFile.h"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace olsr {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'L', 'S', 'R', 'R', 'T', 'Z', '1'};
+
+void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+bool getU32(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+    if (end - p < 4) return false;
+    v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    p += 4;
+    return true;
+}
+
+} // namespace
+
+bool RouteArchive::write(const Graph& g, const Router& r, const std::string& path, std::string* errorMsg) {
+    OLSR_PHASE(Export);
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs.is_open()) {
+        if (errorMsg) *errorMsg = "Failed to open output file";
+        return false;
+    }
+    const size_t written = write(g, r, ofs);
+    if (!ofs) {
+        if (errorMsg) *errorMsg = "Write failed";
+        return false;
+    }
+    OLSR_COUNT(BytesExported, written);
+    return true;
+}
+
+size_t RouteArchive::write(const Graph& g, const Router& r, std::ostream& os) {
+    std::vector<uint8_t> buf(kMagic, kMagic + sizeof(kMagic));
+    putU32(buf, static_cast<uint32_t>(g.nodes().size()));
+    size_t written = 0;
+    CompressedRouteTable packed;
+    for (const Node& n : g.nodes()) {
+        putU32(buf, n.id);
+        if (const CompressedRouteTable* pt = r.packedTable(n.id)) {
+            pt->serialize(buf);
+        } else {
+            const RouteTable* t = r.table(n.id);
+            if (t) packed.encode(*t);
+            else packed.clear();
+            packed.serialize(buf);
+        }
+        if (buf.size() >= (1u << 20)) {
+            os.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+            written += buf.size();
+            buf.clear();
+        }
+    }
+    os.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+    return written + buf.size();
+}
+
+bool RouteArchive::read(const std::string& path, std::string* errorMsg) {
+    OLSR_PHASE(Import);
+    tables_.clear();
+    MappedFile file;
+    if (!file.open(path, errorMsg)) return false;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(file.data());
+    if (!parse(p, p + file.size(), errorMsg)) return false;
+    OLSR_COUNT(BytesImported, file.size());
+    return true;
+}
+
+bool RouteArchive::parse(const uint8_t* p, const uint8_t* end, std::string* errorMsg) {
+    tables_.clear();
+    uint32_t count = 0;
+    if (end - p < static_cast<std::ptrdiff_t>(sizeof(kMagic)) || std::memcmp(p, kMagic, sizeof(kMagic)) != 0) {
+        if (errorMsg) *errorMsg = "Not a route archive";
+        return false;
+    }
+    p += sizeof(kMagic);
+    if (!getU32(p, end, count)) {
+        if (errorMsg) *errorMsg = "Truncated route archive";
+        return false;
+    }
+    tables_.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t src = 0;
+        if (!getU32(p, end, src) || !tables_[src].deserialize(p, end)) {
+            if (errorMsg) *errorMsg = "Corrupt route table " + std::to_string(i);
+            tables_.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+const CompressedRouteTable* RouteArchive::table(NodeId src) const {
+    auto it = tables_.find(src);
+    return it == tables_.end() ? nullptr : &it->second;
+}
+
+size_t RouteArchive::routeCount() const {
+    size_t n = 0;
+    for (const auto& [id, t] : tables_) n += t.size();
+    return n;
+}
+
+size_t RouteArchive::bytes() const {
+    size_t n = 0;
+    for (const auto& [id, t] : tables_) n += t.bytes();
+    return n;
+}
+
+} // namespace olsr
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core/Graph.h"
+#include "route/CompressedRouteTable.h"
+#include "route/Router.h"
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+namespace olsr {
+
+// Route tables on disk in the packed form of CompressedRouteTable: the 8-byte
+// magic "OLSRRTZ1", a uint32 table count, then per table a uint32 source id
+// followed by the serialized table. Integers in the header are little-endian.
+class RouteArchive {
+public:
+    // Writes the table of every node of g. Tables already packed in r are
+    // copied as they are; flat ones are encoded on the way.
+    static bool write(const Graph& g, const Router& r, const std::string& path, std::string* errorMsg = nullptr);
+    // Same, appended to a stream (e.g. inside a checkpoint); returns the bytes written.
+    static size_t write(const Graph& g, const Router& r, std::ostream& os);
+
+    // Returns true on success
+    bool read(const std::string& path, std::string* errorMsg = nullptr);
+    // Reads an archive held in memory, e.g. a section of a mapped file.
+    bool parse(const uint8_t* p, const uint8_t* end, std::string* errorMsg = nullptr);
+    const CompressedRouteTable* table(NodeId src) const;
+    // Hands the tables over, e.g. to Router::restore, leaving the archive empty.
+    std::unordered_map<NodeId, CompressedRouteTable> takeTables() {
+        auto out = std::move(tables_);
+        tables_.clear();
+        return out;
+    }
+
+    size_t tableCount() const { return tables_.size(); }
+    size_t routeCount() const;
+    size_t bytes() const;
+
+private:
+    std::unordered_map<NodeId, CompressedRouteTable> tables_;
+};
+
+} // namespace olsr
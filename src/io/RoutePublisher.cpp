@@ -0,0 +1,170 @@
+#include "io/RoutePublisher.h"
+
+#include "core/Metrics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace olsr {
+
+namespace {
+
+#ifdef _WIN32
+
+void* mapSegment(const std::string&, size_t, std::string* errorMsg) {
+    if (errorMsg) *errorMsg = "Shared-memory routes are not supported on this platform";
+    return nullptr;
+}
+void unmapSegment(void*, size_t) {}
+
+#else
+
+// Creates the segment afresh. A stale one under the same name is unlinked
+// first; readers that still map it keep a consistent, if dated, view.
+void* mapSegment(const std::string& path, size_t bytes, std::string* errorMsg) {
+    shm_unlink(path.c_str());
+    const int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        if (errorMsg) *errorMsg = "Failed to create shared memory " + path;
+        return nullptr;
+    }
+    void* p = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        if (errorMsg) *errorMsg = "Failed to map shared memory " + path;
+        return nullptr;
+    }
+    return p;
+}
+
+void unmapSegment(void* p, size_t bytes) {
+    if (p) munmap(p, bytes);
+}
+
+#endif
+
+} // namespace
+
+RoutePublisher::RoutePublisher(std::string name) : name_(routeSegmentPath(name)) {}
+
+RoutePublisher::~RoutePublisher() { unmapSegment(header_, bytes_); }
+
+void RoutePublisher::remove(const std::string& name) {
+#ifndef _WIN32
+    shm_unlink(routeSegmentPath(name).c_str());
+#else
+    (void)name;
+#endif
+}
+
+bool RoutePublisher::create(uint32_t capacity, std::string* errorMsg) {
+    const size_t bufferBytes = RouteSegmentLayout::bufferBytes(capacity);
+    const size_t first = (sizeof(RouteSegmentHeader) + 63) & ~size_t(63);
+    const size_t second = (first + bufferBytes + 63) & ~size_t(63);
+    const size_t bytes = second + bufferBytes;
+    void* p = mapSegment(name_, bytes, errorMsg);
+    if (!p) return false;
+    // ftruncate zero-fills, so both buffers start empty with even counts.
+    auto* h = new (p) RouteSegmentHeader{};
+    h->magic = kRouteSegmentMagic;
+    h->version = kRouteSegmentVersion;
+    h->capacity = capacity;
+    h->bufferBytes = bufferBytes;
+    h->bufferOffset[0] = first;
+    h->bufferOffset[1] = second;
+    header_ = h;
+    bytes_ = bytes;
+    for (auto& stamps : rowStamps_) stamps.clear();
+    return true;
+}
+
+bool RoutePublisher::publish(const Graph& g, const Router& r, std::string* errorMsg) {
+    OLSR_PHASE(Publish);
+    const uint32_t n = static_cast<uint32_t>(g.nodes().size());
+    if (header_ && n <= header_->capacity) {
+        write(g, r);
+        return true;
+    }
+    RouteSegmentHeader* old = std::exchange(header_, nullptr);
+    const size_t oldBytes = std::exchange(bytes_, 0);
+    if (!create(std::max<uint32_t>(n, 1), errorMsg)) {
+        header_ = old;
+        bytes_ = oldBytes;
+        return false;
+    }
+    write(g, r);
+    // Only now may readers move over: the new segment holds a generation.
+    if (old) old->retired.store(1, std::memory_order_release);
+    unmapSegment(old, oldBytes);
+    return true;
+}
+
+void RoutePublisher::write(const Graph& g, const Router& r) {
+    RouteSegmentHeader& h = *header_;
+    const uint32_t b = 1 - (h.active.load(std::memory_order_relaxed) & 1);
+    char* buf = reinterpret_cast<char*>(header_) + h.bufferOffset[b];
+    const uint64_t seq = h.seq[b].load(std::memory_order_relaxed);
+    h.seq[b].store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const uint32_t n = static_cast<uint32_t>(g.nodes().size());
+    auto* bh = reinterpret_cast<RouteBufferHeader*>(buf);
+    auto* ids = reinterpret_cast<uint32_t*>(buf + RouteSegmentLayout::idsOffset());
+    auto* cells = reinterpret_cast<RouteCell*>(buf + RouteSegmentLayout::cellsOffset(h.capacity));
+    auto* sums = reinterpret_cast<uint64_t*>(buf + RouteSegmentLayout::checksumOffset(h.capacity));
+    sortedIds_.resize(n);
+    for (uint32_t i = 0; i < n; ++i) sortedIds_[i] = g.nodes()[i].id;
+    std::sort(sortedIds_.begin(), sortedIds_.end());
+    // Rows are laid out by destination index, so a different node set
+    // invalidates every row this buffer holds.
+    std::vector<uint64_t>& stamps = rowStamps_[b];
+    if (stamps.size() != n || bh->nodeCount != n || !std::equal(sortedIds_.begin(), sortedIds_.end(), ids)) {
+        std::copy(sortedIds_.begin(), sortedIds_.end(), ids);
+        stamps.assign(n, 0);
+    }
+
+    rowsWritten_ = 0;
+    for (uint32_t s = 0; s < n; ++s) {
+        const uint64_t stamp = r.tableStamp(ids[s]);
+        if (stamp != 0 && stamp == stamps[s]) continue;
+        stamps[s] = stamp;
+        ++rowsWritten_;
+        RouteCell* row = cells + size_t(s) * n;
+        std::memset(row, 0, sizeof(RouteCell) * size_t(n));
+        row[s].nextHop = ids[s];
+        if (const RouteTable* t = r.table(ids[s])) {
+            // Tables are in destination order, so one merge places them.
+            uint32_t d = 0;
+            for (const RouteEntry& e : *t) {
+                if (d >= n || ids[d] > e.destination) {
+                    d = static_cast<uint32_t>(std::lower_bound(ids, ids + n, e.destination) - ids);
+                }
+                while (d < n && ids[d] < e.destination) ++d;
+                if (d == n || ids[d] != e.destination || d == s) continue;
+                row[d] = RouteCell{e.next_hop, e.hop_count, e.total_cost};
+            }
+        }
+        sums[s] = routeRowChecksum(row, n);
+    }
+    bh->generation = ++generation_;
+    bh->nodeCount = n;
+
+    h.seq[b].store(seq + 2, std::memory_order_release);
+    h.active.store(b, std::memory_order_release);
+    h.generation.store(generation_, std::memory_order_release);
+}
+
+} // namespace olsr
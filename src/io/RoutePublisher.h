@@ -0,0 +1,57 @@
+#pragma once
+
+#include "core/Graph.h"
+#include "io/RouteSegment.h"
+#include "route/Router.h"
+
+#include <string>
+#include <vector>
+
+namespace olsr {
+
+// Write side of a route segment (see io/RouteSegment.h). Each publish() brings
+// the idle buffer up to the router's current tables as a new generation and
+// then makes it the active one. One publisher per segment name.
+//
+// The idle buffer still holds the generation before last, so only the rows
+// whose Router::tableStamp moved since that buffer was written are copied;
+// a change to the node set rewrites every row.
+//
+// A segment holds capacity^2 cells in each of its two buffers, at 16 bytes
+// per cell. If the graph outgrows the capacity, a larger segment is created
+// under the same name and the old one is marked retired once the new one
+// holds a generation. Readers then map the new segment on their next call.
+class RoutePublisher {
+public:
+    explicit RoutePublisher(std::string name);
+    ~RoutePublisher();
+    RoutePublisher(const RoutePublisher&) = delete;
+    RoutePublisher& operator=(const RoutePublisher&) = delete;
+
+    // Returns true on success
+    bool publish(const Graph& g, const Router& r, std::string* errorMsg = nullptr);
+    // Last generation published, 0 before the first.
+    uint64_t generation() const { return generation_; }
+    // Size of the mapped segment.
+    size_t bytes() const { return bytes_; }
+    // Rows copied by the last publish().
+    size_t rowsWritten() const { return rowsWritten_; }
+
+    // Unlinks the segment name. Mapped readers keep their view.
+    static void remove(const std::string& name);
+
+private:
+    bool create(uint32_t capacity, std::string* errorMsg);
+    // Fills the idle buffer and makes it active.
+    void write(const Graph& g, const Router& r);
+
+    std::string name_;
+    RouteSegmentHeader* header_ = nullptr;
+    size_t bytes_ = 0;
+    uint64_t generation_ = 0;
+    size_t rowsWritten_ = 0;
+    std::vector<uint64_t> rowStamps_[2];  // per buffer: table stamp each row was copied from
+    std::vector<uint32_t> sortedIds_;     // scratch
+};
+
+} // namespace olsr
@@ -0,0 +1,183 @@
+#include "io/RouteSegment.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace olsr {
+
+namespace {
+
+// Bound on waiting for a freshly created segment's first generation, so a
+// reader of a publisher that never publishes still returns.
+constexpr uint32_t kMaxEmptyAttempts = 4096;
+
+} // namespace
+
+uint64_t routeRowChecksum(const RouteCell* row, uint32_t count) {
+    uint64_t h = 1469598103934665603ull;
+    const auto* p = reinterpret_cast<const unsigned char*>(row);
+    for (size_t i = 0, bytes = sizeof(RouteCell) * size_t(count); i < bytes; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::string routeSegmentPath(const std::string& name) {
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+RouteSegmentReader::~RouteSegmentReader() { close(); }
+
+bool RouteSegmentReader::open(const std::string& name, std::string* errorMsg) {
+    close();
+    name_ = routeSegmentPath(name);
+    if (remap()) return true;
+    if (errorMsg) *errorMsg = "No route segment " + name_;
+    return false;
+}
+
+#ifdef _WIN32
+
+void RouteSegmentReader::close() {}
+bool RouteSegmentReader::remap() { return false; }
+
+#else
+
+void RouteSegmentReader::close() {
+    if (header_) munmap(const_cast<RouteSegmentHeader*>(header_), bytes_);
+    header_ = nullptr;
+    bytes_ = 0;
+}
+
+bool RouteSegmentReader::remap() {
+    const int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat st{};
+    void* p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(RouteSegmentHeader)) {
+        p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+    const auto* h = static_cast<const RouteSegmentHeader*>(p);
+    const size_t bytes = static_cast<size_t>(st.st_size);
+    const size_t need = RouteSegmentLayout::bufferBytes(h->capacity);
+    if (h->magic != kRouteSegmentMagic || h->version != kRouteSegmentVersion || h->bufferBytes != need ||
+        h->bufferOffset[0] + need > bytes || h->bufferOffset[1] + need > bytes) {
+        munmap(p, bytes);
+        return false;
+    }
+    // A segment caught between creation and its first write holds nothing;
+    // the one already mapped stays consistent until the replacement does.
+    if (header_ && h->generation.load(std::memory_order_acquire) == 0) {
+        munmap(p, bytes);
+        return false;
+    }
+    close();
+    header_ = h;
+    bytes_ = bytes;
+    return true;
+}
+
+#endif
+
+template <class Fn>
+bool RouteSegmentReader::consistentRead(Fn&& fn, uint64_t* generation) {
+    for (uint32_t attempt = 0;; ++attempt) {
+        if (!header_ && !remap()) return false;
+        // The replacement holds a generation before the old segment is
+        // retired. Should the name already point further on (or nowhere, for
+        // an instant), the retired mapping still reads consistently.
+        if (header_->retired.load(std::memory_order_acquire) && remap()) continue;
+        if (attempt >= 64) std::this_thread::yield();
+        if (header_->generation.load(std::memory_order_acquire) == 0) {
+            // Opened between the publisher's create and first write.
+            if (attempt >= kMaxEmptyAttempts) return false;
+            continue;
+        }
+        const uint32_t b = header_->active.load(std::memory_order_acquire) & 1;
+        const uint64_t s1 = header_->seq[b].load(std::memory_order_acquire);
+        if (s1 & 1) {
+            ++retries_;
+            continue;
+        }
+        const char* buf = reinterpret_cast<const char*>(header_) + header_->bufferOffset[b];
+        const auto* bh = reinterpret_cast<const RouteBufferHeader*>(buf);
+        const uint64_t gen = bh->generation;
+        const uint32_t n = std::min(bh->nodeCount, header_->capacity);
+        const bool found = fn(buf, n);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header_->seq[b].load(std::memory_order_relaxed) != s1) {
+            ++retries_;
+            continue;
+        }
+        if (generation) *generation = gen;
+        return found;
+    }
+}
+
+namespace {
+
+// Index of id among the n sorted ids, or n.
+uint32_t indexOf(const uint32_t* ids, uint32_t n, uint32_t id) {
+    const uint32_t* it = std::lower_bound(ids, ids + n, id);
+    return (it != ids + n && *it == id) ? static_cast<uint32_t>(it - ids) : n;
+}
+
+} // namespace
+
+bool RouteSegmentReader::lookup(uint32_t src, uint32_t dst, SegmentRoute& out, uint64_t* generation) {
+    return consistentRead([&](const char* buf, uint32_t n) {
+        const auto* ids = reinterpret_cast<const uint32_t*>(buf + RouteSegmentLayout::idsOffset());
+        const uint32_t s = indexOf(ids, n, src);
+        const uint32_t d = indexOf(ids, n, dst);
+        if (s == n || d == n) return false;
+        const auto* cells = reinterpret_cast<const RouteCell*>(buf + RouteSegmentLayout::cellsOffset(header_->capacity));
+        const RouteCell c = cells[size_t(s) * n + d];
+        out = SegmentRoute{dst, c.nextHop, c.hops, c.cost};
+        return c.hops != 0;
+    }, generation);
+}
+
+bool RouteSegmentReader::table(uint32_t src, std::vector<SegmentRoute>& out, uint64_t* generation) {
+    uint64_t stored = 0;
+    uint32_t count = 0;
+    const bool found = consistentRead([&](const char* buf, uint32_t n) {
+        const auto* ids = reinterpret_cast<const uint32_t*>(buf + RouteSegmentLayout::idsOffset());
+        const uint32_t s = indexOf(ids, n, src);
+        if (s == n) return false;
+        const uint32_t capacity = header_->capacity;
+        const auto* cells = reinterpret_cast<const RouteCell*>(buf + RouteSegmentLayout::cellsOffset(capacity));
+        const auto* sums = reinterpret_cast<const uint64_t*>(buf + RouteSegmentLayout::checksumOffset(capacity));
+        row_.resize(n);
+        std::memcpy(row_.data(), cells + size_t(s) * n, sizeof(RouteCell) * size_t(n));
+        stored = sums[s];
+        count = n;
+        out.clear();
+        for (uint32_t d = 0; d < n; ++d) {
+            if (row_[d].hops != 0) out.push_back(SegmentRoute{ids[d], row_[d].nextHop, row_[d].hops, row_[d].cost});
+        }
+        return true;
+    }, generation);
+    if (!found) return false;
+    if (routeRowChecksum(row_.data(), count) != stored) {
+        ++checksumFailures_;
+        return false;
+    }
+    return true;
+}
+
+uint64_t RouteSegmentReader::generation() const {
+    return header_ ? header_->generation.load(std::memory_order_acquire) : 0;
+}
+
+} // namespace olsr
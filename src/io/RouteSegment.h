@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace olsr {
+
+// Layout of the shared-memory route segment written by RoutePublisher and
+// read by RouteSegmentReader. This header and RouteSegment.cpp depend on
+// nothing else in the project, so data-plane agents can link the reader on
+// its own (olsr_route_reader).
+//
+// The segment holds a header and two buffers. Each buffer holds a complete
+// route matrix: a generation number, the sorted node ids, one RouteCell per
+// (source, destination) pair and one checksum per source row. The publisher
+// always fills the buffer readers are not directed to. It then switches
+// `active` over, so readers almost never see a buffer being written. Each
+// buffer also has a seqlock. The count is odd while the buffer is being
+// written, and readers retry if it was odd or changed during their read.
+// A reader that was preempted across two publications therefore cannot
+// return a torn result.
+constexpr uint64_t kRouteSegmentMagic = 0x314745534D524C4Full; // "OLRMSEG1"
+constexpr uint32_t kRouteSegmentVersion = 1;
+
+struct RouteCell {
+    uint32_t nextHop;  // NodeId
+    uint32_t hops;     // 0 = unreachable, or destination == source
+    double cost;
+};
+
+struct RouteSegmentHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t capacity;                  // nodes one buffer can hold
+    uint64_t bufferBytes;
+    uint64_t bufferOffset[2];
+    std::atomic<uint32_t> active;       // buffer holding the latest generation
+    std::atomic<uint32_t> retired;      // 1 once the publisher replaced the segment
+    std::atomic<uint64_t> generation;   // latest published generation
+    std::atomic<uint64_t> seq[2];       // per-buffer seqlock
+};
+
+struct RouteBufferHeader {
+    uint64_t generation;
+    uint32_t nodeCount;
+    uint32_t reserved;
+    // Followed by uint32_t ids[capacity] (ascending), RouteCell
+    // cells[nodeCount * nodeCount] (row = source index) and uint64_t
+    // rowChecksum[capacity], each 8-byte aligned.
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "segment atomics must be address-free");
+
+// Byte sizes and offsets inside one buffer.
+struct RouteSegmentLayout {
+    static size_t idsOffset() { return sizeof(RouteBufferHeader); }
+    static size_t cellsOffset(uint32_t capacity) { return (idsOffset() + 4 * size_t(capacity) + 7) & ~size_t(7); }
+    static size_t checksumOffset(uint32_t capacity) {
+        return cellsOffset(capacity) + sizeof(RouteCell) * size_t(capacity) * capacity;
+    }
+    static size_t bufferBytes(uint32_t capacity) { return checksumOffset(capacity) + 8 * size_t(capacity); }
+};
+
+// FNV-1a over one row of cells; stored per row by the publisher.
+uint64_t routeRowChecksum(const RouteCell* row, uint32_t count);
+
+// POSIX shared-memory name: "/name", with the slash added if missing.
+std::string routeSegmentPath(const std::string& name);
+
+struct SegmentRoute {
+    uint32_t destination;
+    uint32_t nextHop;
+    uint32_t hops;
+    double cost;
+};
+
+// Read side of a route segment. Lookups read the mapping in place, with no
+// parsing, and return values copied out under the seqlock. When the
+// publisher replaces the segment (the node count outgrew it), the reader
+// maps the new one by name on its next call. One reader per thread.
+class RouteSegmentReader {
+public:
+    RouteSegmentReader() = default;
+    ~RouteSegmentReader();
+    RouteSegmentReader(const RouteSegmentReader&) = delete;
+    RouteSegmentReader& operator=(const RouteSegmentReader&) = delete;
+
+    // Returns true on success
+    bool open(const std::string& name, std::string* errorMsg = nullptr);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    // One route. False if either id is unknown or dst is unreachable.
+    bool lookup(uint32_t src, uint32_t dst, SegmentRoute& out, uint64_t* generation = nullptr);
+    // Reachable destinations of src in id order, all from one generation.
+    bool table(uint32_t src, std::vector<SegmentRoute>& out, uint64_t* generation = nullptr);
+    // Latest published generation, 0 before the first.
+    uint64_t generation() const;
+
+    // Reads repeated because a publication overlapped them.
+    uint64_t retries() const { return retries_; }
+    // Rows whose checksum did not match after a clean seqlock read. Always 0
+    // unless the protocol is broken.
+    uint64_t checksumFailures() const { return checksumFailures_; }
+
+private:
+    // Maps the segment currently under name_. Keeps the existing mapping,
+    // and returns false, if that segment is missing, invalid or still empty.
+    bool remap();
+    // Runs fn(buffer, nodeCount) until it completes without a concurrent
+    // write, riding out segment replacement; fn returns false to report
+    // "not found".
+    template <class Fn> bool consistentRead(Fn&& fn, uint64_t* generation);
+
+    std::string name_;
+    const RouteSegmentHeader* header_ = nullptr;
+    size_t bytes_ = 0;
+    uint64_t retries_ = 0;
+    uint64_t checksumFailures_ = 0;
+    std::vector<RouteCell> row_;
+};
+
+} // namespace olsr
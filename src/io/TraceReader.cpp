@@ -0,0 +1,141 @@
+#include "io/TraceReader.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace olsr {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'L', 'S', 'R', 'T', 'R', 'C', '1'};
+
+struct TraceRecord {
+    int64_t timeUs;
+    double weight;
+    uint32_t u;
+    uint32_t v;
+    int32_t status;
+    uint32_t reserved;
+};
+static_assert(sizeof(TraceRecord) == 32, "binary trace record must stay 32 bytes");
+
+// Field cursor over one CSV line.
+struct Fields {
+    const char* p;
+    const char* end;
+
+    bool atEnd() const { return p >= end; }
+    // Advances past the field and its trailing comma; returns [b, e).
+    void take(const char*& b, const char*& e) {
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+        b = p;
+        while (p < end && *p != ',') ++p;
+        e = p;
+        while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r')) --e;
+        if (p < end) ++p;
+    }
+};
+
+} // namespace
+
+bool TraceReader::open(const std::string& path, std::string* errorMsg) {
+    pos_ = 0;
+    malformed_ = 0;
+    if (!file_.open(path, errorMsg)) return false;
+    binary_ = file_.size() >= sizeof(kMagic) && std::memcmp(file_.data(), kMagic, sizeof(kMagic)) == 0;
+    if (binary_) pos_ = sizeof(kMagic);
+    return true;
+}
+
+bool TraceReader::next(TraceEvent& ev) {
+    if (!binary_) return nextCsv(ev);
+    if (pos_ + sizeof(TraceRecord) > file_.size()) return false;
+    TraceRecord r;
+    std::memcpy(&r, file_.data() + pos_, sizeof(r));
+    pos_ += sizeof(r);
+    file_.release(pos_);
+    ev.timeMs = static_cast<double>(r.timeUs) / 1000.0;
+    ev.u = r.u;
+    ev.v = r.v;
+    ev.weight = r.weight;
+    ev.status = r.status;
+    return true;
+}
+
+bool TraceReader::nextCsv(TraceEvent& ev) {
+    const char* base = file_.data();
+    const size_t size = file_.size();
+    while (pos_ < size) {
+        const char* line = base + pos_;
+        const char* nl = static_cast<const char*>(std::memchr(line, '\n', size - pos_));
+        const char* end = nl ? nl : base + size;
+        pos_ = static_cast<size_t>(end - base) + (nl ? 1 : 0);
+        file_.release(pos_);
+
+        Fields f{line, end};
+        const char *b, *e;
+        f.take(b, e);
+        if (b == e || *b == '#') continue;
+        if (!((*b >= '0' && *b <= '9') || *b == '.' || *b == '-')) continue; // header
+
+        bool ok = std::from_chars(b, e, ev.timeMs).ec == std::errc{};
+        f.take(b, e);
+        ok = ok && std::from_chars(b, e, ev.u).ec == std::errc{};
+        f.take(b, e);
+        ok = ok && std::from_chars(b, e, ev.v).ec == std::errc{};
+        ev.weight = std::numeric_limits<double>::quiet_NaN();
+        ev.status = -1;
+        if (ok && !f.atEnd()) {
+            f.take(b, e);
+            if (b != e) ok = std::from_chars(b, e, ev.weight).ec == std::errc{};
+        }
+        if (ok && !f.atEnd()) {
+            f.take(b, e);
+            const std::string_view s(b, static_cast<size_t>(e - b));
+            if (s == "UP" || s == "up" || s == "1") ev.status = 1;
+            else if (s == "DOWN" || s == "down" || s == "0") ev.status = 0;
+            else if (!s.empty()) ok = false;
+        }
+        if (!ok) {
+            ++malformed_;
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool TraceReader::writeBinary(const std::string& inPath, const std::string& outPath, std::string* errorMsg) {
+    TraceReader in;
+    if (!in.open(inPath, errorMsg)) return false;
+    std::ofstream ofs(outPath, std::ios::binary);
+    if (!ofs.is_open()) {
+        if (errorMsg) *errorMsg = "Failed to open output file";
+        return false;
+    }
+    ofs.write(kMagic, sizeof(kMagic));
+    std::vector<TraceRecord> buf;
+    buf.reserve(1 << 15);
+    TraceEvent ev;
+    auto flush = [&]{
+        ofs.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size() * sizeof(TraceRecord)));
+        buf.clear();
+    };
+    while (in.next(ev)) {
+        buf.push_back(TraceRecord{static_cast<int64_t>(std::llround(ev.timeMs * 1000.0)), ev.weight, ev.u, ev.v, ev.status, 0});
+        if (buf.size() == buf.capacity()) flush();
+    }
+    flush();
+    if (!ofs) {
+        if (errorMsg) *errorMsg = "Write failed";
+        return false;
+    }
+    return true;
+}
+
+} // namespace olsr
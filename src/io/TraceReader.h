@@ -0,0 +1,49 @@
+#pragma once
+
+#include "core/Graph.h"
+#include "io/MappedFile.h"
+
+#include <cstdint>
+#include <string>
+
+namespace olsr {
+
+struct TraceEvent {
+    double timeMs;
+    NodeId u;
+    NodeId v;
+    double weight; // NaN: keep the current weight
+    int status;    // -1: keep, 0: DOWN, 1: UP
+};
+
+// Streams link-metric events from a memory-mapped trace without loading it.
+//
+// CSV: one "time_ms,u,v,weight,status" per line. weight may be empty, status
+// is UP/DOWN/1/0 or empty. Blank lines, '#' comments and a header are skipped.
+// Binary: the 8-byte magic "OLSRTRC1", then 32-byte little-endian records
+// { int64 time_us; double weight; uint32 u; uint32 v; int32 status; uint32 0 }.
+class TraceReader {
+public:
+    // Returns true on success
+    bool open(const std::string& path, std::string* errorMsg = nullptr);
+    // Next well-formed event in file order; false at end of input.
+    bool next(TraceEvent& ev);
+
+    bool binary() const { return binary_; }
+    uint64_t malformed() const { return malformed_; }
+    size_t bytesRead() const { return pos_; }
+    size_t bytesTotal() const { return file_.size(); }
+
+    // Converts any readable trace to the binary format.
+    static bool writeBinary(const std::string& inPath, const std::string& outPath, std::string* errorMsg = nullptr);
+
+private:
+    bool nextCsv(TraceEvent& ev);
+
+    MappedFile file_;
+    size_t pos_ = 0;
+    bool binary_ = false;
+    uint64_t malformed_ = 0;
+};
+
+} // namespace olsr
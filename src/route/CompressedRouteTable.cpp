@@ -0,0 +1,239 @@
+#include "route/CompressedRouteTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace olsr {
+
+namespace {
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+void putZigzag(std::vector<uint8_t>& out, int64_t v) {
+    putVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+// Bounds-checked reader; running past the end yields zeros and sets ok = false.
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (p == end) {
+                ok = false;
+                return 0;
+            }
+            const uint8_t b = *p++;
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return v;
+    }
+    int64_t zigzag() {
+        const uint64_t v = varint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+    uint8_t byte() {
+        if (p == end) {
+            ok = false;
+            return 0;
+        }
+        return *p++;
+    }
+};
+
+constexpr double kCostScale = 1.0 / kCostQuantum;
+
+bool byDestination(const RouteEntry& a, const RouteEntry& b) { return a.destination < b.destination; }
+
+} // namespace
+
+void CompressedRouteTable::clear() {
+    index_.clear();
+    data_.clear();
+    count_ = 0;
+}
+
+void CompressedRouteTable::encode(const RouteTable& t) {
+    clear();
+    if (!std::is_sorted(t.begin(), t.end(), byDestination)) {
+        RouteTable sorted(t.begin(), t.end());
+        std::sort(sorted.begin(), sorted.end(), byDestination);
+        encode(sorted);
+        return;
+    }
+    count_ = static_cast<uint32_t>(t.size());
+    index_.reserve((t.size() + kBlock - 1) / kBlock);
+    for (size_t i = 0; i < t.size(); i += kBlock) {
+        index_.push_back({t[i].destination, static_cast<uint32_t>(data_.size())});
+        encodeBlock(t.data() + i, static_cast<uint32_t>(std::min<size_t>(kBlock, t.size() - i)));
+    }
+    data_.shrink_to_fit();
+}
+
+void CompressedRouteTable::encodeBlock(const RouteEntry* e, uint32_t n) {
+    int64_t q[kBlock];
+    uint64_t g = 0;
+    bool onGrid = true;
+    for (uint32_t i = 0; i < n; ++i) onGrid = onGrid && std::abs(e[i].total_cost) < kCostLimit;
+    for (uint32_t i = 0; i < n && onGrid; ++i) {
+        q[i] = std::llround(e[i].total_cost * kCostScale);
+        g = std::gcd(g, static_cast<uint64_t>(q[i]));
+    }
+    if (g == 0 && onGrid) g = 1;
+    putVarint(data_, g);
+
+    bool consecutive = true;
+    for (uint32_t i = 1; i < n && consecutive; ++i) consecutive = e[i].destination == e[i - 1].destination + 1;
+    data_.push_back(consecutive ? 1 : 0);
+    if (!consecutive) {
+        for (uint32_t i = 1; i < n; ++i) putVarint(data_, e[i].destination - e[i - 1].destination - 1);
+    }
+
+    uint32_t runs = 1;
+    for (uint32_t i = 1; i < n; ++i) runs += e[i].next_hop != e[i - 1].next_hop;
+    putVarint(data_, runs);
+    int64_t prevHop = 0;
+    for (uint32_t i = 0; i < n;) {
+        uint32_t j = i + 1;
+        while (j < n && e[j].next_hop == e[i].next_hop) ++j;
+        putVarint(data_, j - i - 1);
+        putZigzag(data_, static_cast<int64_t>(e[i].next_hop) - prevHop);
+        prevHop = e[i].next_hop;
+        i = j;
+    }
+
+    int64_t prev = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        putZigzag(data_, static_cast<int64_t>(e[i].hop_count) - prev);
+        prev = e[i].hop_count;
+    }
+    if (!onGrid) {
+        for (uint32_t i = 0; i < n; ++i) {
+            uint64_t bits;
+            std::memcpy(&bits, &e[i].total_cost, sizeof bits);
+            putVarint(data_, bits);
+        }
+        return;
+    }
+    prev = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const int64_t v = q[i] / static_cast<int64_t>(g);
+        putZigzag(data_, v - prev);
+        prev = v;
+    }
+}
+
+uint32_t CompressedRouteTable::decodeBlock(size_t b, RouteEntry* out) const {
+    const uint32_t n = static_cast<uint32_t>(std::min<size_t>(kBlock, count_ - b * kBlock));
+    Reader r{data_.data() + index_[b].offset, data_.data() + data_.size()};
+    const int64_t g = static_cast<int64_t>(r.varint());
+    const uint8_t flags = r.byte();
+
+    out[0].destination = index_[b].first;
+    for (uint32_t i = 1; i < n; ++i) {
+        const uint64_t gap = (flags & 1) ? 0 : r.varint();
+        out[i].destination = static_cast<NodeId>(out[i - 1].destination + 1 + gap);
+    }
+
+    const uint64_t runs = r.varint();
+    int64_t hop = 0;
+    uint32_t i = 0;
+    for (uint64_t k = 0; k < runs && r.ok; ++k) {
+        const uint64_t len = r.varint() + 1;
+        hop += r.zigzag();
+        for (uint64_t j = 0; j < len && i < n; ++j) out[i++].next_hop = static_cast<NodeId>(hop);
+    }
+    for (; i < n; ++i) out[i].next_hop = static_cast<NodeId>(hop);
+
+    int64_t prev = 0;
+    for (i = 0; i < n; ++i) {
+        prev += r.zigzag();
+        out[i].hop_count = static_cast<uint32_t>(prev);
+    }
+    if (g == 0) {
+        for (i = 0; i < n; ++i) {
+            const uint64_t bits = r.varint();
+            std::memcpy(&out[i].total_cost, &bits, sizeof bits);
+        }
+        return n;
+    }
+    prev = 0;
+    for (i = 0; i < n; ++i) {
+        prev += r.zigzag();
+        out[i].total_cost = static_cast<double>(prev * g) / kCostScale;
+    }
+    return n;
+}
+
+void CompressedRouteTable::decode(RouteTable& out) const {
+    out.resize(count_);
+    for (size_t b = 0; b < index_.size(); ++b) decodeBlock(b, out.data() + b * kBlock);
+}
+
+bool CompressedRouteTable::find(NodeId dst, RouteEntry& out) const {
+    auto it = std::upper_bound(index_.begin(), index_.end(), dst,
+                               [](NodeId id, const BlockRef& b) { return id < b.first; });
+    if (it == index_.begin()) return false;
+    RouteEntry block[kBlock];
+    const uint32_t n = decodeBlock(static_cast<size_t>(it - index_.begin()) - 1, block);
+    const RouteEntry* e = std::lower_bound(block, block + n, dst,
+                                           [](const RouteEntry& x, NodeId id) { return x.destination < id; });
+    if (e == block + n || e->destination != dst) return false;
+    out = *e;
+    return true;
+}
+
+// varint count, varint data size, data, then per block the gap from the
+// previous block's first destination and its encoded length.
+void CompressedRouteTable::serialize(std::vector<uint8_t>& out) const {
+    putVarint(out, count_);
+    putVarint(out, data_.size());
+    out.insert(out.end(), data_.begin(), data_.end());
+    NodeId prevFirst = 0;
+    for (size_t b = 0; b < index_.size(); ++b) {
+        const uint32_t next = b + 1 < index_.size() ? index_[b + 1].offset : static_cast<uint32_t>(data_.size());
+        putVarint(out, index_[b].first - prevFirst);
+        putVarint(out, next - index_[b].offset);
+        prevFirst = index_[b].first;
+    }
+}
+
+bool CompressedRouteTable::deserialize(const uint8_t*& p, const uint8_t* end) {
+    clear();
+    Reader r{p, end};
+    const uint64_t count = r.varint();
+    const uint64_t size = r.varint();
+    if (!r.ok || count > UINT32_MAX || size > static_cast<uint64_t>(end - r.p)) return false;
+    data_.assign(r.p, r.p + size);
+    r.p += size;
+    const uint64_t blocks = (count + kBlock - 1) / kBlock;
+    uint64_t first = 0, offset = 0;
+    index_.reserve(blocks);
+    for (uint64_t b = 0; b < blocks && r.ok; ++b) {
+        first += r.varint();
+        index_.push_back({static_cast<NodeId>(first), static_cast<uint32_t>(offset)});
+        offset += r.varint();
+    }
+    if (!r.ok || offset != size || first > UINT32_MAX) {
+        clear();
+        return false;
+    }
+    count_ = static_cast<uint32_t>(count);
+    p = r.p;
+    return true;
+}
+
+} // namespace olsr
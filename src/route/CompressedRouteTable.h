@@ -0,0 +1,54 @@
+#pragma once
+
+#include "route/Dijkstra.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace olsr {
+
+// A RouteTable packed to a few bytes per destination. Entries are taken in
+// ascending destination order and cut into blocks of kBlock; each block is
+// stored column by column:
+//   varint  cost divisor g (gcd of the block's quantized costs, >= 1; 0 if
+//           a cost is past the grid)
+//   byte    flags; bit 0: destinations are consecutive ids
+//   varint  destination gaps (d[i] - d[i-1] - 1), only without bit 0
+//   varint  run count, then per run: varint length - 1, zigzag next-hop delta
+//   zigzag  hop-count deltas
+//   zigzag  deltas of quantized cost / g, or with g = 0 varint double bits
+// A block index (first destination, byte offset) gives O(log n) lookup plus
+// decoding one block. Costs come back on the kCostQuantum grid that route
+// comparisons already use; those of kCostLimit or more come back exactly.
+class CompressedRouteTable {
+public:
+    static constexpr uint32_t kBlock = 64;
+
+    // Sorts a copy first if t is not ordered by destination.
+    void encode(const RouteTable& t);
+    void decode(RouteTable& out) const;
+    bool find(NodeId dst, RouteEntry& out) const;
+    void clear();
+
+    size_t size() const { return count_; }
+    size_t bytes() const { return data_.size() + index_.size() * sizeof(BlockRef); }
+
+    // Self-delimiting serialized form, for route archives.
+    void serialize(std::vector<uint8_t>& out) const;
+    bool deserialize(const uint8_t*& p, const uint8_t* end);
+
+private:
+    struct BlockRef {
+        NodeId first;
+        uint32_t offset;
+    };
+    // Decodes block b into out[0, n); returns n.
+    uint32_t decodeBlock(size_t b, RouteEntry* out) const;
+    void encodeBlock(const RouteEntry* e, uint32_t n);
+
+    std::vector<BlockRef> index_;
+    std::vector<uint8_t> data_;
+    uint32_t count_ = 0;
+};
+
+} // namespace olsr
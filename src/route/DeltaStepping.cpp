@@ -0,0 +1,227 @@
+#include "route/DeltaStepping.h"
+
+#include "core/Adjacency.h"
+#include "core/Metrics.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+
+namespace olsr {
+
+namespace {
+
+bool atomicMin(std::atomic<int64_t>& slot, int64_t value) {
+    int64_t cur = slot.load(std::memory_order_relaxed);
+    while (value < cur) {
+        if (slot.compare_exchange_weak(cur, value, std::memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+// Meyer & Sanders suggest delta ~ max weight / average degree; the 90th
+// percentile stands in for the maximum so a few outlier links do not
+// collapse everything into one bucket.
+int64_t autoDelta(const std::vector<int64_t>& qw, uint32_t n) {
+    if (qw.empty() || n == 0) return 1;
+    std::vector<int64_t> sample(qw);
+    auto p90 = sample.begin() + static_cast<ptrdiff_t>(sample.size() * 9 / 10);
+    std::nth_element(sample.begin(), p90, sample.end());
+    const int64_t minW = *std::min_element(sample.begin(), sample.end());
+    const double avgDeg = static_cast<double>(qw.size()) / n;
+    const int64_t d = static_cast<int64_t>(static_cast<double>(*p90) / std::max(1.0, avgDeg));
+    return std::max<int64_t>({d, minW, 1});
+}
+
+std::vector<int64_t> quantizedWeights(const Adjacency& adj) {
+    std::vector<int64_t> qw(adj.halfEdges());
+    for (size_t e = 0; e < qw.size(); ++e) qw[e] = quantizeCost(adj.weights[e]);
+    return qw;
+}
+
+} // namespace
+
+double DeltaSteppingEngine::bucketWidth(const Adjacency& adj) const {
+    const int64_t delta = (delta_ > 0.0) ? std::max<int64_t>(1, quantizeCost(delta_))
+                                         : autoDelta(quantizedWeights(adj), adj.size());
+    return static_cast<double>(delta) * kCostQuantum;
+}
+
+RouteTable DeltaSteppingEngine::compute(const Graph& g, NodeId source) const {
+    const Adjacency adj = Adjacency::build(g);
+    auto itSrc = adj.index.find(source);
+    if (itSrc == adj.index.end()) return {};
+    return compute(adj, itSrc->second);
+}
+
+RouteTable DeltaSteppingEngine::compute(const Adjacency& adj, uint32_t src) const {
+    OLSR_PHASE(DeltaStepping);
+    const uint32_t n = adj.size();
+    if (src >= n) return {};
+
+    // Per-row copy with light edges first so each phase scans a contiguous range.
+    const std::vector<int64_t> qw = quantizedWeights(adj);
+    const int64_t delta = (delta_ > 0.0) ? std::max<int64_t>(1, quantizeCost(delta_)) : autoDelta(qw, n);
+
+    std::vector<uint32_t> tgt(adj.targets);
+    std::vector<int64_t> w(qw);
+    std::vector<uint32_t> lightEnd(n);
+    for (uint32_t u = 0; u < n; ++u) {
+        uint32_t lo = adj.offsets[u], hi = adj.offsets[u + 1], mid = lo;
+        for (uint32_t e = lo; e < hi; ++e) {
+            if (qw[e] <= delta) { tgt[mid] = adj.targets[e]; w[mid] = qw[e]; ++mid; }
+        }
+        uint32_t h = mid;
+        for (uint32_t e = lo; e < hi; ++e) {
+            if (qw[e] > delta) { tgt[h] = adj.targets[e]; w[h] = qw[e]; ++h; }
+        }
+        lightEnd[u] = mid;
+    }
+
+    std::unique_ptr<std::atomic<int64_t>[]> dist(new std::atomic<int64_t>[n]);
+    for (uint32_t i = 0; i < n; ++i) dist[i].store(kCostInfinity, std::memory_order_relaxed);
+    dist[src].store(0, std::memory_order_relaxed);
+    std::vector<int64_t> expandedAt(n, -1); // distance a node was last expanded with
+
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<std::vector<uint32_t>> touched(pool.size());
+    // Sparse: only buckets that hold vertices exist, so a tiny delta costs map
+    // entries rather than memory proportional to the longest distance / delta.
+    std::map<int64_t, std::vector<uint32_t>> buckets;
+    buckets[0].push_back(src);
+
+    auto relaxRange = [&](const std::vector<uint32_t>& frontier, bool light) {
+        pool.parallelFor(frontier.size(), [&](size_t b, size_t e, unsigned worker){
+            auto& out = touched[worker];
+            const size_t before = out.size();
+            for (size_t i = b; i < e; ++i) {
+                const uint32_t u = frontier[i];
+                const int64_t du = dist[u].load(std::memory_order_relaxed);
+                const uint32_t lo = light ? adj.offsets[u] : lightEnd[u];
+                const uint32_t hi = light ? lightEnd[u] : adj.offsets[u + 1];
+                for (uint32_t k = lo; k < hi; ++k) {
+                    if (atomicMin(dist[tgt[k]], addCost(du, w[k]))) out.push_back(tgt[k]);
+                }
+            }
+            OLSR_COUNT(Relaxations, out.size() - before);
+        }, 64);
+        for (auto& out : touched) {
+            for (uint32_t v : out) buckets[dist[v].load(std::memory_order_relaxed) / delta].push_back(v);
+            out.clear();
+        }
+    };
+
+    // Relaxations only move vertices to the current bucket or later ones, so
+    // the lowest remaining bucket is always the next to settle.
+    std::vector<uint32_t> pending, frontier, settled;
+    while (!buckets.empty()) {
+        const int64_t bi = buckets.begin()->first;
+        settled.clear();
+        for (auto it = buckets.begin(); it != buckets.end() && it->first == bi; it = buckets.begin()) {
+            pending.swap(it->second);
+            buckets.erase(it);
+            frontier.clear();
+            for (uint32_t v : pending) {
+                const int64_t dv = dist[v].load(std::memory_order_relaxed);
+                if (dv / delta != bi || expandedAt[v] == dv) continue;
+                if (expandedAt[v] < 0) settled.push_back(v);
+                expandedAt[v] = dv;
+                frontier.push_back(v);
+            }
+            pending.clear();
+            relaxRange(frontier, true);
+        }
+        relaxRange(settled, false);
+    }
+
+    OLSR_COUNT(SpfRuns, 1);
+
+    // Rebuild the canonical tree: each node takes the equal-cost predecessor
+    // with the fewest hops, then the lowest id. Nodes are finished one
+    // distance at a time; zero-weight links (and any link at the end of the
+    // cost grid) tie nodes of the same distance, so each such group is
+    // settled by hops before anyone reads them.
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (i != src && dist[i].load(std::memory_order_relaxed) < kCostInfinity) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){
+        return dist[a].load(std::memory_order_relaxed) < dist[b].load(std::memory_order_relaxed);
+    });
+
+    std::vector<uint32_t> hops(n, 0), first(n, 0), best(n, n), bestEdge(n, 0);
+    std::vector<double> cost(n, 0.0);
+    std::vector<char> done(n, 0);
+    done[src] = 1;
+    auto offer = [&](uint32_t v, uint32_t u, uint32_t e) {
+        const uint32_t nh = hops[u] + 1;
+        if (best[v] != n && (nh > hops[v] || (nh == hops[v] && adj.ids[u] >= adj.ids[best[v]]))) return false;
+        best[v] = u;
+        bestEdge[v] = e;
+        hops[v] = nh;
+        return true;
+    };
+    auto finish = [&](uint32_t v) {
+        done[v] = 1;
+        cost[v] = cost[best[v]] + adj.weights[bestEdge[v]];
+        first[v] = (best[v] == src) ? v : first[best[v]];
+    };
+
+    using Item = std::pair<uint32_t, uint32_t>; // (hops, node), fewest hops on top
+    std::vector<Item> heap;
+    for (size_t g = 0, end = 0; g < order.size(); g = end) {
+        const int64_t d = dist[order[g]].load(std::memory_order_relaxed);
+        bool tied = false; // a link inside the group
+        for (end = g; end < order.size() && dist[order[end]].load(std::memory_order_relaxed) == d; ++end) {
+            const uint32_t v = order[end];
+            for (uint32_t e = adj.offsets[v]; e < adj.offsets[v + 1]; ++e) {
+                const uint32_t u = adj.targets[e];
+                if (addCost(dist[u].load(std::memory_order_relaxed), qw[e]) != d) continue;
+                if (done[u]) offer(v, u, e);
+                else tied = true;
+            }
+        }
+        if (!tied) {
+            for (size_t i = g; i < end; ++i) {
+                if (best[order[i]] != n) finish(order[i]);
+            }
+            continue;
+        }
+        heap.clear();
+        for (size_t i = g; i < end; ++i) {
+            if (best[order[i]] != n) heap.push_back({hops[order[i]], order[i]});
+        }
+        std::make_heap(heap.begin(), heap.end(), std::greater<Item>());
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Item>());
+            const auto [h, v] = heap.back();
+            heap.pop_back();
+            if (done[v] || h != hops[v]) continue;
+            finish(v);
+            for (uint32_t e = adj.offsets[v]; e < adj.offsets[v + 1]; ++e) {
+                const uint32_t w = adj.targets[e];
+                if (done[w] || dist[w].load(std::memory_order_relaxed) != d || addCost(d, qw[e]) != d) continue;
+                const uint32_t before = hops[w];
+                if (offer(w, v, e) && hops[w] != before) {
+                    heap.push_back({hops[w], w});
+                    std::push_heap(heap.begin(), heap.end(), std::greater<Item>());
+                }
+            }
+        }
+    }
+
+    RouteTable table;
+    table.reserve(order.size());
+    for (uint32_t v : order) {
+        if (hops[v] == 0) continue;
+        table.push_back(RouteEntry{adj.ids[v], adj.ids[first[v]], cost[v], hops[v]});
+    }
+    std::sort(table.begin(), table.end(), [](const RouteEntry& a, const RouteEntry& b){ return a.destination < b.destination; });
+    return table;
+}
+
+} // namespace olsr
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "core/Adjacency.h"
+#include "core/Graph.h"
+#include "route/Dijkstra.h"
+
+namespace olsr {
+
+// Parallel single-source engine for large topologies (Meyer & Sanders
+// delta-stepping). Tentative distances are quantized costs updated with an
+// atomic min; light edges (weight <= delta) are relaxed repeatedly inside a
+// bucket, heavy edges once the bucket settles. A final pass over the settled
+// order rebuilds first hop, hop count and cost with DijkstraEngine's
+// tie-breaking, so the resulting table is identical.
+class DeltaSteppingEngine {
+public:
+    RouteTable compute(const Graph& g, NodeId source) const;
+    // Same result over a prebuilt CSR snapshot, so a caller routing every
+    // source builds it once; `source` is a dense index.
+    RouteTable compute(const Adjacency& adj, uint32_t source) const;
+
+    // Bucket width in cost units; 0 (default) derives it from the weight
+    // distribution of each graph.
+    void setDelta(double delta) { delta_ = delta; }
+    double delta() const { return delta_; }
+    // Bucket width compute() uses on adj, in cost units.
+    double bucketWidth(const Adjacency& adj) const;
+
+private:
+    double delta_ = 0.0;
+};
+
+} // namespace olsr
@@ -1,50 +1,69 @@
 #include "route/Dijkstra.h"
 
-#include <limits>
+#include "core/Adjacency.h"
+#include "core/Metrics.h"
+
 #include <unordered_map>
 #include <algorithm>
 
 namespace olsr {
 
+template <class Key>
 struct PQNode {
     NodeId node;
-    double cost;
-    bool operator>(const PQNode& other) const { return cost > other.cost; }
+    Key cost;
 };
 
-RouteTable DijkstraEngine::compute(const Graph& g, NodeId source) const {
-    const double INF = std::numeric_limits<double>::infinity();
+template <class Policy>
+RouteTable BasicDijkstraEngine<Policy>::compute(const Graph& g, NodeId source) const {
+    OLSR_PHASE(Spf);
     std::unordered_map<NodeId, double> dist;
+    std::unordered_map<NodeId, Key> qdist;
     std::unordered_map<NodeId, NodeId> parent;
     std::unordered_map<NodeId, NodeId> firstHop;
     std::unordered_map<NodeId, uint32_t> hops;
 
     for (const auto& n : g.nodes()) {
-        dist[n.id] = INF;
+        dist[n.id] = 0.0;
+        qdist[n.id] = Policy::infinity();
         hops[n.id] = 0;
     }
-    dist[source] = 0.0;
+    dist[source] = Policy::kReportIdentity;
+    qdist[source] = Policy::identity();
 
-    std::priority_queue<PQNode, std::vector<PQNode>, std::greater<PQNode>> pq;
-    pq.push(PQNode{source, 0.0});
+    auto later = [](const PQNode<Key>& a, const PQNode<Key>& b) { return Policy::better(b.cost, a.cost); };
+    std::priority_queue<PQNode<Key>, std::vector<PQNode<Key>>, decltype(later)> pq(later);
+    pq.push(PQNode<Key>{source, Policy::identity()});
+    uint64_t pushes = 1, pops = 0, relaxations = 0;
 
     auto relax = [&](NodeId u, NodeId v, double w){
-        if (dist[u] + w < dist[v]) {
-            dist[v] = dist[u] + w;
-            parent[v] = u;
-            hops[v] = hops[u] + 1;
-            // establish first hop from source to v
-            if (u == source) firstHop[v] = v;
-            else firstHop[v] = firstHop[u];
-            pq.push(PQNode{v, dist[v]});
+        auto itV = qdist.find(v);
+        if (itV == qdist.end() || v == source) return;
+        const Key nq = Policy::combine(qdist[u], Policy::edge(w));
+        if (Policy::better(nq, itV->second)) {
+            itV->second = nq;
+            pq.push(PQNode<Key>{v, nq});
+            ++pushes;
+        } else if (nq != itV->second || !parent.count(v) || u >= parent[v]) {
+            return;
         }
+        // Strictly better, or a tie won by the lower predecessor id. Keys
+        // count hops, so v is still queued and has relaxed nothing yet.
+        dist[v] = Policy::report(dist[u], w);
+        parent[v] = u;
+        hops[v] = hops[u] + 1;
+        ++relaxations;
+        // establish first hop from source to v
+        if (u == source) firstHop[v] = v;
+        else firstHop[v] = firstHop[u];
     };
 
     // Build adjacency on the fly from links
     while (!pq.empty()) {
         auto [u, cost] = pq.top();
         pq.pop();
-        if (cost != dist[u]) continue;
+        ++pops;
+        if (cost != qdist[u]) continue;
 
         for (const auto& l : g.links()) {
             if (l.status != LinkStatus::UP) continue;
@@ -53,11 +72,15 @@ RouteTable DijkstraEngine::compute(const Graph& g, NodeId source) const {
         }
     }
 
+    OLSR_COUNT(SpfRuns, 1);
+    OLSR_COUNT(HeapPushes, pushes);
+    OLSR_COUNT(HeapPops, pops);
+    OLSR_COUNT(Relaxations, relaxations);
+
     RouteTable table;
     table.reserve(dist.size());
     for (const auto& [nid, d] : dist) {
         if (nid == source) continue;
-        if (d == INF) continue;
         auto itHop = firstHop.find(nid);
         if (itHop == firstHop.end()) continue;
         table.push_back(RouteEntry{nid, itHop->second, d, hops[nid]});
@@ -67,6 +90,102 @@ RouteTable DijkstraEngine::compute(const Graph& g, NodeId source) const {
     return table;
 }
 
-} // namespace olsr
+template <class Policy>
+void BasicDijkstraEngine<Policy>::tree(const Adjacency& adj, uint32_t source, Tree& out) const {
+    OLSR_PHASE(Spf);
+    const uint32_t n = static_cast<uint32_t>(adj.ids.size());
+    out.source = source;
+    out.qdist.assign(n, Policy::infinity());
+    out.dist.assign(n, 0.0);
+    out.parent.assign(n, n);
+    out.parentEdge.assign(n, 0);
+    out.firstHop.assign(n, n);
+    out.hops.assign(n, 0);
+    out.order.clear();
+    if (source >= n) return;
+    out.dist[source] = Policy::kReportIdentity;
+
+    std::vector<Key>& qdist = out.qdist;
+    std::vector<uint32_t>& parent = out.parent;
+    std::vector<uint32_t>& hops = out.hops;
+
+    using Item = std::pair<Key, uint32_t>;
+    // Binary heap with the best key on top, lower index first among equal
+    // keys.
+    auto later = [](const Item& a, const Item& b) {
+        return a.first != b.first ? Policy::better(b.first, a.first) : b.second < a.second;
+    };
+    std::vector<Item>& pq = out.heap;
+    pq.clear();
+    qdist[source] = Policy::identity();
+    pq.push_back({Policy::identity(), source});
+    // Counted locally and flushed once: keeps the relaxation loop free of TLS.
+    uint64_t pushes = 1, pops = 0, relaxations = 0;
+
+    while (!pq.empty()) {
+        std::pop_heap(pq.begin(), pq.end(), later);
+        auto [cost, u] = pq.back();
+        pq.pop_back();
+        ++pops;
+        if (cost != qdist[u]) continue;
+        out.order.push_back(u);
+        for (uint32_t e = adj.offsets[u]; e < adj.offsets[u + 1]; ++e) {
+            const uint32_t v = adj.targets[e];
+            if (v == source) continue;
+            const Key nq = Policy::combine(cost, Policy::edge(adj.weights[e]));
+            if (Policy::better(nq, qdist[v])) {
+                qdist[v] = nq;
+                pq.push_back({nq, v});
+                std::push_heap(pq.begin(), pq.end(), later);
+                ++pushes;
+            } else if (nq != qdist[v] || parent[v] == n || adj.ids[u] >= adj.ids[parent[v]]) {
+                continue;
+            }
+            // Keys count hops, so a tie reaches v while it is still queued.
+            out.dist[v] = Policy::report(out.dist[u], adj.weights[e]);
+            parent[v] = u;
+            out.parentEdge[v] = e;
+            hops[v] = hops[u] + 1;
+            out.firstHop[v] = (u == source) ? v : out.firstHop[u];
+            ++relaxations;
+        }
+    }
+    OLSR_COUNT(SpfRuns, 1);
+    OLSR_COUNT(HeapPushes, pushes);
+    OLSR_COUNT(HeapPops, pops);
+    OLSR_COUNT(Relaxations, relaxations);
+}
+
+template <class Policy>
+RouteTable BasicDijkstraEngine<Policy>::compute(const Adjacency& adj, uint32_t source) const {
+    Tree t;
+    tree(adj, source, t);
+    RouteTable out;
+    table(adj, t, out);
+    return out;
+}
+
+template <class Policy>
+void BasicDijkstraEngine<Policy>::table(const Adjacency& adj, const Tree& t, RouteTable& out) const {
+    const uint32_t n = static_cast<uint32_t>(adj.ids.size());
+    out.clear();
+    out.reserve(t.order.size());
+    for (uint32_t v : adj.byId) {
+        if (t.parent[v] == n) continue;
+        out.push_back(RouteEntry{adj.ids[v], adj.ids[t.firstHop[v]], t.dist[v], t.hops[v]});
+    }
+}
+
+template class BasicDijkstraEngine<ShortestRoutes>;
+template class BasicDijkstraEngine<WidestRoutes>;
+template class BasicDijkstraEngine<ReliableRoutes>;
 
+void PolicyDijkstra::table(RoutePolicy p, const Adjacency& adj, uint32_t source, RouteTable& out) {
+    switch (p) {
+    case RoutePolicy::Widest: widest_.table(adj, source, out); break;
+    case RoutePolicy::Reliable: reliable_.table(adj, source, out); break;
+    default: shortest_.table(adj, source, out); break;
+    }
+}
 
+} // namespace olsr
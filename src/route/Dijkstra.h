@@ -1,6 +1,10 @@
 #pragma once
 
 #include "core/Graph.h"
+#include "route/RoutePolicy.h"
+#include <cmath>
+#include <cstdint>
+#include <memory_resource>
 #include <queue>
 #include <unordered_map>
 
@@ -13,13 +17,76 @@ struct RouteEntry {
     uint32_t hop_count;
 };
 
-using RouteTable = std::vector<RouteEntry>;
+// Polymorphic allocator so a recompute generation can place all of its tables
+// in one arena (see Router); elsewhere they use the default heap resource.
+using RouteTable = std::pmr::vector<RouteEntry>;
+using RouteTableMap = std::pmr::unordered_map<NodeId, RouteTable>;
 
-class DijkstraEngine {
+struct Adjacency;
+
+// Shortest-path tree over dense Adjacency indices. Unreachable vertices and
+// the source have parent == adj.size(). Buffers are reused across calls. Key
+// is the policy's path key; for shortest paths, quantized cost and hops.
+template <class Key>
+struct BasicShortestPathTree {
+    uint32_t source = 0;
+    std::vector<Key> qdist;
+    std::vector<double> dist;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> parentEdge;  // half-edge parent -> v
+    std::vector<uint32_t> firstHop;
+    std::vector<uint32_t> hops;
+    std::vector<uint32_t> order;       // reachable vertices, each after its parent
+    std::vector<std::pair<Key, uint32_t>> heap; // scratch
+};
+using ShortestPathTree = BasicShortestPathTree<ShortestRoutes::Key>;
+
+// Best-path trees under a path algebra (see RoutePolicy.h). Instantiated in
+// Dijkstra.cpp for the policies behind RoutePolicy.
+template <class Policy>
+class BasicDijkstraEngine {
 public:
+    using Key = typename Policy::Key;
+    using Tree = BasicShortestPathTree<Key>;
+
     RouteTable compute(const Graph& g, NodeId source) const;
+    // Same result over a prebuilt CSR snapshot; `source` is a dense index and
+    // only adj.ids/offsets/targets/weights are read (edges may be directed).
+    RouteTable compute(const Adjacency& adj, uint32_t source) const;
+    // The tree behind compute(adj, source), with the canonical tie-break.
+    void tree(const Adjacency& adj, uint32_t source, Tree& out) const;
+    // Overwrites `out` (keeping its allocator and capacity) with t's routes.
+    void table(const Adjacency& adj, const Tree& t, RouteTable& out) const;
 };
 
-} // namespace olsr
+extern template class BasicDijkstraEngine<ShortestRoutes>;
+extern template class BasicDijkstraEngine<WidestRoutes>;
+extern template class BasicDijkstraEngine<ReliableRoutes>;
+
+using DijkstraEngine = BasicDijkstraEngine<ShortestRoutes>;
 
+// One engine and scratch tree per RoutePolicy, for callers that pick the
+// policy at run time (Lexicographic shares Shortest's). The choice is made once per tree, outside the relax
+// loop.
+class PolicyDijkstra {
+public:
+    void table(RoutePolicy p, const Adjacency& adj, uint32_t source, RouteTable& out);
+
+private:
+    template <class Policy>
+    struct Slot {
+        BasicDijkstraEngine<Policy> engine;
+        typename BasicDijkstraEngine<Policy>::Tree tree;
+
+        void table(const Adjacency& adj, uint32_t source, RouteTable& out) {
+            engine.tree(adj, source, tree);
+            engine.table(adj, tree, out);
+        }
+    };
 
+    Slot<ShortestRoutes> shortest_;
+    Slot<WidestRoutes> widest_;
+    Slot<ReliableRoutes> reliable_;
+};
+
+} // namespace olsr
@@ -0,0 +1,220 @@
+#include "route/FloydWarshall.h"
+
+#include "core/Adjacency.h"
+#include "core/Metrics.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace olsr {
+
+namespace {
+
+// Key layout: hop count in the high 32 bits, rank (by NodeId) of the node that
+// precedes the destination in the low 32 bits. Extending i->k by k->j adds the
+// hop counts and keeps k->j's predecessor: (key(i,k) & kHopMask) + key(k,j).
+constexpr uint64_t kHopMask = 0xFFFFFFFF00000000ull;
+// Diagonal marker: zero hops and a predecessor that loses every tie, so a
+// path i->j->j never displaces a real predecessor of j.
+constexpr uint64_t kSelfKey = 0x00000000FFFFFFFFull;
+
+struct Matrix {
+    size_t stride = 0;
+    std::vector<int64_t> dist;
+    std::vector<uint64_t> key;
+    bool saturates = false;  // two path costs can add up past the end of the grid
+};
+
+// Min-plus update of one row segment: row[j] = min(row[j], dik + krow[j]),
+// comparing (cost, key) lexicographically. Saturate sums through addCost.
+template <bool Saturate>
+inline void minPlusRow(int64_t* rowD, uint64_t* rowK, const int64_t* kD, const uint64_t* kK,
+                       int64_t dik, uint64_t kik, uint32_t len) {
+    const uint64_t hik = kik & kHopMask;
+    uint32_t j = 0;
+#if defined(__AVX2__)
+    const __m256i vdik = _mm256_set1_epi64x(dik);
+    const __m256i vhik = _mm256_set1_epi64x(static_cast<long long>(hik));
+    const __m256i vsat = _mm256_set1_epi64x(kCostSaturated);
+    for (; j + 4 <= len; j += 4) {
+        const __m256i kd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kD + j));
+        __m256i cd = _mm256_add_epi64(vdik, kd);
+        if constexpr (Saturate) {
+            // dik is finite, so a finite kD saturates and a missing one stays
+            // past the grid.
+            const __m256i over = _mm256_andnot_si256(_mm256_cmpgt_epi64(kd, vsat), _mm256_cmpgt_epi64(cd, vsat));
+            cd = _mm256_blendv_epi8(cd, vsat, over);
+        }
+        __m256i ck = _mm256_add_epi64(vhik, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kK + j)));
+        __m256i curD = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowD + j));
+        __m256i curK = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowK + j));
+        __m256i lt = _mm256_cmpgt_epi64(curD, cd);
+        __m256i eq = _mm256_andnot_si256(_mm256_cmpgt_epi64(cd, vsat), _mm256_cmpeq_epi64(cd, curD));
+        __m256i take = _mm256_or_si256(lt, _mm256_and_si256(eq, _mm256_cmpgt_epi64(curK, ck)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rowD + j), _mm256_blendv_epi8(curD, cd, take));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rowK + j), _mm256_blendv_epi8(curK, ck, take));
+    }
+#endif
+    for (; j < len; ++j) {
+        const int64_t cd = Saturate ? addCost(dik, kD[j]) : dik + kD[j];
+        const uint64_t ck = hik + kK[j];
+        if (cd < rowD[j] || (cd == rowD[j] && cd < kCostInfinity && ck < rowK[j])) {
+            rowD[j] = cd;
+            rowK[j] = ck;
+        }
+    }
+}
+
+// Relaxes tile (ib, jb) through the intermediate nodes of tile kb.
+void relaxTile(Matrix& m, size_t ib, size_t jb, size_t kb) {
+    const size_t T = FloydWarshallEngine::kTile;
+    const size_t s = m.stride;
+    int64_t* D = m.dist.data();
+    uint64_t* K = m.key.data();
+    for (size_t k = kb * T; k < (kb + 1) * T; ++k) {
+        const int64_t* kD = D + k * s + jb * T;
+        const uint64_t* kK = K + k * s + jb * T;
+        for (size_t i = ib * T; i < (ib + 1) * T; ++i) {
+            const int64_t dik = D[i * s + k];
+            if (dik >= kCostInfinity) continue;
+            if (m.saturates) minPlusRow<true>(D + i * s + jb * T, K + i * s + jb * T, kD, kK, dik, K[i * s + k], T);
+            else minPlusRow<false>(D + i * s + jb * T, K + i * s + jb * T, kD, kK, dik, K[i * s + k], T);
+        }
+    }
+}
+
+} // namespace
+
+void FloydWarshallEngine::computeAll(const Graph& g, RouteTableMap& out) const {
+    OLSR_PHASE(AllPairs);
+    out.clear();
+    const Adjacency adj = Adjacency::build(g);
+    const uint32_t n = adj.size();
+    if (n == 0) return;
+
+    // Tie-break ranks: predecessors compare by NodeId, not by storage position.
+    std::vector<uint32_t> byRank(n);
+    std::iota(byRank.begin(), byRank.end(), 0u);
+    std::stable_sort(byRank.begin(), byRank.end(), [&](uint32_t a, uint32_t b){ return adj.ids[a] < adj.ids[b]; });
+    std::vector<uint32_t> rank(n);
+    for (uint32_t r = 0; r < n; ++r) rank[byRank[r]] = r;
+
+    // Pad to whole tiles; padding rows/columns stay unreachable.
+    const size_t tiles = (n + kTile - 1) / kTile;
+    Matrix m;
+    m.stride = tiles * kTile;
+    m.dist.assign(m.stride * m.stride, kCostInfinity);
+    m.key.assign(m.stride * m.stride, 0);
+    std::vector<double> direct(static_cast<size_t>(n) * n, std::numeric_limits<double>::infinity());
+    for (size_t i = 0; i < m.stride; ++i) {
+        m.dist[i * m.stride + i] = 0;
+        m.key[i * m.stride + i] = kSelfKey;
+    }
+    // No path costs more than all links together; below half the grid the
+    // min-plus sums never need clamping.
+    int64_t total = 0;
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t e = adj.offsets[u]; e < adj.offsets[u + 1]; ++e) {
+            const uint32_t v = adj.targets[e];
+            if (v == u) continue;
+            const int64_t q = quantizeCost(adj.weights[e]);
+            if (q < kCostInfinity) total = addCost(total, q);
+            int64_t& d = m.dist[u * m.stride + v];
+            if (q < d) {
+                d = q;
+                m.key[u * m.stride + v] = (1ull << 32) | rank[u];
+                direct[static_cast<size_t>(u) * n + v] = adj.weights[e];
+            }
+        }
+    }
+    m.saturates = total >= kCostSaturated / 2;
+
+    // Blocked Floyd-Warshall: pivot tile, then its row and column, then the rest.
+    ThreadPool& pool = ThreadPool::shared();
+    for (size_t kb = 0; kb < tiles; ++kb) {
+        relaxTile(m, kb, kb, kb);
+        pool.parallelFor(2 * tiles, [&](size_t b, size_t e, unsigned){
+            for (size_t t = b; t < e; ++t) {
+                const size_t other = t % tiles;
+                if (other == kb) continue;
+                if (t < tiles) relaxTile(m, kb, other, kb);
+                else relaxTile(m, other, kb, kb);
+            }
+        });
+        pool.parallelFor(tiles * tiles, [&](size_t b, size_t e, unsigned){
+            for (size_t t = b; t < e; ++t) {
+                const size_t ib = t / tiles, jb = t % tiles;
+                if (ib == kb || jb == kb) continue;
+                relaxTile(m, ib, jb, kb);
+            }
+        });
+    }
+
+    // Emit tables. Visiting destinations by hop count lets each one extend its
+    // predecessor's cost and first hop, the same accumulation DijkstraEngine does.
+    // out's memory resource need not be thread-safe, so every table is sized
+    // here and the workers below only fill reserved capacity.
+    std::vector<uint32_t> reach(n, 0);
+    pool.parallelFor(n, [&](size_t b, size_t e, unsigned){
+        for (size_t s = b; s < e; ++s) {
+            const int64_t* D = m.dist.data() + s * m.stride;
+            uint32_t c = 0;
+            for (uint32_t d = 0; d < n; ++d) c += (d != s && D[d] < kCostInfinity);
+            reach[s] = c;
+        }
+    }, 64);
+    out.reserve(n);
+    std::vector<RouteTable*> tables(n);
+    for (uint32_t s = 0; s < n; ++s) {
+        tables[s] = &out[adj.ids[s]];
+        tables[s]->reserve(reach[s]);
+    }
+
+    // Past the end of the cost grid (cost, hops) is no longer isotone: the
+    // closure finds the least key over all paths, while every other backend
+    // extends each node's own best path. Rows that reach it take Dijkstra's
+    // tree instead, filled into the capacity reserved above.
+    pool.parallelFor(n, [&](size_t b, size_t e, unsigned){
+        std::vector<uint32_t> order;
+        std::vector<double> cost(n);
+        std::vector<uint32_t> first(n);
+        ShortestPathTree tree;
+        for (size_t s = b; s < e; ++s) {
+            const int64_t* D = m.dist.data() + s * m.stride;
+            const uint64_t* K = m.key.data() + s * m.stride;
+            if (std::find(D, D + n, kCostSaturated) != D + n) {
+                DijkstraEngine().tree(adj, static_cast<uint32_t>(s), tree);
+                for (uint32_t d : adj.byId) {
+                    if (tree.parent[d] == n) continue;
+                    tables[s]->push_back(RouteEntry{adj.ids[d], adj.ids[tree.firstHop[d]], tree.dist[d], tree.hops[d]});
+                }
+                continue;
+            }
+            order.clear();
+            for (uint32_t d = 0; d < n; ++d) {
+                if (d != s && D[d] < kCostInfinity) order.push_back(d);
+            }
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t c){ return K[a] < K[c]; });
+            for (uint32_t d : order) {
+                const uint32_t p = byRank[static_cast<uint32_t>(K[d])];
+                const double prev = (p == s) ? 0.0 : cost[p];
+                cost[d] = prev + direct[static_cast<size_t>(p) * n + d];
+                first[d] = (p == s) ? d : first[p];
+            }
+            RouteTable& tbl = *tables[s];
+            for (uint32_t r = 0; r < n; ++r) {
+                const uint32_t d = byRank[r];
+                if (d == s || D[d] >= kCostInfinity) continue;
+                tbl.push_back(RouteEntry{adj.ids[d], adj.ids[first[d]], cost[d], static_cast<uint32_t>(K[d] >> 32)});
+            }
+        }
+    }, 16);
+}
+
+} // namespace olsr
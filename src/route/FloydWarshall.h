@@ -0,0 +1,21 @@
+#pragma once
+
+#include "core/Graph.h"
+#include "route/Dijkstra.h"
+#include <unordered_map>
+
+namespace olsr {
+
+// Cache-blocked all-pairs backend for dense topologies. Quantized costs live in
+// one flat row-major int64 matrix processed in kTile x kTile tiles; each cell
+// also carries a packed (hop count, last predecessor) key so equal-cost ties
+// resolve exactly as in DijkstraEngine.
+class FloydWarshallEngine {
+public:
+    static constexpr uint32_t kTile = 64;
+
+    // Replaces `out` with one table per node, each sorted by destination.
+    void computeAll(const Graph& g, RouteTableMap& out) const;
+};
+
+} // namespace olsr
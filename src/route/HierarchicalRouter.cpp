@@ -0,0 +1,438 @@
+#include "route/HierarchicalRouter.h"
+
+#include "core/Metrics.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace olsr {
+
+namespace {
+constexpr uint32_t kNoBorder = UINT32_MAX;
+}
+
+void HierarchicalRouter::recomputeAll(const Graph& g) {
+    OLSR_PHASE(Areas);
+    adj_.assign(g);
+    partition(g);
+    buildAreas();
+    buildBackbone();
+}
+
+// Declared areas are used as given. Otherwise regions are grown breadth-first
+// up to the target size, seeding in global BFS order so neighbouring regions
+// stay compact; regions left under a quarter of the target are folded into
+// the neighbour they share most links with. Partitioning looks at every link
+// regardless of status so a flapping link does not reshuffle the areas.
+void HierarchicalRouter::partition(const Graph& g) {
+    const uint32_t n = adj_.size();
+    const std::vector<Node>& nodes = g.nodes();
+    std::vector<uint32_t> label(n, kNoBorder);
+    uint32_t count = 0;
+
+    declared_ = params_.useDeclared && n > 0 &&
+        std::all_of(nodes.begin(), nodes.end(), [](const Node& nd) { return nd.area >= 0; });
+    if (declared_) {
+        std::map<int32_t, uint32_t> compact;
+        for (const Node& nd : nodes) compact.emplace(nd.area, 0);
+        for (auto& [area, id] : compact) id = count++;
+        for (uint32_t i = 0; i < n; ++i) label[i] = compact[nodes[i].area];
+    } else if (n > 0) {
+        std::vector<uint32_t> off(n + 1, 0);
+        std::vector<uint32_t> nbr;
+        for (const Link& l : g.links()) {
+            auto a = adj_.index.find(l.u);
+            auto b = adj_.index.find(l.v);
+            if (a == adj_.index.end() || b == adj_.index.end()) continue;
+            ++off[a->second + 1];
+            ++off[b->second + 1];
+        }
+        for (uint32_t i = 0; i < n; ++i) off[i + 1] += off[i];
+        nbr.resize(off[n]);
+        {
+            std::vector<uint32_t> fill(off.begin(), off.end() - 1);
+            for (const Link& l : g.links()) {
+                auto a = adj_.index.find(l.u);
+                auto b = adj_.index.find(l.v);
+                if (a == adj_.index.end() || b == adj_.index.end()) continue;
+                nbr[fill[a->second]++] = b->second;
+                nbr[fill[b->second]++] = a->second;
+            }
+        }
+
+        const uint32_t target = params_.targetSize
+            ? params_.targetSize
+            : std::max<uint32_t>(16, static_cast<uint32_t>(2.0 * std::sqrt(static_cast<double>(n))));
+
+        std::vector<uint32_t> order;
+        order.reserve(n);
+        std::vector<char> seen(n, 0);
+        for (uint32_t r = 0; r < n; ++r) {
+            if (seen[r]) continue;
+            seen[r] = 1;
+            order.push_back(r);
+            for (size_t head = order.size() - 1; head < order.size(); ++head) {
+                const uint32_t u = order[head];
+                for (uint32_t e = off[u]; e < off[u + 1]; ++e) {
+                    if (!seen[nbr[e]]) {
+                        seen[nbr[e]] = 1;
+                        order.push_back(nbr[e]);
+                    }
+                }
+            }
+        }
+
+        std::vector<std::vector<uint32_t>> groups;
+        std::vector<uint32_t> queue;
+        for (uint32_t seed : order) {
+            if (label[seed] != kNoBorder) continue;
+            const uint32_t id = static_cast<uint32_t>(groups.size());
+            groups.emplace_back();
+            std::vector<uint32_t>& grp = groups.back();
+            queue.assign(1, seed);
+            label[seed] = id;
+            for (size_t head = 0; head < queue.size() && grp.size() < target; ++head) {
+                const uint32_t u = queue[head];
+                grp.push_back(u);
+                for (uint32_t e = off[u]; e < off[u + 1] && queue.size() < target; ++e) {
+                    const uint32_t v = nbr[e];
+                    if (label[v] != kNoBorder) continue;
+                    label[v] = id;
+                    queue.push_back(v);
+                }
+            }
+        }
+
+        const size_t small = std::max<size_t>(1, target / 4);
+        std::map<uint32_t, uint32_t> shared;
+        for (uint32_t a = 0; a < groups.size(); ++a) {
+            if (groups[a].empty() || groups[a].size() >= small) continue;
+            shared.clear();
+            for (uint32_t u : groups[a]) {
+                for (uint32_t e = off[u]; e < off[u + 1]; ++e) {
+                    if (label[nbr[e]] != a) ++shared[label[nbr[e]]];
+                }
+            }
+            uint32_t into = kNoBorder;
+            uint32_t best = 0;
+            for (auto [b, links] : shared) {
+                if (links > best && groups[b].size() + groups[a].size() <= target + target / 2) {
+                    into = b;
+                    best = links;
+                }
+            }
+            if (into == kNoBorder) continue;
+            for (uint32_t u : groups[a]) label[u] = into;
+            groups[into].insert(groups[into].end(), groups[a].begin(), groups[a].end());
+            groups[a].clear();
+        }
+
+        std::vector<uint32_t> renumber(groups.size(), kNoBorder);
+        for (uint32_t a = 0; a < groups.size(); ++a) {
+            if (!groups[a].empty()) renumber[a] = count++;
+        }
+        for (uint32_t i = 0; i < n; ++i) label[i] = renumber[label[i]];
+    }
+
+    areas_.assign(count, Area{});
+    areaOf_.assign(n, 0);
+    local_.assign(n, 0);
+    for (uint32_t i = 0; i < n; ++i) {
+        Area& a = areas_[label[i]];
+        areaOf_[i] = label[i];
+        local_[i] = static_cast<uint32_t>(a.members.size());
+        a.members.push_back(i);
+    }
+}
+
+void HierarchicalRouter::buildAreas() {
+    const uint32_t n = adj_.size();
+    ThreadPool& pool = ThreadPool::shared();
+
+    pool.parallelFor(areas_.size(), [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; ++k) {
+            Area& a = areas_[k];
+            const uint32_t m = static_cast<uint32_t>(a.members.size());
+            Adjacency& la = a.adj;
+            la.ids.resize(m);
+            la.offsets.assign(1, 0);
+            la.targets.clear();
+            la.weights.clear();
+            for (uint32_t i = 0; i < m; ++i) {
+                const uint32_t v = a.members[i];
+                la.ids[i] = adj_.ids[v];
+                bool border = false;
+                for (uint32_t e = adj_.offsets[v]; e < adj_.offsets[v + 1]; ++e) {
+                    const uint32_t t = adj_.targets[e];
+                    if (areaOf_[t] != k) {
+                        border = true;
+                        continue;
+                    }
+                    la.targets.push_back(local_[t]);
+                    la.weights.push_back(adj_.weights[e]);
+                }
+                la.offsets.push_back(static_cast<uint32_t>(la.targets.size()));
+                if (border) a.borders.push_back(i);
+            }
+            a.cells.assign(static_cast<size_t>(m) * m, Cell{});
+        }
+    });
+
+    // One intra-area tree per node; every source owns its own row.
+    DijkstraEngine spf;
+    std::vector<ShortestPathTree> trees(pool.size());
+    pool.parallelFor(n, [&](size_t begin, size_t end, unsigned w) {
+        ShortestPathTree& t = trees[w];
+        for (size_t v = begin; v < end; ++v) {
+            Area& a = areas_[areaOf_[v]];
+            const uint32_t m = static_cast<uint32_t>(a.members.size());
+            const uint32_t src = local_[v];
+            spf.tree(a.adj, src, t);
+            Cell* row = &a.cells[static_cast<size_t>(src) * m];
+            for (uint32_t j = 0; j < m; ++j) {
+                if (j == src) row[j] = Cell{0, 0.0, n, 0};
+                else if (t.parent[j] == m) row[j] = Cell{kCostInfinity, 0.0, n, 0};
+                else row[j] = Cell{t.qdist[j].first, t.dist[j], a.members[t.firstHop[j]], t.hops[j]};
+            }
+        }
+    }, 16);
+}
+
+void HierarchicalRouter::buildBackbone() {
+    const uint32_t n = adj_.size();
+    borders_.clear();
+    borderId_.assign(n, kNoBorder);
+    for (const Area& a : areas_) {
+        for (uint32_t lb : a.borders) borders_.push_back(a.members[lb]);
+    }
+    std::sort(borders_.begin(), borders_.end());
+    const uint32_t nb = static_cast<uint32_t>(borders_.size());
+    for (uint32_t b = 0; b < nb; ++b) borderId_[borders_[b]] = b;
+
+    // Inter-area links, then one abstract edge per reachable border pair.
+    bbOffsets_.assign(1, 0);
+    bbTargets_.clear();
+    bbEdges_.clear();
+    for (uint32_t b = 0; b < nb; ++b) {
+        const uint32_t v = borders_[b];
+        const Area& a = areas_[areaOf_[v]];
+        for (uint32_t e = adj_.offsets[v]; e < adj_.offsets[v + 1]; ++e) {
+            const uint32_t t = adj_.targets[e];
+            if (areaOf_[t] == areaOf_[v]) continue;
+            bbTargets_.push_back(borderId_[t]);
+            bbEdges_.push_back(Cell{quantizeCost(adj_.weights[e]), adj_.weights[e], t, 1});
+        }
+        for (uint32_t lb : a.borders) {
+            const uint32_t w = a.members[lb];
+            if (w == v) continue;
+            const Cell& c = intra(v, w);
+            if (c.q >= kCostInfinity) continue;
+            bbTargets_.push_back(borderId_[w]);
+            bbEdges_.push_back(c);
+        }
+        bbOffsets_.push_back(static_cast<uint32_t>(bbTargets_.size()));
+    }
+
+    // All-pairs over the backbone, tie-broken like DijkstraEngine:
+    // quantized cost, then real hop count, then lower predecessor id.
+    bb_.assign(static_cast<size_t>(nb) * nb, Cell{});
+    struct Scratch {
+        std::vector<NodeId> pred;
+        std::vector<char> done;
+        std::vector<std::pair<int64_t, uint32_t>> heap;
+    };
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<Scratch> scratch(pool.size());
+    pool.parallelFor(nb, [&](size_t begin, size_t end, unsigned w) {
+        Scratch& s = scratch[w];
+        for (size_t src = begin; src < end; ++src) {
+            Cell* row = &bb_[src * nb];
+            s.pred.assign(nb, UINT32_MAX);
+            s.done.assign(nb, 0);
+            s.heap.clear();
+            row[src] = Cell{0, 0.0, n, 0};
+            s.heap.push_back({0, static_cast<uint32_t>(src)});
+            uint64_t pushes = 1, pops = 0, relaxations = 0;
+            while (!s.heap.empty()) {
+                std::pop_heap(s.heap.begin(), s.heap.end(), std::greater<>());
+                const auto [q, u] = s.heap.back();
+                s.heap.pop_back();
+                ++pops;
+                if (s.done[u] || q != row[u].q) continue;
+                s.done[u] = 1;
+                const NodeId uid = adj_.ids[borders_[u]];
+                for (uint32_t e = bbOffsets_[u]; e < bbOffsets_[u + 1]; ++e) {
+                    const uint32_t v = bbTargets_[e];
+                    if (s.done[v]) continue;
+                    const Cell& ec = bbEdges_[e];
+                    const int64_t nq = addCost(row[u].q, ec.q);
+                    const uint32_t nh = row[u].hops + ec.hops;
+                    ++relaxations;
+                    if (nq < row[v].q ||
+                        (nq == row[v].q && (nh < row[v].hops || (nh == row[v].hops && uid < s.pred[v])))) {
+                        const bool improved = nq < row[v].q;
+                        row[v] = Cell{nq, row[u].dist + ec.dist, u == src ? ec.first : row[u].first, nh};
+                        s.pred[v] = uid;
+                        if (improved) {
+                            s.heap.push_back({nq, v});
+                            std::push_heap(s.heap.begin(), s.heap.end(), std::greater<>());
+                            ++pushes;
+                        }
+                    }
+                }
+            }
+            OLSR_COUNT(SpfRuns, 1);
+            OLSR_COUNT(HeapPushes, pushes);
+            OLSR_COUNT(HeapPops, pops);
+            OLSR_COUNT(Relaxations, relaxations);
+        }
+    });
+}
+
+const HierarchicalRouter::Cell& HierarchicalRouter::intra(uint32_t v, uint32_t w) const {
+    const Area& a = areas_[areaOf_[v]];
+    return a.cells[static_cast<size_t>(local_[v]) * a.members.size() + local_[w]];
+}
+
+bool HierarchicalRouter::better(const Cell& a, const Cell& b) const {
+    if (a.q != b.q) return a.q < b.q;
+    if (a.hops != b.hops) return a.hops < b.hops;
+    const uint32_t n = adj_.size();
+    const NodeId fa = a.first < n ? adj_.ids[a.first] : 0;
+    const NodeId fb = b.first < n ? adj_.ids[b.first] : 0;
+    return fa < fb;
+}
+
+HierarchicalRouter::Cell HierarchicalRouter::join(const Cell& a, const Cell& b) const {
+    if (a.q >= kCostInfinity || b.q >= kCostInfinity) return Cell{kCostInfinity, 0.0, adj_.size(), 0};
+    return Cell{addCost(a.q, b.q), a.dist + b.dist, a.hops > 0 ? a.first : b.first, a.hops + b.hops};
+}
+
+RouteEntry HierarchicalRouter::entry(uint32_t dst, const Cell& c) const {
+    return RouteEntry{adj_.ids[dst], adj_.ids[c.first], c.dist, c.hops};
+}
+
+// Best known way from s to every border: leave s's area through one of its
+// own borders, then follow the backbone.
+void HierarchicalRouter::composeVia(uint32_t s, std::vector<Cell>& via) const {
+    const size_t nb = borders_.size();
+    via.assign(nb, Cell{kCostInfinity, 0.0, adj_.size(), 0});
+    const Area& a = areas_[areaOf_[s]];
+    for (uint32_t lb : a.borders) {
+        const uint32_t b1 = a.members[lb];
+        const Cell& seg = intra(s, b1);
+        if (seg.q >= kCostInfinity) continue;
+        const Cell* row = &bb_[static_cast<size_t>(borderId_[b1]) * nb];
+        for (size_t b = 0; b < nb; ++b) {
+            const Cell c = join(seg, row[b]);
+            if (better(c, via[b])) via[b] = c;
+        }
+    }
+}
+
+RouteTable HierarchicalRouter::table(NodeId src) const {
+    RouteTable out;
+    auto it = adj_.index.find(src);
+    if (it == adj_.index.end()) return out;
+    const uint32_t s = it->second;
+    const uint32_t n = adj_.size();
+    std::vector<Cell> via;
+    composeVia(s, via);
+    for (uint32_t t = 0; t < n; ++t) {
+        if (t == s) continue;
+        Cell best = areaOf_[t] == areaOf_[s] ? intra(s, t) : Cell{kCostInfinity, 0.0, n, 0};
+        const Area& c = areas_[areaOf_[t]];
+        for (uint32_t lb : c.borders) {
+            const uint32_t b2 = c.members[lb];
+            const Cell cand = join(via[borderId_[b2]], intra(b2, t));
+            if (better(cand, best)) best = cand;
+        }
+        if (best.q < kCostInfinity) out.push_back(entry(t, best));
+    }
+    if (!std::is_sorted(out.begin(), out.end(),
+                        [](const RouteEntry& x, const RouteEntry& y) { return x.destination < y.destination; })) {
+        std::sort(out.begin(), out.end(),
+                  [](const RouteEntry& x, const RouteEntry& y) { return x.destination < y.destination; });
+    }
+    return out;
+}
+
+bool HierarchicalRouter::route(NodeId src, NodeId dst, RouteEntry& out) const {
+    auto is = adj_.index.find(src);
+    auto it = adj_.index.find(dst);
+    if (is == adj_.index.end() || it == adj_.index.end() || is->second == it->second) return false;
+    const uint32_t s = is->second;
+    const uint32_t t = it->second;
+    const uint32_t n = adj_.size();
+    const size_t nb = borders_.size();
+    Cell best = areaOf_[t] == areaOf_[s] ? intra(s, t) : Cell{kCostInfinity, 0.0, n, 0};
+    const Area& a = areas_[areaOf_[s]];
+    const Area& c = areas_[areaOf_[t]];
+    for (uint32_t lb1 : a.borders) {
+        const uint32_t b1 = a.members[lb1];
+        const Cell& seg = intra(s, b1);
+        if (seg.q >= kCostInfinity) continue;
+        for (uint32_t lb2 : c.borders) {
+            const uint32_t b2 = c.members[lb2];
+            const Cell cand =
+                join(join(seg, bb_[static_cast<size_t>(borderId_[b1]) * nb + borderId_[b2]]), intra(b2, t));
+            if (better(cand, best)) best = cand;
+        }
+    }
+    if (best.q >= kCostInfinity) return false;
+    out = entry(t, best);
+    return true;
+}
+
+RouteTable HierarchicalRouter::areaTable(NodeId src) const {
+    RouteTable out;
+    auto it = adj_.index.find(src);
+    if (it == adj_.index.end()) return out;
+    const uint32_t s = it->second;
+    const Area& a = areas_[areaOf_[s]];
+    for (uint32_t t : a.members) {
+        const Cell& c = intra(s, t);
+        if (t != s && c.q < kCostInfinity) out.push_back(entry(t, c));
+    }
+    return out;
+}
+
+int32_t HierarchicalRouter::areaOf(NodeId id) const {
+    auto it = adj_.index.find(id);
+    if (it == adj_.index.end() || areaOf_.empty()) return -1;
+    return static_cast<int32_t>(areaOf_[it->second]);
+}
+
+std::vector<NodeId> HierarchicalRouter::areaNodes(uint32_t area) const {
+    std::vector<NodeId> out;
+    if (area >= areas_.size()) return out;
+    for (uint32_t v : areas_[area].members) out.push_back(adj_.ids[v]);
+    return out;
+}
+
+std::vector<NodeId> HierarchicalRouter::areaBorders(uint32_t area) const {
+    std::vector<NodeId> out;
+    if (area >= areas_.size()) return out;
+    for (uint32_t lb : areas_[area].borders) out.push_back(adj_.ids[areas_[area].members[lb]]);
+    return out;
+}
+
+size_t HierarchicalRouter::tableEntries() const {
+    size_t cells = bb_.size();
+    for (const Area& a : areas_) cells += a.cells.size();
+    return cells;
+}
+
+size_t HierarchicalRouter::memoryBytes() const {
+    size_t bytes = (tableEntries() + bbEdges_.size()) * sizeof(Cell) +
+                   (bbTargets_.size() + bbOffsets_.size()) * sizeof(uint32_t);
+    for (const Area& a : areas_) {
+        bytes += a.adj.targets.size() * (sizeof(uint32_t) + sizeof(double)) +
+                 (a.adj.offsets.size() + a.adj.ids.size() + a.members.size() + a.borders.size()) * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+} // namespace olsr
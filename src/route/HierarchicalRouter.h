@@ -0,0 +1,92 @@
+#pragma once
+
+#include "core/Adjacency.h"
+#include "core/Graph.h"
+#include "route/Dijkstra.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace olsr {
+
+struct AreaParams {
+    bool useDeclared = true;  // take Node::area when every node declares one
+    uint32_t targetSize = 0;  // automatic partition: nodes per area, 0 = about 2*sqrt(N)
+};
+
+// Two-level routing for topologies too large for flat all-pairs tables.
+// Nodes are split into areas; every area keeps a dense table over its own
+// links only, and the border routers (nodes with a link into another area)
+// form a backbone whose edges are the inter-area links plus one abstract edge
+// per border pair of an area, weighted by their intra-area distance. A route
+// is composed at lookup time as source -> border -> backbone -> border ->
+// destination, so memory is sum(area size^2) + borders^2 instead of N^2.
+//
+// Composed costs are exact shortest-path costs over the UP links. Among
+// equal-cost paths the choice may differ from Router's canonical tree.
+class HierarchicalRouter {
+public:
+    explicit HierarchicalRouter(AreaParams params = {}) : params_(params) {}
+
+    void setParams(const AreaParams& p) { params_ = p; }
+    const AreaParams& params() const { return params_; }
+
+    void recomputeAll(const Graph& g);
+
+    // Composed view: routes to every reachable node, sorted by destination.
+    RouteTable table(NodeId src) const;
+    bool route(NodeId src, NodeId dst, RouteEntry& out) const;
+    // Area-local view: routes to src's own area over intra-area links only.
+    RouteTable areaTable(NodeId src) const;
+
+    bool declared() const { return declared_; }
+    uint32_t areaCount() const { return static_cast<uint32_t>(areas_.size()); }
+    int32_t areaOf(NodeId id) const;                          // -1 if unknown
+    std::vector<NodeId> areaNodes(uint32_t area) const;
+    std::vector<NodeId> areaBorders(uint32_t area) const;
+    size_t borderCount() const { return borders_.size(); }
+    size_t backboneEdges() const { return bbTargets_.size(); }
+    // Stored cells: sum of squared area sizes plus borders^2.
+    size_t tableEntries() const;
+    size_t memoryBytes() const;
+
+private:
+    // One stored route: quantized and reported cost, first hop as a dense
+    // node index (n = none or unreachable), hop count.
+    struct Cell {
+        int64_t q = kCostInfinity;
+        double dist = 0.0;
+        uint32_t first = 0;
+        uint32_t hops = 0;
+    };
+    struct Area {
+        std::vector<uint32_t> members;  // dense indices, ascending
+        std::vector<uint32_t> borders;  // local indices of border members
+        std::vector<Cell> cells;        // members^2, row = source
+        Adjacency adj;                  // intra-area UP links, local indices
+    };
+
+    void partition(const Graph& g);
+    void buildAreas();
+    void buildBackbone();
+    const Cell& intra(uint32_t v, uint32_t w) const; // v, w dense, same area
+    void composeVia(uint32_t s, std::vector<Cell>& via) const;
+    bool better(const Cell& a, const Cell& b) const;
+    Cell join(const Cell& a, const Cell& b) const;
+    RouteEntry entry(uint32_t dst, const Cell& c) const;
+
+    AreaParams params_;
+    bool declared_ = false;
+    Adjacency adj_;
+    std::vector<Area> areas_;
+    std::vector<uint32_t> areaOf_;    // dense index -> area
+    std::vector<uint32_t> local_;     // dense index -> position in its area
+    std::vector<uint32_t> borders_;   // backbone vertex -> dense index
+    std::vector<uint32_t> borderId_;  // dense index -> backbone vertex or UINT32_MAX
+    std::vector<uint32_t> bbOffsets_; // backbone CSR
+    std::vector<uint32_t> bbTargets_;
+    std::vector<Cell> bbEdges_;       // per backbone half-edge: cost, real first hop, hops
+    std::vector<Cell> bb_;            // borders^2, row = source border
+};
+
+} // namespace olsr
@@ -0,0 +1,443 @@
+#include "route/KShortestPaths.h"
+
+#include "core/Metrics.h"
+#include "core/ThreadPool.h"
+#include "route/Dijkstra.h"
+
+#include <algorithm>
+#include <set>
+
+namespace olsr {
+
+namespace {
+
+// A path over dense indices: links[i] and weights[i] join nodes[i] and nodes[i + 1].
+struct DensePath {
+    std::vector<uint32_t> nodes;
+    std::vector<uint32_t> links;
+    std::vector<double> weights;
+    int64_t q = 0;
+    double cost = 0.0;
+    uint32_t deviation = 0;  // first index where it leaves the path it was spurred from
+
+    void finish() {
+        q = 0;
+        cost = 0.0;
+        for (double w : weights) {
+            q = addCost(q, quantizeCost(w));
+            cost += w;
+        }
+    }
+};
+
+// Dense indices follow the storage order, so the last tie-break maps them
+// back to node ids.
+bool shorter(const Adjacency& adj, const DensePath& a, const DensePath& b) {
+    if (a.q != b.q) return a.q < b.q;
+    if (a.nodes.size() != b.nodes.size()) return a.nodes.size() < b.nodes.size();
+    for (size_t i = 0; i < a.nodes.size(); ++i) {
+        if (a.nodes[i] != b.nodes[i]) return adj.ids[a.nodes[i]] < adj.ids[b.nodes[i]];
+    }
+    return false;
+}
+
+struct Scratch {
+    ShortestPathTree tree;
+    // Yen: removed nodes and links for the current spur, by epoch.
+    std::vector<uint32_t> nodeMark;
+    std::vector<uint32_t> linkMark;
+    uint32_t epoch = 0;
+    // Search state shared by A* and the residual Dijkstra.
+    std::vector<double> dist;
+    std::vector<uint32_t> seen;
+    std::vector<uint32_t> done;
+    uint32_t search = 0;
+    std::vector<uint32_t> prevNode;
+    std::vector<uint32_t> prevEdge;
+    std::vector<std::pair<double, uint32_t>> heap;
+    // Edge-disjoint: unit flow per half-edge and node potentials.
+    std::vector<uint8_t> flow;
+    std::vector<uint32_t> used;
+    std::vector<double> pi;
+
+    void prepare(uint32_t n, size_t halfEdges, size_t links) {
+        nodeMark.resize(n, 0);
+        linkMark.resize(links, 0);
+        dist.resize(n);
+        seen.resize(n, 0);
+        done.resize(n, 0);
+        prevNode.resize(n);
+        prevEdge.resize(n);
+        flow.resize(halfEdges, 0);
+        pi.resize(n);
+    }
+    uint32_t nextEpoch() {
+        if (++epoch == 0) {
+            std::fill(nodeMark.begin(), nodeMark.end(), 0);
+            std::fill(linkMark.begin(), linkMark.end(), 0);
+            epoch = 1;
+        }
+        return epoch;
+    }
+    uint32_t nextSearch() {
+        if (++search == 0) {
+            std::fill(seen.begin(), seen.end(), 0);
+            std::fill(done.begin(), done.end(), 0);
+            search = 1;
+        }
+        return search;
+    }
+};
+
+class PathSearch {
+public:
+    PathSearch(const Adjacency& adj, const std::vector<uint32_t>& rev, size_t links, Scratch& s)
+        : adj_(adj), rev_(rev), n_(adj.size()), s_(s) {
+        s_.prepare(n_, adj.halfEdges(), links);
+    }
+
+    // Reverse tree towards t; the graph is undirected, so a tree from t gives
+    // every vertex its distance to t and its next hop along parent.
+    void target(uint32_t t) {
+        t_ = t;
+        DijkstraEngine().tree(adj_, t, s_.tree);
+    }
+
+    void loopless(uint32_t src, uint32_t k, std::vector<DensePath>& out) {
+        out.clear();
+        if (!reaches(src) || src == t_ || k == 0) return;
+        out.push_back(treePath(src));
+        std::vector<DensePath> candidates;
+        std::set<std::vector<uint32_t>> known{out.front().nodes};
+        auto worse = [this](const DensePath& a, const DensePath& b) { return shorter(adj_, b, a); };
+        auto better = [this](const DensePath& a, const DensePath& b) { return shorter(adj_, a, b); };
+
+        while (out.size() < k) {
+            const DensePath prev = out.back();
+            for (uint32_t i = prev.deviation; i + 1 < prev.nodes.size(); ++i) {
+                const uint32_t spur = prev.nodes[i];
+                const uint32_t epoch = s_.nextEpoch();
+                for (const DensePath& p : out) {
+                    if (p.nodes.size() > i + 1 && std::equal(p.nodes.begin(), p.nodes.begin() + i + 1, prev.nodes.begin())) {
+                        blockPair(p.nodes[i], p.nodes[i + 1], epoch);
+                    }
+                }
+                for (uint32_t j = 0; j < i; ++j) s_.nodeMark[prev.nodes[j]] = epoch;
+
+                DensePath cand;
+                cand.nodes.assign(prev.nodes.begin(), prev.nodes.begin() + i);
+                cand.links.assign(prev.links.begin(), prev.links.begin() + i);
+                cand.weights.assign(prev.weights.begin(), prev.weights.begin() + i);
+                if (!treeSpur(spur, epoch, cand) && !astarSpur(spur, epoch, cand)) continue;
+                cand.deviation = i;
+                cand.finish();
+                if (!known.insert(cand.nodes).second) continue;
+                candidates.push_back(std::move(cand));
+                std::push_heap(candidates.begin(), candidates.end(), worse);
+            }
+            if (candidates.empty()) break;
+            std::pop_heap(candidates.begin(), candidates.end(), worse);
+            out.push_back(std::move(candidates.back()));
+            candidates.pop_back();
+        }
+        // Spur searches return one best spur each, so a path can come out
+        // after an equal-cost one it should precede.
+        std::sort(out.begin(), out.end(), better);
+    }
+
+    // Successive shortest paths with unit capacity per direction of every
+    // link; a later path may cancel flow on a link an earlier one used, which
+    // is what makes the set optimal rather than greedy.
+    void disjoint(uint32_t src, uint32_t k, std::vector<DensePath>& out) {
+        out.clear();
+        if (!reaches(src) || src == t_ || k == 0) return;
+        const ShortestPathTree& tree = s_.tree;
+        for (uint32_t v = 0; v < n_; ++v) s_.pi[v] = reaches(v) ? -tree.dist[v] : 0.0;
+        if (t_ < n_) s_.pi[t_] = 0.0;
+
+        uint32_t found = 0;
+        uint64_t pushes = 0, pops = 0, relaxations = 0;
+        while (found < k) {
+            const uint32_t run = s_.nextSearch();
+            s_.heap.clear();
+            s_.dist[src] = 0.0;
+            s_.seen[src] = run;
+            s_.heap.push_back({0.0, src});
+            ++pushes;
+            while (!s_.heap.empty()) {
+                std::pop_heap(s_.heap.begin(), s_.heap.end(), std::greater<>());
+                const auto [d, v] = s_.heap.back();
+                s_.heap.pop_back();
+                ++pops;
+                if (s_.done[v] == run || d != s_.dist[v]) continue;
+                s_.done[v] = run;
+                if (v == t_) break;
+                for (uint32_t e = adj_.offsets[v]; e < adj_.offsets[v + 1]; ++e) {
+                    const uint32_t b = adj_.targets[e];
+                    if (!reaches(b) || s_.done[b] == run) continue;
+                    double c;
+                    if (s_.flow[rev_[e]]) c = -adj_.weights[e];
+                    else if (!s_.flow[e]) c = adj_.weights[e];
+                    else continue;
+                    ++relaxations;
+                    const double nd = d + std::max(0.0, c + s_.pi[v] - s_.pi[b]);
+                    if (s_.seen[b] != run || nd < s_.dist[b]) {
+                        s_.seen[b] = run;
+                        s_.dist[b] = nd;
+                        s_.prevNode[b] = v;
+                        s_.prevEdge[b] = e;
+                        s_.heap.push_back({nd, b});
+                        std::push_heap(s_.heap.begin(), s_.heap.end(), std::greater<>());
+                        ++pushes;
+                    }
+                }
+            }
+            if (s_.done[t_] != run) break;
+            const double dt = s_.dist[t_];
+            for (uint32_t v = 0; v < n_; ++v) s_.pi[v] += s_.seen[v] == run ? std::min(s_.dist[v], dt) : dt;
+            for (uint32_t v = t_; v != src; v = s_.prevNode[v]) {
+                const uint32_t e = s_.prevEdge[v];
+                if (s_.flow[rev_[e]]) {
+                    s_.flow[rev_[e]] = 0;
+                } else {
+                    s_.flow[e] = 1;
+                    s_.used.push_back(e);
+                }
+            }
+            ++found;
+        }
+        OLSR_COUNT(SpfRuns, found + 1);
+        OLSR_COUNT(HeapPushes, pushes);
+        OLSR_COUNT(HeapPops, pops);
+        OLSR_COUNT(Relaxations, relaxations);
+
+        // Split the flow into paths, cutting any zero-cost cycle it contains.
+        for (uint32_t p = 0; p < found; ++p) {
+            const uint32_t mark = s_.nextEpoch();
+            DensePath path;
+            path.nodes.push_back(src);
+            s_.nodeMark[src] = mark;
+            for (uint32_t v = src; v != t_;) {
+                uint32_t e = adj_.offsets[v];
+                while (!s_.flow[e]) ++e;
+                s_.flow[e] = 0;
+                const uint32_t b = adj_.targets[e];
+                if (s_.nodeMark[b] == mark) {
+                    while (path.nodes.back() != b) {
+                        s_.nodeMark[path.nodes.back()] = 0;
+                        path.nodes.pop_back();
+                        path.links.pop_back();
+                        path.weights.pop_back();
+                    }
+                } else {
+                    s_.nodeMark[b] = mark;
+                    path.nodes.push_back(b);
+                    path.links.push_back(adj_.linkIndex[e]);
+                    path.weights.push_back(adj_.weights[e]);
+                }
+                v = b;
+            }
+            path.finish();
+            out.push_back(std::move(path));
+        }
+        for (uint32_t e : s_.used) s_.flow[e] = 0;
+        s_.used.clear();
+        std::sort(out.begin(), out.end(), [this](const DensePath& a, const DensePath& b) {
+            return shorter(adj_, a, b);
+        });
+    }
+
+private:
+    bool reaches(uint32_t v) const { return v == t_ || s_.tree.parent[v] != n_; }
+    double toTarget(uint32_t v) const { return v == t_ ? 0.0 : s_.tree.dist[v]; }
+
+    DensePath treePath(uint32_t v) const {
+        DensePath p;
+        p.nodes.push_back(v);
+        appendTreePath(v, p);
+        p.finish();
+        return p;
+    }
+
+    void appendTreePath(uint32_t v, DensePath& p) const {
+        const ShortestPathTree& tree = s_.tree;
+        while (v != t_) {
+            const uint32_t e = tree.parentEdge[v];
+            v = tree.parent[v];
+            p.nodes.push_back(v);
+            p.links.push_back(adj_.linkIndex[e]);
+            p.weights.push_back(adj_.weights[e]);
+        }
+    }
+
+    // Removes every link between u and v; parallel links would only give the
+    // same node sequence back.
+    void blockPair(uint32_t u, uint32_t v, uint32_t epoch) {
+        for (uint32_t e = adj_.offsets[u]; e < adj_.offsets[u + 1]; ++e) {
+            if (adj_.targets[e] == v) s_.linkMark[adj_.linkIndex[e]] = epoch;
+        }
+    }
+
+    // The unrestricted best path from the spur is still optimal if none of its
+    // nodes or links were removed.
+    bool treeSpur(uint32_t spur, uint32_t epoch, DensePath& cand) const {
+        const ShortestPathTree& tree = s_.tree;
+        if (!reaches(spur)) return false;
+        for (uint32_t v = spur; v != t_; v = tree.parent[v]) {
+            if (s_.linkMark[adj_.linkIndex[tree.parentEdge[v]]] == epoch) return false;
+            if (s_.nodeMark[tree.parent[v]] == epoch) return false;
+        }
+        cand.nodes.push_back(spur);
+        appendTreePath(spur, cand);
+        return true;
+    }
+
+    // A* from the spur; the reverse-tree distances are a consistent lower
+    // bound because removing links can only make paths longer.
+    bool astarSpur(uint32_t spur, uint32_t epoch, DensePath& cand) {
+        if (!reaches(spur)) return false;
+        const uint32_t run = s_.nextSearch();
+        s_.heap.clear();
+        s_.dist[spur] = 0.0;
+        s_.seen[spur] = run;
+        s_.heap.push_back({toTarget(spur), spur});
+        uint64_t pushes = 1, pops = 0, relaxations = 0;
+        bool found = false;
+        while (!s_.heap.empty()) {
+            std::pop_heap(s_.heap.begin(), s_.heap.end(), std::greater<>());
+            const uint32_t v = s_.heap.back().second;
+            s_.heap.pop_back();
+            ++pops;
+            if (s_.done[v] == run) continue;
+            s_.done[v] = run;
+            if (v == t_) {
+                found = true;
+                break;
+            }
+            for (uint32_t e = adj_.offsets[v]; e < adj_.offsets[v + 1]; ++e) {
+                const uint32_t b = adj_.targets[e];
+                if (!reaches(b) || s_.done[b] == run || s_.nodeMark[b] == epoch ||
+                    s_.linkMark[adj_.linkIndex[e]] == epoch) {
+                    continue;
+                }
+                ++relaxations;
+                const double nd = s_.dist[v] + adj_.weights[e];
+                if (s_.seen[b] != run || nd < s_.dist[b]) {
+                    s_.seen[b] = run;
+                    s_.dist[b] = nd;
+                    s_.prevNode[b] = v;
+                    s_.prevEdge[b] = e;
+                    s_.heap.push_back({nd + toTarget(b), b});
+                    std::push_heap(s_.heap.begin(), s_.heap.end(), std::greater<>());
+                    ++pushes;
+                }
+            }
+        }
+        OLSR_COUNT(SpfRuns, 1);
+        OLSR_COUNT(HeapPushes, pushes);
+        OLSR_COUNT(HeapPops, pops);
+        OLSR_COUNT(Relaxations, relaxations);
+        if (!found) return false;
+
+        const size_t base = cand.nodes.size();
+        for (uint32_t v = t_; v != spur; v = s_.prevNode[v]) {
+            cand.nodes.push_back(v);
+            cand.links.push_back(adj_.linkIndex[s_.prevEdge[v]]);
+            cand.weights.push_back(adj_.weights[s_.prevEdge[v]]);
+        }
+        cand.nodes.push_back(spur);
+        std::reverse(cand.nodes.begin() + base, cand.nodes.end());
+        std::reverse(cand.links.begin() + base, cand.links.end());
+        std::reverse(cand.weights.begin() + base, cand.weights.end());
+        return true;
+    }
+
+    const Adjacency& adj_;
+    const std::vector<uint32_t>& rev_;
+    const uint32_t n_;
+    Scratch& s_;
+    uint32_t t_ = 0;
+};
+
+KPath toPath(const Adjacency& adj, const DensePath& p) {
+    KPath out;
+    out.nodes.reserve(p.nodes.size());
+    for (uint32_t v : p.nodes) out.nodes.push_back(adj.ids[v]);
+    out.cost = p.cost;
+    return out;
+}
+
+} // namespace
+
+std::vector<KPath> KShortestPaths::compute(const Graph& g, NodeId src, NodeId dst, uint32_t k,
+                                           PathMode mode) const {
+    PathBatch batch;
+    batch.mode = mode;
+    batch.k = k;
+    batch.queries.push_back({src, dst});
+    compute(g, batch);
+    return std::move(batch.paths.front());
+}
+
+void KShortestPaths::compute(const Graph& g, PathBatch& batch) const {
+    compute(Adjacency::build(g), batch);
+}
+
+void KShortestPaths::compute(const Adjacency& adj, PathBatch& batch) const {
+    OLSR_PHASE(KPaths);
+    batch.paths.assign(batch.queries.size(), {});
+
+    // Reverse half-edge of every half-edge, paired through the link index.
+    size_t links = 0;
+    for (uint32_t l : adj.linkIndex) links = std::max<size_t>(links, l + 1);
+    std::vector<uint32_t> rev(adj.halfEdges(), UINT32_MAX);
+    {
+        std::vector<uint32_t> first(links, UINT32_MAX);
+        for (uint32_t e = 0; e < adj.halfEdges(); ++e) {
+            const uint32_t l = adj.linkIndex[e];
+            if (first[l] == UINT32_MAX) {
+                first[l] = e;
+            } else {
+                rev[e] = first[l];
+                rev[first[l]] = e;
+            }
+        }
+    }
+
+    // Queries grouped by destination: (dst index, query index), sorted.
+    std::vector<std::pair<uint32_t, uint32_t>> order;
+    order.reserve(batch.queries.size());
+    for (uint32_t i = 0; i < batch.queries.size(); ++i) {
+        auto s = adj.index.find(batch.queries[i].src);
+        auto t = adj.index.find(batch.queries[i].dst);
+        if (s == adj.index.end() || t == adj.index.end()) continue;
+        order.push_back({t->second, i});
+    }
+    std::sort(order.begin(), order.end());
+    std::vector<size_t> groups;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i == 0 || order[i].first != order[i - 1].first) groups.push_back(i);
+    }
+    groups.push_back(order.size());
+
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<Scratch> scratch(pool.size());
+    pool.parallelFor(groups.size() - 1, [&](size_t begin, size_t end, unsigned w) {
+        PathSearch search(adj, rev, links, scratch[w]);
+        std::vector<DensePath> dense;
+        for (size_t grp = begin; grp < end; ++grp) {
+            search.target(order[groups[grp]].first);
+            for (size_t i = groups[grp]; i < groups[grp + 1]; ++i) {
+                const uint32_t qi = order[i].second;
+                const uint32_t src = adj.index.at(batch.queries[qi].src);
+                if (batch.mode == PathMode::EdgeDisjoint) search.disjoint(src, batch.k, dense);
+                else search.loopless(src, batch.k, dense);
+                std::vector<KPath>& out = batch.paths[qi];
+                out.reserve(dense.size());
+                for (const DensePath& p : dense) out.push_back(toPath(adj, p));
+            }
+        }
+    });
+}
+
+} // namespace olsr
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "core/Adjacency.h"
+#include "core/Graph.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace olsr {
+
+enum class PathMode {
+    Loopless,     // K best simple paths (Yen)
+    EdgeDisjoint  // up to K paths sharing no link, minimum total cost
+};
+
+struct KPath {
+    std::vector<NodeId> nodes;  // source ... destination
+    double cost = 0.0;          // accumulated from the source outward
+
+    uint32_t hops() const { return nodes.empty() ? 0 : static_cast<uint32_t>(nodes.size() - 1); }
+};
+
+struct PathQuery {
+    NodeId src;
+    NodeId dst;
+};
+
+struct PathBatch {
+    PathMode mode = PathMode::Loopless;
+    uint32_t k = 1;
+    std::vector<PathQuery> queries;
+    std::vector<std::vector<KPath>> paths;  // paths[i] answers queries[i], best first
+};
+
+// Multiple paths per pair over the UP links, for path-diversity and capacity
+// planning queries. Both modes start from the reverse SPF tree of the
+// destination: Yen's spur searches take the tree path when the removed links
+// and root nodes leave it intact and otherwise run A* with the tree distances
+// as the heuristic; the edge-disjoint mode uses the same distances as initial
+// potentials for successive shortest paths on the residual graph. Paths are
+// ordered by quantized cost, then hops, then node ids; when more paths tie at
+// the k-th cost than fit, which of them are returned depends on the search.
+class KShortestPaths {
+public:
+    std::vector<KPath> compute(const Graph& g, NodeId src, NodeId dst, uint32_t k,
+                               PathMode mode = PathMode::Loopless) const;
+    // Fills batch.paths. Queries are grouped by destination so each reverse
+    // tree is built once; groups run in parallel.
+    void compute(const Graph& g, PathBatch& batch) const;
+    // Same over a prebuilt snapshot; adj must be undirected with linkIndex set.
+    void compute(const Adjacency& adj, PathBatch& batch) const;
+};
+
+} // namespace olsr
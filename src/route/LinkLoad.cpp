@@ -0,0 +1,105 @@
+#include "route/LinkLoad.h"
+
+#include "core/Metrics.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+
+namespace olsr {
+
+void LinkLoadEngine::compute(const Graph& g, const TrafficMatrix& tm) {
+    compute(g, Adjacency::build(g), tm);
+}
+
+void LinkLoadEngine::compute(const Graph& g, const Adjacency& adj, const TrafficMatrix& tm) {
+    OLSR_PHASE(LinkLoads);
+    const std::vector<Link>& links = g.links();
+    const uint32_t n = adj.size();
+    const size_t m = links.size();
+    loads_.assign(m, LinkLoad{});
+    maxUtilization_ = 0.0;
+    maxLoad_ = 0.0;
+    unroutable_ = 0.0;
+
+    // Demands grouped by source index (CSR).
+    std::vector<uint32_t> start(n + 1, 0);
+    std::vector<std::pair<uint32_t, double>> sinks;
+    {
+        std::vector<std::pair<uint32_t, std::pair<uint32_t, double>>> flat;
+        flat.reserve(tm.demands.size());
+        for (const TrafficDemand& d : tm.demands) {
+            auto s = adj.index.find(d.src);
+            auto t = adj.index.find(d.dst);
+            if (s == adj.index.end() || t == adj.index.end()) {
+                unroutable_ += d.rate;
+                continue;
+            }
+            if (s->second == t->second) continue;
+            flat.push_back({s->second, {t->second, d.rate}});
+            ++start[s->second + 1];
+        }
+        for (uint32_t i = 0; i < n; ++i) start[i + 1] += start[i];
+        sinks.resize(flat.size());
+        std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (const auto& f : flat) sinks[fill[f.first]++] = f.second;
+    }
+    std::vector<uint32_t> sources;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (start[i + 1] > start[i]) sources.push_back(i);
+    }
+
+    struct Worker {
+        ShortestPathTree tree;
+        std::vector<double> acc;
+        std::vector<double> load; // 2 per link: forward, reverse
+        double unroutable = 0.0;
+    };
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<Worker> workers(pool.size());
+
+    pool.parallelFor(sources.size(), [&](size_t begin, size_t end, unsigned w) {
+        Worker& wk = workers[w];
+        if (wk.load.empty()) wk.load.assign(2 * m, 0.0);
+        wk.acc.resize(n);
+        for (size_t k = begin; k < end; ++k) {
+            const uint32_t s = sources[k];
+            spf_.tree(adj, s, wk.tree);
+            const ShortestPathTree& t = wk.tree;
+            for (uint32_t i = start[s]; i < start[s + 1]; ++i) {
+                const auto [dst, rate] = sinks[i];
+                if (t.parent[dst] == n) wk.unroutable += rate;
+                else wk.acc[dst] += rate;
+            }
+            // Leaves first: every vertex hands its subtree demand to the parent link.
+            for (size_t i = t.order.size(); i-- > 1;) {
+                const uint32_t v = t.order[i];
+                const double a = wk.acc[v];
+                if (a == 0.0) continue;
+                wk.acc[v] = 0.0;
+                const uint32_t p = t.parent[v];
+                const uint32_t li = adj.linkIndex[t.parentEdge[v]];
+                wk.load[2 * li + (links[li].u == adj.ids[p] ? 0 : 1)] += a;
+                wk.acc[p] += a;
+            }
+            wk.acc[s] = 0.0;
+        }
+    }, 4);
+
+    for (const Worker& wk : workers) {
+        unroutable_ += wk.unroutable;
+        if (wk.load.empty()) continue;
+        for (size_t i = 0; i < m; ++i) {
+            loads_[i].forward += wk.load[2 * i];
+            loads_[i].reverse += wk.load[2 * i + 1];
+        }
+    }
+    for (size_t i = 0; i < m; ++i) {
+        LinkLoad& l = loads_[i];
+        const double busiest = std::max(l.forward, l.reverse);
+        maxLoad_ = std::max(maxLoad_, busiest);
+        if (links[i].capacity > 0.0) l.utilization = busiest / links[i].capacity;
+        maxUtilization_ = std::max(maxUtilization_, l.utilization);
+    }
+}
+
+} // namespace olsr
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/Adjacency.h"
+#include "core/Graph.h"
+#include "route/Dijkstra.h"
+
+#include <vector>
+
+namespace olsr {
+
+struct TrafficDemand {
+    NodeId src;
+    NodeId dst;
+    double rate;
+};
+
+struct TrafficMatrix {
+    std::vector<TrafficDemand> demands;
+};
+
+struct LinkLoad {
+    double forward = 0.0;      // carried u -> v
+    double reverse = 0.0;      // carried v -> u
+    double utilization = 0.0;  // busier direction over capacity; 0 without a capacity
+};
+
+// Per-link load of a traffic matrix routed over the shortest paths Router
+// would pick. Each source's tree is walked once in reverse settle order,
+// handing every vertex's accumulated demand to its parent link, so a source
+// costs O(N) on top of its SPF. Sources run in parallel with one load
+// accumulator per worker.
+class LinkLoadEngine {
+public:
+    // Loads are indexed like g.links(); DOWN links carry nothing.
+    void compute(const Graph& g, const TrafficMatrix& tm);
+    // Same over a prebuilt snapshot of g.
+    void compute(const Graph& g, const Adjacency& adj, const TrafficMatrix& tm);
+
+    const std::vector<LinkLoad>& loads() const { return loads_; }
+    double maxUtilization() const { return maxUtilization_; }
+    double maxLoad() const { return maxLoad_; }
+    double unroutable() const { return unroutable_; } // demand with no path or unknown endpoints
+
+private:
+    DijkstraEngine spf_;
+    std::vector<LinkLoad> loads_;
+    double maxUtilization_ = 0.0;
+    double maxLoad_ = 0.0;
+    double unroutable_ = 0.0;
+};
+
+} // namespace olsr
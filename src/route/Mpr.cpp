@@ -0,0 +1,223 @@
+#include "route/Mpr.h"
+
+#include "core/Metrics.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+
+namespace olsr {
+
+struct MprSelector::Scratch {
+    uint32_t stamp = 0;
+    std::vector<uint32_t> n1Stamp;  // == stamp: 1-hop neighbor of the current node
+    std::vector<uint32_t> n2Stamp;  // == stamp: n2Slot is valid
+    std::vector<uint32_t> n2Slot;
+    std::vector<uint32_t> coverOff; // per 1-hop neighbor, range into cover
+    std::vector<uint32_t> cover;    // 2-hop slots reachable through that neighbor
+    std::vector<uint32_t> coverCount;
+    std::vector<uint8_t> covered;
+    std::vector<uint8_t> chosen;
+
+    void prepare(uint32_t n) {
+        if (n1Stamp.size() != n || ++stamp == 0) {
+            n1Stamp.assign(n, 0);
+            n2Stamp.assign(n, 0);
+            n2Slot.assign(n, 0);
+            stamp = 1;
+        }
+    }
+};
+
+void MprSelector::computeNode(uint32_t x, Scratch& s) {
+    s.prepare(adj_.size());
+    const uint32_t lo = adj_.offsets[x], hi = adj_.offsets[x + 1];
+    for (uint32_t e = lo; e < hi; ++e) s.n1Stamp[adj_.targets[e]] = s.stamp;
+    s.n1Stamp[x] = s.stamp;
+
+    // Strict 2-hop neighborhood and which 1-hop neighbor reaches what.
+    uint32_t slots = 0;
+    s.coverOff.assign(1, 0);
+    s.cover.clear();
+    s.coverCount.clear();
+    for (uint32_t e = lo; e < hi; ++e) {
+        const uint32_t y = adj_.targets[e];
+        for (uint32_t f = adj_.offsets[y]; f < adj_.offsets[y + 1]; ++f) {
+            const uint32_t z = adj_.targets[f];
+            if (s.n1Stamp[z] == s.stamp) continue;
+            if (s.n2Stamp[z] != s.stamp) {
+                s.n2Stamp[z] = s.stamp;
+                s.n2Slot[z] = slots++;
+                s.coverCount.push_back(0);
+            }
+            s.cover.push_back(s.n2Slot[z]);
+            ++s.coverCount[s.n2Slot[z]];
+        }
+        s.coverOff.push_back(static_cast<uint32_t>(s.cover.size()));
+    }
+    twoHop_[x] = slots;
+
+    const uint32_t deg = hi - lo;
+    s.covered.assign(slots, 0);
+    s.chosen.assign(deg, 0);
+    uint32_t uncovered = slots;
+    std::vector<uint32_t>& set = sets_[x];
+    set.clear();
+    auto select = [&](uint32_t i) {
+        s.chosen[i] = 1;
+        set.push_back(adj_.targets[lo + i]);
+        for (uint32_t c = s.coverOff[i]; c < s.coverOff[i + 1]; ++c) {
+            if (!s.covered[s.cover[c]]) { s.covered[s.cover[c]] = 1; --uncovered; }
+        }
+    };
+
+    // Neighbors that are the only path to some 2-hop node are mandatory.
+    for (uint32_t i = 0; i < deg; ++i) {
+        for (uint32_t c = s.coverOff[i]; c < s.coverOff[i + 1] && !s.chosen[i]; ++c) {
+            if (s.coverCount[s.cover[c]] == 1) select(i);
+        }
+    }
+    // Then greedily take the neighbor reaching the most uncovered 2-hop nodes.
+    while (uncovered > 0) {
+        uint32_t best = deg, bestR = 0;
+        for (uint32_t i = 0; i < deg; ++i) {
+            if (s.chosen[i]) continue;
+            uint32_t r = 0;
+            for (uint32_t c = s.coverOff[i]; c < s.coverOff[i + 1]; ++c) r += !s.covered[s.cover[c]];
+            if (r == 0) continue;
+            const uint32_t d = s.coverOff[i + 1] - s.coverOff[i];
+            if (best == deg || r > bestR) { best = i; bestR = r; continue; }
+            if (r < bestR) continue;
+            const uint32_t bd = s.coverOff[best + 1] - s.coverOff[best];
+            if (d > bd || (d == bd && adj_.ids[adj_.targets[lo + i]] < adj_.ids[adj_.targets[lo + best]])) best = i;
+        }
+        if (best == deg) break;
+        select(best);
+    }
+
+    std::sort(set.begin(), set.end());
+    auto& ids = setIds_[x];
+    ids.clear();
+    for (uint32_t m : set) ids.push_back(adj_.ids[m]);
+    std::sort(ids.begin(), ids.end());
+}
+
+void MprSelector::computeNodes(const std::vector<uint32_t>& nodes) {
+    OLSR_PHASE(Mpr);
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<Scratch> scratch(pool.size());
+    pool.parallelFor(nodes.size(), [&](size_t b, size_t e, unsigned worker){
+        for (size_t i = b; i < e; ++i) computeNode(nodes[i], scratch[worker]);
+    }, 32);
+}
+
+void MprSelector::computeAll(const Graph& g) {
+    adj_ = Adjacency::build(g);
+    const uint32_t n = adj_.size();
+    linkEnds_.clear();
+    linkUp_.clear();
+    for (const auto& l : g.links()) {
+        linkEnds_.emplace_back(l.u, l.v);
+        linkUp_.push_back(l.status == LinkStatus::UP);
+    }
+    sets_.assign(n, {});
+    setIds_.assign(n, {});
+    twoHop_.assign(n, 0);
+    std::vector<uint32_t> all(n);
+    for (uint32_t i = 0; i < n; ++i) all[i] = i;
+    computeNodes(all);
+}
+
+size_t MprSelector::sync(const Graph& g) {
+    const auto& links = g.links();
+    bool structural = links.size() != linkEnds_.size() || g.nodes().size() != adj_.size();
+    for (size_t i = 0; !structural && i < g.nodes().size(); ++i) structural = g.nodes()[i].id != adj_.ids[i];
+    for (size_t i = 0; !structural && i < links.size(); ++i) {
+        structural = links[i].u != linkEnds_[i].first || links[i].v != linkEnds_[i].second;
+    }
+    if (structural) {
+        computeAll(g);
+        return adj_.size();
+    }
+
+    std::vector<size_t> flipped;
+    for (size_t i = 0; i < links.size(); ++i) {
+        const uint8_t up = links[i].status == LinkStatus::UP;
+        if (up != linkUp_[i]) { flipped.push_back(i); linkUp_[i] = up; }
+    }
+    if (flipped.empty()) return 0;
+
+    // A flipped link u-v changes N1 of u and v and N2 of their neighbors.
+    adj_ = Adjacency::build(g);
+    std::vector<uint8_t> mark(adj_.size(), 0);
+    std::vector<uint32_t> affected;
+    auto touch = [&](uint32_t i) { if (!mark[i]) { mark[i] = 1; affected.push_back(i); } };
+    for (size_t li : flipped) {
+        for (NodeId end : {links[li].u, links[li].v}) {
+            auto it = adj_.index.find(end);
+            if (it == adj_.index.end()) continue;
+            touch(it->second);
+            for (uint32_t e = adj_.offsets[it->second]; e < adj_.offsets[it->second + 1]; ++e) touch(adj_.targets[e]);
+        }
+    }
+    computeNodes(affected);
+    return affected.size();
+}
+
+const std::vector<NodeId>* MprSelector::mprs(NodeId n) const {
+    auto it = adj_.index.find(n);
+    if (it == adj_.index.end() || it->second >= setIds_.size()) return nullptr;
+    return &setIds_[it->second];
+}
+
+uint32_t MprSelector::twoHopCount(NodeId n) const {
+    auto it = adj_.index.find(n);
+    if (it == adj_.index.end() || it->second >= twoHop_.size()) return 0;
+    return twoHop_[it->second];
+}
+
+bool MprSelector::selects(uint32_t selector, uint32_t relay) const {
+    if (selector >= sets_.size()) return false;
+    const auto& s = sets_[selector];
+    return std::binary_search(s.begin(), s.end(), relay);
+}
+
+FloodingStats MprSelector::floodingStats() const {
+    const uint32_t n = adj_.size();
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<FloodingStats> partial(pool.size());
+    pool.parallelFor(n, [&](size_t b, size_t e, unsigned worker){
+        std::vector<uint32_t> seen(n, UINT32_MAX), relayed(n, UINT32_MAX), queue;
+        FloodingStats& st = partial[worker];
+        for (size_t o = b; o < e; ++o) {
+            const uint32_t origin = static_cast<uint32_t>(o);
+            // Pure flooding: everyone reached retransmits once.
+            queue.assign(1, origin);
+            seen[origin] = origin;
+            for (size_t q = 0; q < queue.size(); ++q) {
+                const uint32_t u = queue[q];
+                for (uint32_t k = adj_.offsets[u]; k < adj_.offsets[u + 1]; ++k) {
+                    const uint32_t v = adj_.targets[k];
+                    if (seen[v] != origin) { seen[v] = origin; queue.push_back(v); }
+                }
+            }
+            st.pureForwards += queue.size() - 1;
+            // MPR flooding: a node retransmits once some transmitter picked it.
+            queue.assign(1, origin);
+            relayed[origin] = origin;
+            for (size_t q = 0; q < queue.size(); ++q) {
+                for (uint32_t r : sets_[queue[q]]) {
+                    if (relayed[r] != origin) { relayed[r] = origin; queue.push_back(r); }
+                }
+            }
+            st.mprForwards += queue.size() - 1;
+        }
+    }, 16);
+    FloodingStats total;
+    for (const auto& p : partial) {
+        total.pureForwards += p.pureForwards;
+        total.mprForwards += p.mprForwards;
+    }
+    return total;
+}
+
+} // namespace olsr
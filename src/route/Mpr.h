@@ -0,0 +1,56 @@
+#pragma once
+
+#include "core/Adjacency.h"
+#include "core/Graph.h"
+#include <cstdint>
+#include <vector>
+
+namespace olsr {
+
+// Control-plane cost of flooding one TC from every node, counted as the
+// number of nodes that retransmit it (the originator is not counted).
+struct FloodingStats {
+    uint64_t pureForwards = 0; // every node that receives the TC forwards it
+    uint64_t mprForwards = 0;  // only nodes selected as MPR by a transmitter forward
+    double reduction() const {
+        return pureForwards ? 1.0 - static_cast<double>(mprForwards) / static_cast<double>(pureForwards) : 0.0;
+    }
+};
+
+// Multipoint relay selection over the UP links of a Graph, using the RFC 3626
+// section 8.3.1 greedy heuristic (all nodes default willingness; ties go to
+// the larger 2-hop degree, then the lower id). sync() recomputes only the
+// nodes whose 1- or 2-hop neighborhood a jammed/unjammed link touches.
+class MprSelector {
+public:
+    // Full recompute for every node, in parallel.
+    void computeAll(const Graph& g);
+    // Brings the sets up to date with g. Status flips on existing links are
+    // handled incrementally; any other structural change triggers
+    // computeAll(). Returns the number of nodes whose set was recomputed.
+    size_t sync(const Graph& g);
+
+    // MPR set of node n as NodeIds, sorted; null if n is unknown.
+    const std::vector<NodeId>* mprs(NodeId n) const;
+    // Number of strict 2-hop neighbors of n.
+    uint32_t twoHopCount(NodeId n) const;
+    // Whether `relay` (dense index) is in the MPR set of `selector`.
+    bool selects(uint32_t selector, uint32_t relay) const;
+
+    FloodingStats floodingStats() const;
+    const Adjacency& adjacency() const { return adj_; }
+
+private:
+    struct Scratch;
+    void computeNode(uint32_t x, Scratch& s);
+    void computeNodes(const std::vector<uint32_t>& nodes);
+
+    Adjacency adj_;
+    std::vector<std::pair<NodeId, NodeId>> linkEnds_; // snapshot for sync()
+    std::vector<uint8_t> linkUp_;
+    std::vector<std::vector<uint32_t>> sets_;   // dense indices, sorted
+    std::vector<std::vector<NodeId>> setIds_;
+    std::vector<uint32_t> twoHop_;
+};
+
+} // namespace olsr
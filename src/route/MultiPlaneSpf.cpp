@@ -0,0 +1,274 @@
+#include "route/MultiPlaneSpf.h"
+
+#include "core/Metrics.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace olsr {
+
+namespace {
+
+constexpr uint32_t kLanes = kMaxMetricPlanes;
+static_assert(kLanes % 4 == 0, "lanes are relaxed four at a time");
+
+// Tie-break key per lane, as in the all-pairs backend: hop count in the high
+// 32 bits, rank (by NodeId) of the predecessor in the low 32 bits.
+constexpr uint64_t kHopMask = 0xFFFFFFFF00000000ull;
+constexpr uint64_t kRankMask = 0x00000000FFFFFFFFull;
+constexpr uint64_t kHopOne = 1ull << 32;
+constexpr uint64_t kNoKey = 0x7FFFFFFFFFFFFFFFull; // loses every signed compare
+
+// Lowers the first `lanes` lanes of v where the candidate wins: a lower
+// quantized cost, or the same finite cost with a lower key. Returns the lanes
+// taken as a mask.
+inline uint32_t relaxLanes(int64_t* qv, uint64_t* kv, const int64_t* qu, const int64_t* w, const uint64_t* ck,
+                           uint32_t lanes) {
+    uint32_t mask = 0;
+#if defined(__AVX2__)
+    const __m256i vlast = _mm256_set1_epi64x(kCostSaturated);
+    for (uint32_t p = 0; p < lanes; p += 4) {
+        // addCost: a finite sum saturates at the grid end, an infinite one stays past it.
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(qu + p));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + p));
+        const __m256i sum = _mm256_add_epi64(a, b);
+        const __m256i inf = _mm256_or_si256(_mm256_cmpgt_epi64(a, vlast), _mm256_cmpgt_epi64(b, vlast));
+        const __m256i over = _mm256_andnot_si256(inf, _mm256_cmpgt_epi64(sum, vlast));
+        const __m256i cq = _mm256_blendv_epi8(sum, vlast, over);
+        const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ck + p));
+        const __m256i curQ = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(qv + p));
+        const __m256i curK = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kv + p));
+        const __m256i lt = _mm256_cmpgt_epi64(curQ, cq);
+        const __m256i eq = _mm256_andnot_si256(_mm256_cmpgt_epi64(cq, vlast), _mm256_cmpeq_epi64(cq, curQ));
+        const __m256i take = _mm256_or_si256(lt, _mm256_and_si256(eq, _mm256_cmpgt_epi64(curK, k)));
+        const uint32_t m = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(take)));
+        if (!m) continue;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(qv + p), _mm256_blendv_epi8(curQ, cq, take));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(kv + p), _mm256_blendv_epi8(curK, k, take));
+        mask |= m << p;
+    }
+#else
+    for (uint32_t p = 0; p < lanes; ++p) {
+        const int64_t cq = addCost(qu[p], w[p]);
+        if (cq < qv[p] || (cq == qv[p] && cq < kCostInfinity && ck[p] < kv[p])) {
+            qv[p] = cq;
+            kv[p] = ck[p];
+            mask |= 1u << p;
+        }
+    }
+#endif
+    return mask;
+}
+
+} // namespace
+
+struct MultiPlaneRouter::Scratch {
+    std::vector<int64_t> q;      // per vertex and lane
+    std::vector<uint64_t> key;   // per vertex and lane
+    std::vector<uint32_t> edge;  // per vertex and lane: half-edge parent -> vertex
+    std::vector<uint8_t> dirty;  // lanes lowered since the vertex was last scanned
+    std::vector<std::pair<double, uint32_t>> heap;
+    std::vector<double> dist;
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> stack;
+    Adjacency planeAdj;                 // adj_ with one plane's weights, for planeTree
+    uint32_t planeAdjOf = kLanes;
+    ShortestPathTree planeTree;
+    uint64_t scans = 0;
+    uint64_t reached = 0;
+};
+
+void MultiPlaneRouter::assign(const Graph& g) {
+    adj_.assign(g);
+    planes_ = g.planeCount();
+    const uint32_t n = adj_.size();
+    byRank_.resize(n);
+    std::iota(byRank_.begin(), byRank_.end(), 0u);
+    std::sort(byRank_.begin(), byRank_.end(), [&](uint32_t a, uint32_t b) { return adj_.ids[a] < adj_.ids[b]; });
+    rank_.resize(n);
+    for (uint32_t r = 0; r < n; ++r) rank_[byRank_[r]] = r;
+
+    const size_t m = adj_.halfEdges();
+    qweights_.assign(m * kLanes, kCostInfinity);
+    weights_.assign(m * kLanes, 0.0);
+    double sum[kLanes] = {};
+    size_t finite[kLanes] = {};
+    for (size_t e = 0; e < m; ++e) {
+        const Link& l = g.links()[adj_.linkIndex[e]];
+        for (uint32_t p = 0; p < planes_; ++p) {
+            const double w = l.metric(p);
+            const int64_t q = quantizeCost(w);
+            weights_[e * kLanes + p] = w;
+            qweights_[e * kLanes + p] = q;
+            if (q < kCostInfinity) {
+                sum[p] += static_cast<double>(q);
+                ++finite[p];
+            }
+        }
+    }
+    // Heap priorities are in plane-0 units so that lanes of similar progress
+    // are scanned together.
+    const double base = finite[0] ? sum[0] / finite[0] : 0.0;
+    for (uint32_t p = 0; p < kLanes; ++p) {
+        const double mean = finite[p] ? sum[p] / finite[p] : 0.0;
+        scale_[p] = (mean > 0.0 && base > 0.0) ? base / mean : 1.0;
+    }
+}
+
+void MultiPlaneRouter::recomputeAll(const Graph& g) {
+    OLSR_PHASE(MultiPlane);
+    assign(g);
+    const uint32_t n = adj_.size();
+    tables_.assign(planes_, std::vector<RouteTable>(n));
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<Scratch> scratch(pool.size());
+    pool.parallelFor(n, [&](size_t begin, size_t end, unsigned w) {
+        RouteTable* out[kLanes] = {};
+        for (size_t src = begin; src < end; ++src) {
+            for (uint32_t p = 0; p < planes_; ++p) out[p] = &tables_[p][src];
+            run(static_cast<uint32_t>(src), scratch[w], out);
+        }
+    }, 8);
+    scans_ = reached_ = 0;
+    for (const Scratch& s : scratch) {
+        scans_ += s.scans;
+        reached_ += s.reached;
+    }
+}
+
+const RouteTable* MultiPlaneRouter::table(uint32_t plane, NodeId src) const {
+    if (plane >= planes_) return nullptr;
+    auto it = adj_.index.find(src);
+    return it == adj_.index.end() ? nullptr : &tables_[plane][it->second];
+}
+
+void MultiPlaneRouter::run(uint32_t src, Scratch& s, RouteTable* const* out) const {
+    const uint32_t n = adj_.size();
+    s.q.assign(static_cast<size_t>(n) * kLanes, kCostInfinity);
+    s.key.assign(static_cast<size_t>(n) * kLanes, kNoKey);
+    s.edge.assign(static_cast<size_t>(n) * kLanes, 0);
+    s.dirty.assign(n, 0);
+    s.heap.clear();
+    const uint8_t active = static_cast<uint8_t>((1u << planes_) - 1);
+#if defined(__AVX2__)
+    const uint32_t lanes = (planes_ + 3) & ~3u;
+#else
+    const uint32_t lanes = planes_;
+#endif
+    for (uint32_t p = 0; p < planes_; ++p) {
+        s.q[src * kLanes + p] = 0;
+        s.key[src * kLanes + p] = 0;
+    }
+    s.dirty[src] = active;
+    s.heap.push_back({0.0, src});
+    uint64_t pushes = 1, pops = 0, relaxations = 0, scans = 0;
+
+    using Item = std::pair<double, uint32_t>;
+    while (!s.heap.empty()) {
+        std::pop_heap(s.heap.begin(), s.heap.end(), std::greater<Item>());
+        const auto [prio, u] = s.heap.back();
+        s.heap.pop_back();
+        ++pops;
+        const uint8_t d = s.dirty[u];
+        if (!d) continue;
+        const int64_t* qu = &s.q[u * kLanes];
+        double cur = 0.0;
+        bool any = false;
+        for (uint32_t p = 0; p < planes_; ++p) {
+            if (!(d >> p & 1)) continue;
+            const double v = static_cast<double>(qu[p]) * scale_[p];
+            cur = any ? std::min(cur, v) : v;
+            any = true;
+        }
+        // The lanes this entry was queued for were scanned since; whatever
+        // is pending now was lowered later and queued its own entry.
+        if (cur > prio) continue;
+        s.dirty[u] = 0;
+        ++scans;
+        alignas(32) uint64_t ck[kLanes];
+        for (uint32_t p = 0; p < kLanes; ++p) ck[p] = (s.key[u * kLanes + p] & kHopMask) + kHopOne + rank_[u];
+        for (uint32_t e = adj_.offsets[u]; e < adj_.offsets[u + 1]; ++e) {
+            const uint32_t v = adj_.targets[e];
+            if (v == src) continue;
+            int64_t* qv = &s.q[v * kLanes];
+            const uint32_t mask = relaxLanes(qv, &s.key[v * kLanes], qu, &qweights_[e * kLanes], ck, lanes) & active;
+            if (!mask) continue;
+            double best = 0.0;
+            bool first = true;
+            for (uint32_t p = 0; p < planes_; ++p) {
+                if (!(mask >> p & 1)) continue;
+                s.edge[v * kLanes + p] = e;
+                const double pv = static_cast<double>(qv[p]) * scale_[p];
+                best = first ? pv : std::min(best, pv);
+                first = false;
+                ++relaxations;
+            }
+            s.dirty[v] |= static_cast<uint8_t>(mask);
+            s.heap.push_back({best, v});
+            std::push_heap(s.heap.begin(), s.heap.end(), std::greater<Item>());
+            ++pushes;
+        }
+    }
+    OLSR_COUNT(SpfRuns, 1);
+    OLSR_COUNT(HeapPushes, pushes);
+    OLSR_COUNT(HeapPops, pops);
+    OLSR_COUNT(Relaxations, relaxations);
+    s.scans += scans;
+
+    // Costs and first hops per plane, accumulated from the source outward
+    // along each lane's predecessor chain.
+    s.dist.resize(n);
+    s.first.resize(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        for (uint32_t p = 0; p < planes_; ++p) {
+            if (s.q[v * kLanes + p] < kCostInfinity) {
+                ++s.reached;
+                break;
+            }
+        }
+    }
+    for (uint32_t p = 0; p < planes_; ++p) {
+        RouteTable& t = *out[p];
+        // Past the end of the cost grid (cost, hops) is no longer isotone, and
+        // a lane keeps the least key over all paths rather than extending each
+        // node's own best path as Dijkstra does; such planes take its tree.
+        bool saturated = false;
+        for (uint32_t v = 0; v < n && !saturated; ++v) saturated = s.q[v * kLanes + p] == kCostSaturated;
+        if (saturated) {
+            if (s.planeAdjOf != p) {
+                s.planeAdj = adj_;
+                for (size_t e = 0; e < s.planeAdj.weights.size(); ++e) s.planeAdj.weights[e] = weights_[e * kLanes + p];
+                s.planeAdjOf = p;
+            }
+            DijkstraEngine().tree(s.planeAdj, src, s.planeTree);
+            DijkstraEngine().table(s.planeAdj, s.planeTree, t);
+            continue;
+        }
+        t.clear();
+        t.reserve(n);
+        std::fill(s.first.begin(), s.first.end(), n);
+        s.first[src] = src;
+        s.dist[src] = 0.0;
+        for (uint32_t v : byRank_) {
+            if (v == src || s.q[v * kLanes + p] >= kCostInfinity) continue;
+            for (uint32_t x = v; s.first[x] == n; x = byRank_[s.key[x * kLanes + p] & kRankMask]) s.stack.push_back(x);
+            while (!s.stack.empty()) {
+                const uint32_t y = s.stack.back();
+                s.stack.pop_back();
+                const uint32_t par = byRank_[s.key[y * kLanes + p] & kRankMask];
+                s.dist[y] = s.dist[par] + weights_[s.edge[y * kLanes + p] * kLanes + p];
+                s.first[y] = par == src ? y : s.first[par];
+            }
+            t.push_back(RouteEntry{adj_.ids[v], adj_.ids[s.first[v]], s.dist[v],
+                                   static_cast<uint32_t>(s.key[v * kLanes + p] >> 32)});
+        }
+    }
+}
+
+} // namespace olsr
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "core/Adjacency.h"
+#include "core/Graph.h"
+#include "route/Dijkstra.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace olsr {
+
+// Route tables for every metric plane of a graph (Graph::addPlane) from one
+// traversal per source. Each vertex carries a distance vector with one lane
+// per plane, and an edge is relaxed for all lanes at once (AVX2 when built
+// with it). The traversal is label-correcting: the heap orders vertices by
+// the smallest lane that changed since their last scan, after scaling each
+// plane to a common mean link cost, and a vertex is scanned again if a lane
+// improves later. Correlated planes settle in nearly the same order, so most
+// vertices are scanned once for all planes. Every plane's table equals what
+// the flat Router computes with that plane as the weight, including the
+// canonical tie-break.
+class MultiPlaneRouter {
+public:
+    void recomputeAll(const Graph& g);
+
+    const RouteTable* table(uint32_t plane, NodeId src) const;
+    // Planes routed by the last recomputeAll.
+    uint32_t planeCount() const { return planes_; }
+    // Vertex scans per reachable vertex in the last recomputeAll; 1.0 means
+    // every vertex was scanned exactly once for all planes together.
+    double scansPerVertex() const { return reached_ ? static_cast<double>(scans_) / reached_ : 0.0; }
+
+private:
+    struct Scratch;
+    void assign(const Graph& g);
+    void run(uint32_t src, Scratch& s, RouteTable* const* out) const;
+
+    Adjacency adj_;
+    uint32_t planes_ = 0;
+    std::vector<uint32_t> rank_;      // dense index -> rank by NodeId
+    std::vector<uint32_t> byRank_;    // rank -> dense index
+    std::vector<int64_t> qweights_;   // quantized weight per half-edge and lane
+    std::vector<double> weights_;     // plain weight per half-edge and lane
+    double scale_[kMaxMetricPlanes] = {};
+    std::vector<std::vector<RouteTable>> tables_; // [plane][dense source]
+    uint64_t scans_ = 0;
+    uint64_t reached_ = 0;
+};
+
+} // namespace olsr
@@ -0,0 +1,177 @@
+#include "route/MultiSourceBfs.h"
+
+#include "core/Metrics.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace olsr {
+
+namespace {
+
+constexpr uint32_t kWords = MultiSourceBfsEngine::kWords;
+
+// out = a & ~b; returns whether any bit is set.
+inline bool andNot(const uint64_t* a, const uint64_t* b, uint64_t* out) {
+#if defined(__AVX2__)
+    static_assert(kWords == 4, "one 256-bit register per bitset");
+    const __m256i r = _mm256_andnot_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(b)),
+                                          _mm256_load_si256(reinterpret_cast<const __m256i*>(a)));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(out), r);
+    return !_mm256_testz_si256(r, r);
+#else
+    uint64_t any = 0;
+    for (uint32_t w = 0; w < kWords; ++w) any |= out[w] = a[w] & ~b[w];
+    return any != 0;
+#endif
+}
+
+// out = a & b; returns whether any bit is set.
+inline bool andAny(const uint64_t* a, const uint64_t* b, uint64_t* out) {
+#if defined(__AVX2__)
+    const __m256i r = _mm256_and_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(a)),
+                                       _mm256_load_si256(reinterpret_cast<const __m256i*>(b)));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(out), r);
+    return !_mm256_testz_si256(r, r);
+#else
+    uint64_t any = 0;
+    for (uint32_t w = 0; w < kWords; ++w) any |= out[w] = a[w] & b[w];
+    return any != 0;
+#endif
+}
+
+} // namespace
+
+void MultiSourceBfsEngine::computeAll(const Adjacency& adj, RouteTableMap& out) {
+    OLSR_PHASE(HopCountBfs);
+    prepare(adj);
+    const uint32_t n = adj.size();
+    RouteTable* tables[kBatch];
+    for (uint32_t first = 0; first < n; first += kBatch) {
+        const uint32_t count = std::min(kBatch, n - first);
+        runBatch(adj, first, count);
+        for (uint32_t j = 0; j < count; ++j) tables[j] = &out[adj.ids[first + j]];
+        fill(adj, first, count, tables);
+    }
+}
+
+void MultiSourceBfsEngine::computeAll(const Adjacency& adj, const Emit& emit) {
+    OLSR_PHASE(HopCountBfs);
+    prepare(adj);
+    const uint32_t n = adj.size();
+    RouteTable* tables[kBatch];
+    batchTables_.resize(std::min(kBatch, n));
+    for (uint32_t j = 0; j < batchTables_.size(); ++j) tables[j] = &batchTables_[j];
+    for (uint32_t first = 0; first < n; first += kBatch) {
+        const uint32_t count = std::min(kBatch, n - first);
+        runBatch(adj, first, count);
+        fill(adj, first, count, tables);
+        for (uint32_t j = 0; j < count; ++j) emit(first + j, batchTables_[j]);
+    }
+}
+
+void MultiSourceBfsEngine::prepare(const Adjacency& adj) {
+    const uint32_t n = adj.size();
+    // Rows sorted by neighbour id: the first neighbour that carries a source's
+    // bit is then its lowest-id predecessor.
+    nbrOffsets_.assign(adj.offsets.begin(), adj.offsets.end());
+    nbrs_.assign(adj.targets.begin(), adj.targets.end());
+    for (uint32_t v = 0; v < n; ++v) {
+        std::sort(nbrs_.begin() + nbrOffsets_[v], nbrs_.begin() + nbrOffsets_[v + 1],
+                  [&](uint32_t a, uint32_t b) { return adj.ids[a] < adj.ids[b]; });
+    }
+    cost_.assign(1, 0.0);
+    weight_ = adj.weights.empty() ? 0.0 : adj.weights.front();
+
+    // Component sizes, so each table is allocated once at its final size.
+    reach_.assign(n, 0);
+    for (uint32_t s = 0; s < n; ++s) {
+        if (reach_[s]) continue;
+        queue_.assign(1, s);
+        reach_[s] = 1;
+        for (size_t i = 0; i < queue_.size(); ++i) {
+            for (uint32_t k = nbrOffsets_[queue_[i]]; k < nbrOffsets_[queue_[i] + 1]; ++k) {
+                if (reach_[nbrs_[k]]) continue;
+                reach_[nbrs_[k]] = 1;
+                queue_.push_back(nbrs_[k]);
+            }
+        }
+        for (uint32_t v : queue_) reach_[v] = static_cast<uint32_t>(queue_.size());
+    }
+}
+
+void MultiSourceBfsEngine::runBatch(const Adjacency& adj, uint32_t first, uint32_t count) {
+    const uint32_t n = adj.size();
+    const Bits zero{};
+    seen_.assign(n, zero);
+    frontier_.assign(n, zero);
+    next_.assign(n, zero);
+    firstHop_.resize(static_cast<size_t>(n) * kBatch);
+    hops_.assign(static_cast<size_t>(n) * kBatch, 0);
+
+    Bits batch{};
+    for (uint32_t j = 0; j < count; ++j) {
+        batch.w[j / 64] |= uint64_t{1} << (j % 64);
+        frontier_[first + j].w[j / 64] |= uint64_t{1} << (j % 64);
+        seen_[first + j].w[j / 64] |= uint64_t{1} << (j % 64);
+    }
+
+    uint64_t scans = 0;
+    for (uint32_t h = 1;; ++h) {
+        if (cost_.size() <= h) cost_.push_back(cost_.back() + weight_);
+        bool grew = false;
+        for (uint32_t v = 0; v < n; ++v) {
+            Bits& found = next_[v];
+            found = zero;
+            Bits rem;
+            if (!andNot(batch.w, seen_[v].w, rem.w)) continue;
+            uint16_t* fv = &firstHop_[static_cast<size_t>(v) * kBatch];
+            uint16_t* hv = &hops_[static_cast<size_t>(v) * kBatch];
+            for (uint32_t k = nbrOffsets_[v]; k < nbrOffsets_[v + 1]; ++k) {
+                const uint32_t u = nbrs_[k];
+                Bits take;
+                ++scans;
+                if (!andAny(frontier_[u].w, rem.w, take.w)) continue;
+                const uint16_t* fu = &firstHop_[static_cast<size_t>(u) * kBatch];
+                for (uint32_t w = 0; w < kWords; ++w) {
+                    found.w[w] |= take.w[w];
+                    for (uint64_t bits = take.w[w]; bits; bits &= bits - 1) {
+                        const uint32_t j = w * 64 + static_cast<uint32_t>(__builtin_ctzll(bits));
+                        fv[j] = static_cast<uint16_t>(h == 1 ? v : fu[j]);
+                        hv[j] = static_cast<uint16_t>(h);
+                    }
+                }
+                if (!andNot(rem.w, take.w, rem.w)) break;
+            }
+            for (uint32_t w = 0; w < kWords; ++w) {
+                seen_[v].w[w] |= found.w[w];
+                grew |= found.w[w] != 0;
+            }
+        }
+        if (!grew) break;
+        std::swap(frontier_, next_);
+    }
+    OLSR_COUNT(SpfRuns, count);
+    OLSR_COUNT(Relaxations, scans);
+}
+
+void MultiSourceBfsEngine::fill(const Adjacency& adj, uint32_t first, uint32_t count, RouteTable* const* tables) {
+    for (uint32_t j = 0; j < count; ++j) {
+        tables[j]->clear();
+        tables[j]->reserve(reach_[first + j] - 1);
+    }
+    // A source's own slot stays unreached.
+    for (uint32_t v : adj.byId) {
+        const uint16_t* fv = &firstHop_[static_cast<size_t>(v) * kBatch];
+        const uint16_t* hv = &hops_[static_cast<size_t>(v) * kBatch];
+        for (uint32_t j = 0; j < count; ++j) {
+            if (hv[j] == 0) continue;
+            tables[j]->push_back(RouteEntry{adj.ids[v], adj.ids[fv[j]], cost_[hv[j]], hv[j]});
+        }
+    }
+}
+
+} // namespace olsr
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "core/Adjacency.h"
+#include "route/Dijkstra.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace olsr {
+
+// All-sources routing for graphs whose UP links share one weight, where the
+// shortest path is the one with the fewest hops. Sources are taken kBatch at
+// a time (multi-source BFS): every vertex keeps a bitset with one bit per
+// source of the batch for "seen" and for the current frontier, and one
+// level step ORs the frontier sets of a vertex's neighbours into its unseen
+// bits (256-bit AVX2 operations when built with them). Neighbours are visited
+// in NodeId order, so the first one offering a source's bit is that source's
+// canonical predecessor, and tables equal DijkstraEngine's. Per-source state
+// is stored vertex-major and the batch's tables are filled together, one
+// vertex row at a time, so neither step strides across memory.
+class MultiSourceBfsEngine {
+public:
+    static constexpr uint32_t kWords = 4;             // 64-bit words per vertex bitset
+    static constexpr uint32_t kBatch = 64 * kWords;   // sources per pass
+    // Per-source state is 16 bits wide; larger graphs route with Dijkstra.
+    static constexpr uint32_t kMaxNodes = 65536;
+
+    using Emit = std::function<void(uint32_t src, const RouteTable& table)>;
+
+    // Every edge of adj must weigh the same, and adj.size() <= kMaxNodes.
+    // Fills out[NodeId] per source.
+    void computeAll(const Adjacency& adj, RouteTableMap& out);
+    // Calls emit once per dense source, in ascending order; `table` is only
+    // valid during the call.
+    void computeAll(const Adjacency& adj, const Emit& emit);
+
+private:
+    struct Bits {
+        alignas(32) uint64_t w[kWords];
+    };
+
+    void prepare(const Adjacency& adj);
+    void runBatch(const Adjacency& adj, uint32_t first, uint32_t count);
+    // Writes the last batch's table of source first + j into tables[j], one
+    // vertex row at a time.
+    void fill(const Adjacency& adj, uint32_t first, uint32_t count, RouteTable* const* tables);
+
+    std::vector<uint32_t> nbrOffsets_;  // CSR rows with neighbours sorted by NodeId
+    std::vector<uint32_t> nbrs_;
+    std::vector<Bits> seen_, frontier_, next_;
+    std::vector<uint16_t> firstHop_;    // [vertex][source in batch]
+    std::vector<uint16_t> hops_;        // [vertex][source in batch]; 0 = unreached
+    std::vector<uint32_t> reach_;       // size of each vertex's component
+    std::vector<uint32_t> queue_;
+    std::vector<double> cost_;          // path cost by hop count
+    double weight_ = 0.0;
+    std::vector<RouteTable> batchTables_; // one batch, for emit
+};
+
+} // namespace olsr
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace olsr {
+
+// Path costs are compared on a fixed-point grid so that equal-cost ties do not
+// depend on the order in which an engine happens to add up edge weights.
+// Among equal-cost paths the route with fewer hops wins, then the one whose
+// last predecessor has the lower id. Reported costs are still the plain double
+// sum along the chosen path, accumulated from the source outward.
+//
+// The grid ends at kCostLimit (about 2.3e9): a link weight or path total at
+// or beyond it saturates to kCostSaturated, so such paths still route but
+// compare as equal, and the hop-count tie-break picks among them. Only a
+// weight that is not a finite number quantizes to kCostInfinity, which no
+// path uses. Sums of grid costs go through addCost.
+constexpr double kCostQuantum = 1e-9;
+constexpr int64_t kCostInfinity = int64_t{1} << 61;
+constexpr int64_t kCostSaturated = kCostInfinity - 1;
+constexpr double kCostLimit = static_cast<double>(kCostSaturated) * kCostQuantum;
+
+inline int64_t quantizeCost(double w) {
+    if (!(w <= std::numeric_limits<double>::max())) return kCostInfinity;
+    if (w <= 0.0) return 0;
+    if (!(w < kCostLimit)) return kCostSaturated;
+    return std::min(std::llround(w / kCostQuantum), static_cast<long long>(kCostSaturated));
+}
+
+// Operands are at most kCostInfinity, so the plain sum cannot overflow.
+inline int64_t addCost(int64_t a, int64_t b) {
+    const int64_t s = a + b;
+    if (s < kCostSaturated) return s;
+    return (a >= kCostInfinity || b >= kCostInfinity) ? kCostInfinity : kCostSaturated;
+}
+
+// A finite cost the grid cannot tell from any other at its end.
+inline bool atCostLimit(double c) { return quantizeCost(c) == kCostSaturated; }
+
+// What a route optimizes, and so what link weights mean.
+enum class RoutePolicy {
+    Shortest,      // least total weight (additive cost)
+    Widest,        // largest bottleneck: weights are bandwidths, a path is as wide as its narrowest link
+    Reliable,      // most reliable: weights are delivery probabilities in (0, 1], multiplied along the path
+    Lexicographic  // least cost, then fewest hops, as one compound key
+};
+
+inline const char* routePolicyName(RoutePolicy p) {
+    switch (p) {
+    case RoutePolicy::Widest: return "widest";
+    case RoutePolicy::Reliable: return "reliable";
+    case RoutePolicy::Lexicographic: return "lexicographic";
+    default: return "shortest";
+    }
+}
+
+// Returns false for an unknown name.
+inline bool parseRoutePolicy(const std::string& name, RoutePolicy& out) {
+    for (RoutePolicy p : {RoutePolicy::Shortest, RoutePolicy::Widest, RoutePolicy::Reliable, RoutePolicy::Lexicographic}) {
+        if (name == routePolicyName(p)) {
+            out = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Path algebras for BasicDijkstraEngine. A policy orders path keys and extends
+// them one link at a time:
+//   Key                      what the heap orders by
+//   identity()               key of the empty path at the source
+//   infinity()               key of no path; no link extends a path beyond it
+//   edge(w)                  a link's weight lifted to a key
+//   combine(path, edge)      the path extended by one link; never better than path
+//   better(a, b)             strict preference
+//   kReportIdentity, report  the double reported as RouteEntry::total_cost,
+//                            accumulated from the source outward
+// Everything is static and inline, so each engine instantiation compiles its
+// relax loop for one policy with no indirect calls.
+
+struct ShortestPathPolicy {
+    using Key = int64_t;
+    static constexpr Key identity() { return 0; }
+    static constexpr Key infinity() { return kCostInfinity; }
+    static Key edge(double w) { return quantizeCost(w); }
+    static Key combine(Key path, Key e) { return addCost(path, e); }
+    static bool better(Key a, Key b) { return a < b; }
+    static constexpr double kReportIdentity = 0.0;
+    static double report(double path, double w) { return path + w; }
+};
+
+// Bottleneck bandwidth on the cost grid; weights from kCostLimit up tie, an
+// infinite one is unlimited and links of bandwidth 0 are unusable.
+struct WidestPathPolicy {
+    using Key = int64_t;
+    static constexpr Key identity() { return kCostInfinity; }
+    static constexpr Key infinity() { return 0; }
+    static Key edge(double w) { return w > 0.0 ? quantizeCost(w) : 0; }
+    static Key combine(Key path, Key e) { return path < e ? path : e; }
+    static bool better(Key a, Key b) { return a > b; }
+    static constexpr double kReportIdentity = std::numeric_limits<double>::infinity();
+    static double report(double path, double w) { return path < w ? path : w; }
+};
+
+// Delivery probability. Paths compare by the sum of -log p on the cost grid,
+// so equal products tie whatever order they were multiplied in; links of
+// probability 0 are unusable and probabilities above 1 count as 1.
+struct ReliablePathPolicy {
+    using Key = int64_t;
+    static constexpr Key identity() { return 0; }
+    static constexpr Key infinity() { return kCostInfinity; }
+    static Key edge(double w) {
+        if (w >= 1.0) return 0;
+        return w > 0.0 ? quantizeCost(-std::log(w)) : kCostInfinity;
+    }
+    static Key combine(Key path, Key e) { return addCost(path, e); }
+    static bool better(Key a, Key b) { return a < b; }
+    static constexpr double kReportIdentity = 1.0;
+    static double report(double path, double w) { return path * (w >= 1.0 ? 1.0 : (w > 0.0 ? w : 0.0)); }
+};
+
+// Every link counts one, whatever its weight.
+struct HopCountPolicy {
+    using Key = uint32_t;
+    static constexpr Key identity() { return 0; }
+    static constexpr Key infinity() { return std::numeric_limits<uint32_t>::max(); }
+    static Key edge(double) { return 1; }
+    static Key combine(Key path, Key e) { return path + e; }
+    static bool better(Key a, Key b) { return a < b; }
+    static constexpr double kReportIdentity = 0.0;
+    static double report(double path, double) { return path + 1.0; }
+};
+
+// Primary first, Secondary among primary ties. Reports the primary's value. A
+// path the primary cannot extend stays at infinity() whatever the secondary
+// says, so an unusable link never looks like a tie.
+template <class Primary, class Secondary>
+struct Lexicographic {
+    struct Key {
+        typename Primary::Key first;
+        typename Secondary::Key second;
+        bool operator==(const Key& o) const { return first == o.first && second == o.second; }
+        bool operator!=(const Key& o) const { return !(*this == o); }
+    };
+    static constexpr Key identity() { return Key{Primary::identity(), Secondary::identity()}; }
+    static constexpr Key infinity() { return Key{Primary::infinity(), Secondary::infinity()}; }
+    static Key edge(double w) { return Key{Primary::edge(w), Secondary::edge(w)}; }
+    static Key combine(const Key& path, const Key& e) {
+        const typename Primary::Key first = Primary::combine(path.first, e.first);
+        if (!Primary::better(first, Primary::infinity())) return infinity();
+        return Key{first, Secondary::combine(path.second, e.second)};
+    }
+    static bool better(const Key& a, const Key& b) {
+        if (Primary::better(a.first, b.first)) return true;
+        return a.first == b.first && Secondary::better(a.second, b.second);
+    }
+    static constexpr double kReportIdentity = Primary::kReportIdentity;
+    static double report(double path, double w) { return Primary::report(path, w); }
+};
+
+// The policies behind RoutePolicy. Hop count is part of every key, so each
+// link strictly worsens a path and an engine settles a tie (zero-weight links
+// included) before it pops the vertex. Shortest and Lexicographic therefore
+// route alike; the latter names the compound key for exports. For reliable
+// routes the hop count is the fewest among the most reliable paths.
+// Bottlenecks are not isotone under that tie-break (a wide long prefix can
+// lose to a narrow short one after a narrow link), so widest routes always
+// have the best bandwidth but their hop count is that of the widest-path
+// tree, not necessarily the minimum.
+using ShortestRoutes = Lexicographic<ShortestPathPolicy, HopCountPolicy>;
+using WidestRoutes = Lexicographic<WidestPathPolicy, HopCountPolicy>;
+using ReliableRoutes = Lexicographic<ReliablePathPolicy, HopCountPolicy>;
+using LexicographicRoutes = ShortestRoutes;
+
+} // namespace olsr
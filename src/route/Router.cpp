@@ -1,20 +1,376 @@
 #include "route/Router.h"
 
+#include "core/Metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
 namespace olsr {
 
+// Below this size a single heap-based SPF beats spinning up the worker pool.
+static constexpr size_t kParallelSpfMinNodes = 4096;
+
+namespace {
+
+constexpr double kUnreachable = std::numeric_limits<double>::infinity();
+
+// Table costs are double sums while engines decide on the quantized grid; the
+// slack errs towards recomputing a source.
+inline double slack(double d) { return 1e-6 + 1e-12 * d; }
+
+// dst's entry in src's table; the source itself is at cost 0 with no hops.
+RouteEntry lookup(const RouteTable& t, NodeId src, NodeId dst) {
+    if (dst == src) return RouteEntry{src, src, 0.0, 0};
+    auto it = std::lower_bound(t.begin(), t.end(), dst, [](const RouteEntry& e, NodeId id) { return e.destination < id; });
+    if (it != t.end() && it->destination == dst) return *it;
+    return RouteEntry{dst, 0, kUnreachable, 0};
+}
+
+RouteEntry lookup(const CompressedRouteTable& t, NodeId src, NodeId dst) {
+    if (dst == src) return RouteEntry{src, src, 0.0, 0};
+    RouteEntry e;
+    if (t.find(dst, e)) return e;
+    return RouteEntry{dst, 0, kUnreachable, 0};
+}
+
+double effectiveWeight(bool exists, LinkStatus st, double w) {
+    return (exists && st == LinkStatus::UP && quantizeCost(w) < kCostInfinity) ? w : kUnreachable;
+}
+
+// Whether edge a->b may be the tree edge into b: it is tight, one hop longer,
+// and keeps the first hop (all necessary for b's parent being a).
+bool maybeTreeEdge(const RouteEntry& a, const RouteEntry& b, NodeId src, double w) {
+    return std::abs(a.total_cost + w - b.total_cost) <= slack(b.total_cost) && b.hop_count == a.hop_count + 1 &&
+           (a.destination == src ? b.next_hop == b.destination : b.next_hop == a.next_hop);
+}
+
+// Whether changing edge a-b from wOld to wNew can alter src's tree. A cheaper
+// edge matters if it offers an equal or better path (any path at the end of
+// the cost grid ties with another there); a costlier one only if the tree
+// uses it, since losing a tied alternative does not move a parent.
+bool treeAffected(const RouteEntry& a, const RouteEntry& b, NodeId src, double wOld, double wNew) {
+    const double da = a.total_cost, db = b.total_cost;
+    if (da == kUnreachable && db == kUnreachable) return false;
+    if (wNew < wOld) {
+        return da + wNew <= db + slack(db) || db + wNew <= da + slack(da) ||
+               (atCostLimit(db) && atCostLimit(da + wNew)) || (atCostLimit(da) && atCostLimit(db + wNew));
+    }
+    return maybeTreeEdge(a, b, src, wOld) || maybeTreeEdge(b, a, src, wOld);
+}
+
+// Table stamps come from one counter shared by every Router, so a stamp
+// never names two different tables.
+uint64_t nextStamp() {
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+} // namespace
+
+bool Router::uniformWeights(const Graph& g) {
+    bool first = true;
+    double w = 0.0;
+    for (const auto& l : g.links()) {
+        if (l.status != LinkStatus::UP) continue;
+        if (first) {
+            w = l.weight;
+            first = false;
+        } else if (l.weight != w) {
+            return false;
+        }
+    }
+    // Zero-cost links would let Dijkstra settle a vertex before its
+    // fewest-hop path is seen, so hop counts could differ.
+    return first || (w > 0.0 && quantizeCost(w) < kCostInfinity);
+}
+
+bool Router::hopCountApplies(const Graph& g) {
+    return g.nodes().size() <= MultiSourceBfsEngine::kMaxNodes && uniformWeights(g);
+}
+
+RouteBackend Router::chooseBackend(const Graph& g) {
+    if (hopCountApplies(g)) return RouteBackend::HopCount;
+    const size_t n = g.nodes().size();
+    if (n < FloydWarshallEngine::kTile) return RouteBackend::Dijkstra;
+    size_t up = 0;
+    for (const auto& l : g.links()) if (l.status == LinkStatus::UP) ++up;
+    // 2E / N > N / 4
+    return (8 * up > n * n) ? RouteBackend::FloydWarshall : RouteBackend::Dijkstra;
+}
+
 void Router::recomputeAll(const Graph& g) {
-    tables_.clear();
+    OLSR_PHASE(RecomputeAll);
+    allStamp_ = nextStamp();
+    stamps_.clear();
+    lastBackend_ = (backend_ == RouteBackend::Auto) ? chooseBackend(g) : backend_;
+    if (lastBackend_ == RouteBackend::HopCount && !hopCountApplies(g)) lastBackend_ = RouteBackend::Dijkstra;
+    if (policy_ != RoutePolicy::Shortest) lastBackend_ = RouteBackend::Dijkstra;
+    // Retire the previous generation wholesale.
+    tables_.reset();
+    packed_.reset();
+    decodedValid_ = false;
+    if (storage_ == TableStorage::Compressed && lastBackend_ != RouteBackend::FloydWarshall) {
+        arena_.release();
+        auto& out = packed_.emplace();
+        out.reserve(g.nodes().size());
+        adj_.assign(g);
+        if (lastBackend_ == RouteBackend::HopCount) {
+            bfsEngine_.computeAll(adj_, [&](uint32_t s, const RouteTable& t) { out[adj_.ids[s]].encode(t); });
+            return;
+        }
+        for (uint32_t s = 0; s < adj_.size(); ++s) {
+            if (lastBackend_ == RouteBackend::DeltaStepping) {
+                const RouteTable t = deltaEngine_.compute(adj_, s);
+                scratch_.assign(t.begin(), t.end());
+            } else {
+                computeTree(s, scratch_);
+            }
+            out[adj_.ids[s]].encode(scratch_);
+        }
+        return;
+    }
+    arena_.reset();
+    RouteTableMap& out = tables();
+    if (lastBackend_ == RouteBackend::FloydWarshall) {
+        denseEngine_.computeAll(g, out);
+        if (storage_ == TableStorage::Compressed) {
+            auto& packed = packed_.emplace();
+            packed.reserve(out.size());
+            for (const auto& [id, t] : out) packed[id].encode(t);
+            tables_.reset();
+            arena_.release();
+        }
+        return;
+    }
+    out.reserve(g.nodes().size());
+    adj_.assign(g);
+    if (lastBackend_ == RouteBackend::DeltaStepping) {
+        for (uint32_t s = 0; s < adj_.size(); ++s) {
+            const RouteTable t = deltaEngine_.compute(adj_, s);
+            out[adj_.ids[s]].assign(t.begin(), t.end());
+        }
+        return;
+    }
+    if (lastBackend_ == RouteBackend::HopCount) {
+        bfsEngine_.computeAll(adj_, out);
+        return;
+    }
+    for (uint32_t s = 0; s < adj_.size(); ++s) computeTree(s, out[adj_.ids[s]]);
+}
+
+void Router::recomputeSource(const Graph& g, NodeId src) {
+    OLSR_PHASE(RecomputeSource);
+    stamps_[src] = nextStamp();
+    if (compressed()) {
+        computeSource(g, src, scratch_);
+        (*packed_)[src].encode(scratch_);
+        decodedValid_ = false;
+        return;
+    }
+    // Overwritten in place: a table of similar size reuses its capacity
+    // instead of drawing more from the arena.
+    computeSource(g, src, tables()[src]);
+}
+
+void Router::computeSource(const Graph& g, NodeId src, RouteTable& out) {
+    const bool parallel = policy_ == RoutePolicy::Shortest && (backend_ == RouteBackend::DeltaStepping ||
+        (backend_ == RouteBackend::Auto && g.nodes().size() >= kParallelSpfMinNodes));
+    adj_.assign(g);
+    auto it = adj_.index.find(src);
+    if (it == adj_.index.end()) {
+        out.clear();
+    } else if (parallel) {
+        const RouteTable t = deltaEngine_.compute(adj_, it->second);
+        out.assign(t.begin(), t.end());
+    } else {
+        computeTree(it->second, out);
+    }
+}
+
+size_t Router::applyChanges(const Graph& g, const GraphChangeLog& log) {
+    OLSR_PHASE(ApplyChanges);
+    if (log.empty()) return 0;
+    const RouteBackend next = (backend_ == RouteBackend::Auto) ? chooseBackend(g) : backend_;
+    if ((!tables_ && !packed_) || log.structural() || next == RouteBackend::FloydWarshall ||
+        policy_ != RoutePolicy::Shortest) {
+        recomputeAll(g);
+        return g.nodes().size();
+    }
+
+    struct Edge {
+        NodeId a, b;
+        double wOld, wNew;
+    };
+    std::vector<Edge> edges;
+    for (const LinkChange& c : log.links) {
+        const double wOld = effectiveWeight(c.existedBefore, c.oldStatus, c.oldWeight);
+        const double wNew = effectiveWeight(c.existsAfter, c.newStatus, c.newWeight);
+        // Saturated weights compare equal but still change reported costs.
+        const bool same = (wOld == kUnreachable) ? wNew == kUnreachable
+                        : wNew != kUnreachable && quantizeCost(wOld) == quantizeCost(wNew) &&
+                              (wOld == wNew || !atCostLimit(wNew));
+        if (!same) edges.push_back(Edge{c.u, c.v, wOld, wNew});
+    }
+    auto touches = [&](const auto& t, NodeId src) {
+        for (const Edge& e : edges) {
+            if (treeAffected(lookup(t, src, e.a), lookup(t, src, e.b), src, e.wOld, e.wNew)) return true;
+        }
+        return false;
+    };
+    // A source whose component (after the change) holds neither endpoint of
+    // any changed link could not reach them before either.
+    const Connectivity& conn = g.connectivity();
+    std::vector<NodeId> reached;
+    for (const Edge& e : edges) {
+        reached.push_back(conn.component(e.a));
+        reached.push_back(conn.component(e.b));
+    }
+    std::sort(reached.begin(), reached.end());
+    reached.erase(std::unique(reached.begin(), reached.end()), reached.end());
+
+    std::vector<NodeId> affected;
     for (const auto& n : g.nodes()) {
-        tables_.emplace(n.id, engine_.compute(g, n.id));
+        if (!std::binary_search(reached.begin(), reached.end(), conn.component(n.id))) continue;
+        bool hit = true;
+        if (packed_) {
+            auto it = packed_->find(n.id);
+            hit = it == packed_->end() || touches(it->second, n.id);
+        } else {
+            auto it = tables_->find(n.id);
+            hit = it == tables_->end() || touches(it->second, n.id);
+        }
+        if (hit) affected.push_back(n.id);
+    }
+    if (2 * affected.size() > g.nodes().size()) {
+        recomputeAll(g);
+        return g.nodes().size();
     }
+
+    // Single sources go through Dijkstra, which yields the same tables.
+    lastBackend_ = next == RouteBackend::HopCount ? RouteBackend::Dijkstra : next;
+    adj_.assign(g);
+    for (NodeId id : affected) {
+        stamps_[id] = nextStamp();
+        RouteTable& out = packed_ ? scratch_ : (*tables_)[id];
+        if (lastBackend_ == RouteBackend::DeltaStepping) {
+            const RouteTable t = deltaEngine_.compute(adj_, adj_.index.at(id));
+            out.assign(t.begin(), t.end());
+        } else {
+            computeTree(adj_.index.at(id), out);
+        }
+        if (packed_) (*packed_)[id].encode(out);
+    }
+    decodedValid_ = false;
+    return affected.size();
+}
+
+void Router::restore(std::unordered_map<NodeId, CompressedRouteTable>&& tables, RoutePolicy policy) {
+    policy_ = policy;
+    tables_.reset();
+    arena_.release();
+    packed_ = std::move(tables);
+    decodedValid_ = false;
+    allStamp_ = nextStamp();
+    stamps_.clear();
+}
+
+uint64_t Router::tableStamp(NodeId src) const {
+    auto it = stamps_.find(src);
+    return it == stamps_.end() ? allStamp_ : it->second;
+}
+
+RouteTableMap& Router::tables() {
+    if (!tables_) tables_.emplace(&arena_);
+    return *tables_;
+}
+
+void Router::computeTree(uint32_t src, RouteTable& out) {
+    engine_.table(policy_, adj_, src, out);
 }
 
 const RouteTable* Router::table(NodeId src) const {
-    auto it = tables_.find(src);
-    if (it == tables_.end()) return nullptr;
+    if (packed_) {
+        if (decodedValid_ && decodedSrc_ == src) return &decoded_;
+        auto it = packed_->find(src);
+        if (it == packed_->end()) return nullptr;
+        it->second.decode(decoded_);
+        decodedSrc_ = src;
+        decodedValid_ = true;
+        return &decoded_;
+    }
+    if (!tables_) return nullptr;
+    auto it = tables_->find(src);
+    if (it == tables_->end()) return nullptr;
     return &it->second;
 }
 
-} // namespace olsr
+bool Router::table(NodeId src, RouteTable& out) const {
+    if (packed_) {
+        auto it = packed_->find(src);
+        if (it == packed_->end()) return false;
+        it->second.decode(out);
+        return true;
+    }
+    if (!tables_) return false;
+    auto it = tables_->find(src);
+    if (it == tables_->end()) return false;
+    out.assign(it->second.begin(), it->second.end());
+    return true;
+}
+
+bool Router::route(NodeId src, NodeId dst, RouteEntry& out) const {
+    if (packed_) {
+        auto it = packed_->find(src);
+        return it != packed_->end() && it->second.find(dst, out);
+    }
+    const RouteTable* t = table(src);
+    if (!t) return false;
+    const RouteEntry e = lookup(*t, src, dst);
+    if (dst == src || e.total_cost == kUnreachable) return false;
+    out = e;
+    return true;
+}
+
+const CompressedRouteTable* Router::packedTable(NodeId src) const {
+    if (!packed_) return nullptr;
+    auto it = packed_->find(src);
+    return it == packed_->end() ? nullptr : &it->second;
+}
 
+size_t Router::routeCount() const {
+    size_t n = 0;
+    if (packed_) {
+        for (const auto& [id, t] : *packed_) n += t.size();
+    } else if (tables_) {
+        for (const auto& [id, t] : *tables_) n += t.size();
+    }
+    return n;
+}
 
+size_t Router::saturatedRoutes() const {
+    size_t n = 0;
+    auto count = [&n](const RouteTable& t) {
+        for (const RouteEntry& e : t) n += atCostLimit(e.total_cost);
+    };
+    if (packed_) {
+        RouteTable t;
+        for (const auto& [id, p] : *packed_) {
+            p.decode(t);
+            count(t);
+        }
+    } else if (tables_) {
+        for (const auto& [id, t] : *tables_) count(t);
+    }
+    return n;
+}
+
+size_t Router::tableBytes() const {
+    if (!packed_) return routeCount() * sizeof(RouteEntry);
+    size_t bytes = 0;
+    for (const auto& [id, t] : *packed_) bytes += t.bytes();
+    return bytes;
+}
+
+} // namespace olsr
@@ -1,21 +1,132 @@
 #pragma once
 
+#include "core/Adjacency.h"
+#include "core/Arena.h"
 #include "core/Graph.h"
+#include "route/CompressedRouteTable.h"
+#include "route/DeltaStepping.h"
 #include "route/Dijkstra.h"
+#include "route/FloydWarshall.h"
+#include "route/MultiSourceBfs.h"
+#include <optional>
 #include <unordered_map>
 
 namespace olsr {
 
+enum class RouteBackend {
+    Auto,          // pick per recompute from graph density
+    Dijkstra,      // one heap-based SPF per source
+    FloydWarshall, // blocked all-pairs over a dense matrix
+    DeltaStepping, // parallel delta-stepping SPF per source
+    HopCount       // bit-parallel multi-source BFS; all UP links must weigh the same
+};
+
+enum class TableStorage {
+    Flat,       // one RouteTable per source in the generation arena
+    Compressed  // one CompressedRouteTable per source; see table()
+};
+
+// Route tables of one recomputeAll form a generation: the hash map and every
+// table are carved from arena_, which is reset when the next generation
+// starts. Pointers from table() are valid until then.
+//
+// With TableStorage::Compressed each table is packed as soon as it is
+// computed and the flat generation is never materialized (the all-pairs
+// backend is the exception: it still produces every table at once).
 class Router {
 public:
     void recomputeAll(const Graph& g);
+    // Refreshes only src's table, e.g. the root tree right after a change.
+    // Auto and DeltaStepping use the parallel engine on large graphs.
+    void recomputeSource(const Graph& g, NodeId src);
+    // Brings the tables up to date with a committed transaction. `log` must
+    // cover every change since the tables were last computed. Only sources
+    // whose tree a change can move are recomputed: a cheaper or new link that
+    // offers an equal-or-better path, or a costlier or removed link that lies on
+    // a shortest path. Node additions/removals recompute everything. Returns
+    // the number of sources recomputed.
+    size_t applyChanges(const Graph& g, const GraphChangeLog& log);
+    // In compressed storage the table is decoded into a buffer owned by the
+    // router: the pointer stays valid only until the next table() call, and
+    // concurrent callers race on that buffer even though the method is const.
+    // In flat storage it stays valid until the next recompute.
     const RouteTable* table(NodeId src) const;
+    // Copies (or decodes) src's table into `out`, touching no router state, so
+    // const callers on several threads may use it at once. False if unknown.
+    bool table(NodeId src, RouteTable& out) const;
+    // One entry without decoding a whole table. False if unknown or unreachable.
+    bool route(NodeId src, NodeId dst, RouteEntry& out) const;
+    // Changes whenever src's table may have been rewritten, and is never
+    // reused, even by another Router, so a consumer mirroring the tables
+    // (RoutePublisher) copies only those whose stamp moved.
+    uint64_t tableStamp(NodeId src) const;
+    // Packed form of src's table, in compressed storage only.
+    const CompressedRouteTable* packedTable(NodeId src) const;
+    // Installs tables computed earlier under policy, e.g. from a checkpoint,
+    // as a packed generation, and adopts that policy so applyChanges keeps
+    // them current under the same one. The next recomputeAll goes back to the
+    // configured storage.
+    void restore(std::unordered_map<NodeId, CompressedRouteTable>&& tables, RoutePolicy policy);
+
+    // Takes effect from the next recomputeAll.
+    void setTableStorage(TableStorage s) { storage_ = s; }
+    TableStorage tableStorage() const { return storage_; }
+    // Route entries held and the bytes they occupy in the current storage.
+    size_t routeCount() const;
+    size_t tableBytes() const;
+    // Routes whose cost reached the end of the cost grid (see RoutePolicy.h):
+    // their totals are truncated, so they compare as equal among themselves.
+    size_t saturatedRoutes() const;
+
+    // What routes optimize; takes effect from the next recomputeAll. Only the
+    // Dijkstra backend knows policies other than Shortest: they run it
+    // whatever the configured backend, and applyChanges recomputes every
+    // source for them, since its tree checks assume additive costs.
+    void setPolicy(RoutePolicy p) { policy_ = p; }
+    RoutePolicy policy() const { return policy_; }
+
+    void setBackend(RouteBackend b) { backend_ = b; }
+    RouteBackend backend() const { return backend_; }
+    // Backend actually used by the last recomputeAll (never Auto).
+    RouteBackend lastBackend() const { return lastBackend_; }
+
+    // Graphs whose UP links all weigh the same route by hop count. Otherwise
+    // dense graphs (average degree above N/4) favour the all-pairs backend.
+    static RouteBackend chooseBackend(const Graph& g);
+    // True if every UP link has the same finite, positive weight.
+    static bool uniformWeights(const Graph& g);
+    // The hop-count backend takes uniform weights and at most
+    // MultiSourceBfsEngine::kMaxNodes nodes; otherwise it runs Dijkstra.
+    static bool hopCountApplies(const Graph& g);
+
+    DeltaSteppingEngine& deltaEngine() { return deltaEngine_; }
+    const Arena& arena() const { return arena_; }
 
 private:
-    std::unordered_map<NodeId, RouteTable> tables_;
-    DijkstraEngine engine_;
+    RouteTableMap& tables();
+    void computeTree(uint32_t src, RouteTable& out);
+    // Computes src's table with the active backend into `out`.
+    void computeSource(const Graph& g, NodeId src, RouteTable& out);
+    bool compressed() const { return packed_.has_value(); }
+
+    Arena arena_;                          // declared before tables_: outlives it
+    std::optional<RouteTableMap> tables_;  // re-created per generation
+    Adjacency adj_;                        // scratch, reused across recomputes
+    std::optional<std::unordered_map<NodeId, CompressedRouteTable>> packed_; // compressed generation
+    RouteTable scratch_;                   // one table on its way into packed_
+    mutable RouteTable decoded_;           // last table() result in compressed storage
+    mutable NodeId decodedSrc_ = 0;
+    mutable bool decodedValid_ = false;
+    TableStorage storage_ = TableStorage::Flat;
+    PolicyDijkstra engine_;                // engines and scratch trees, reused across sources
+    FloydWarshallEngine denseEngine_;
+    DeltaSteppingEngine deltaEngine_;
+    MultiSourceBfsEngine bfsEngine_;
+    RouteBackend backend_ = RouteBackend::Auto;
+    RoutePolicy policy_ = RoutePolicy::Shortest;
+    RouteBackend lastBackend_ = RouteBackend::Dijkstra;
+    uint64_t allStamp_ = 0;                        // last full recompute or restore
+    std::unordered_map<NodeId, uint64_t> stamps_;  // sources rewritten since then
 };
 
 } // namespace olsr
-
-
@@ -0,0 +1,385 @@
+#include "route/TrafficEngineering.h"
+
+#include "core/Metrics.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+namespace olsr {
+
+namespace {
+constexpr uint32_t kNoEdge = 0xffffffffu;
+}
+
+struct TrafficEngineer::Scratch {
+    std::vector<uint32_t> childStart;
+    std::vector<uint32_t> children;
+    std::vector<uint32_t> order;
+    std::vector<double> acc;
+    std::vector<uint8_t> affected;
+    std::vector<uint8_t> queued;
+    std::vector<uint32_t> affectedList;
+    std::vector<uint32_t> stack;
+    std::vector<uint32_t> previous;                     // parent edges before a full rebuild
+    std::vector<uint32_t> touchMark;                    // epoch per vertex
+    std::vector<std::pair<uint32_t, uint32_t>> touched; // vertex, parent edge before repair
+    uint32_t epoch = 0;
+    std::priority_queue<std::pair<int64_t, uint32_t>, std::vector<std::pair<int64_t, uint32_t>>,
+                        std::greater<std::pair<int64_t, uint32_t>>> pq;
+    std::vector<double> load; // forward, reverse per link
+    double unroutable = 0.0;
+    uint32_t changedTrees = 0;
+    uint64_t pushes = 0, pops = 0, relaxations = 0; // flushed to metrics per iteration
+};
+
+bool TrafficEngineer::updateTree(uint32_t slot, const std::vector<ChangedEdge>* changed, Scratch& sc) {
+    const uint32_t n = adj_.size();
+    const uint32_t s = sources_[slot];
+    int64_t* q = &q_[size_t{slot} * n];
+    uint32_t* pe = &parentEdge_[size_t{slot} * n];
+    uint16_t* h = &hops_[size_t{slot} * n];
+
+    if (++sc.epoch == 0) {
+        std::fill(sc.touchMark.begin(), sc.touchMark.end(), 0);
+        sc.epoch = 1;
+    }
+    sc.touched.clear();
+    auto touch = [&](uint32_t v) {
+        if (sc.touchMark[v] == sc.epoch) return;
+        sc.touchMark[v] = sc.epoch;
+        sc.touched.push_back({v, pe[v]});
+    };
+    // Canonical label order: cost, then hops, then predecessor id.
+    auto offer = [&](uint32_t v, int64_t cq, uint32_t ch, uint32_t e) {
+        if (cq > q[v]) return;
+        if (cq == q[v] && q[v] != kCostInfinity) {
+            if (ch > h[v]) return;
+            if (ch == h[v] && (pe[v] == kNoEdge || adj_.ids[edgeSrc_[e]] >= adj_.ids[edgeSrc_[pe[v]]])) return;
+        }
+        touch(v);
+        ++sc.relaxations;
+        const bool push = !sc.queued[v] || cq < q[v];
+        q[v] = cq;
+        h[v] = static_cast<uint16_t>(ch);
+        pe[v] = e;
+        if (push) {
+            sc.queued[v] = 1;
+            sc.pq.push({cq, v});
+            ++sc.pushes;
+        }
+    };
+
+    bool full = changed == nullptr;
+    sc.affectedList.clear();
+    if (!full) {
+        // Tree edges that got more expensive invalidate everything below them.
+        bool anyIncrease = false;
+        for (const ChangedEdge& c : *changed) {
+            if (c.newQ > c.oldQ && pe[adj_.targets[c.edge]] == c.edge) {
+                anyIncrease = true;
+                break;
+            }
+        }
+        if (anyIncrease) {
+            buildChildren(pe, sc);
+            for (const ChangedEdge& c : *changed) {
+                const uint32_t b = adj_.targets[c.edge];
+                if (c.newQ <= c.oldQ || pe[b] != c.edge || sc.affected[b]) continue;
+                sc.stack.clear();
+                sc.stack.push_back(b);
+                sc.affected[b] = 1;
+                while (!sc.stack.empty()) {
+                    const uint32_t x = sc.stack.back();
+                    sc.stack.pop_back();
+                    sc.affectedList.push_back(x);
+                    for (uint32_t k = sc.childStart[x]; k < sc.childStart[x + 1]; ++k) {
+                        const uint32_t y = sc.children[k];
+                        if (!sc.affected[y]) {
+                            sc.affected[y] = 1;
+                            sc.stack.push_back(y);
+                        }
+                    }
+                }
+            }
+        }
+        // Past half the tree a plain rebuild is cheaper than patching.
+        if (sc.affectedList.size() * 2 > n) {
+            for (uint32_t x : sc.affectedList) sc.affected[x] = 0;
+            sc.affectedList.clear();
+            full = true;
+        }
+    }
+
+    if (full) {
+        const bool compare = changed != nullptr;
+        if (compare) sc.previous.assign(pe, pe + n);
+        std::fill(q, q + n, kCostInfinity);
+        std::fill(h, h + n, uint16_t{0});
+        std::fill(pe, pe + n, kNoEdge);
+        q[s] = 0;
+        sc.queued[s] = 1;
+        sc.pq.push({0, s});
+        runQueue(s, q, h, offer, sc);
+        return compare && !std::equal(pe, pe + n, sc.previous.begin());
+    }
+
+    for (uint32_t x : sc.affectedList) {
+        touch(x);
+        q[x] = kCostInfinity;
+        h[x] = 0;
+        pe[x] = kNoEdge;
+    }
+    // Re-enter the invalidated region from its intact boundary.
+    for (uint32_t x : sc.affectedList) {
+        for (uint32_t e = adj_.offsets[x]; e < adj_.offsets[x + 1]; ++e) {
+            const uint32_t y = adj_.targets[e];
+            if (sc.affected[y] || q[y] == kCostInfinity) continue;
+            const uint32_t in = twin_[e];
+            offer(x, addCost(q[y], qweight_[in]), h[y] + 1u, in);
+        }
+    }
+    for (const ChangedEdge& c : *changed) {
+        if (c.newQ >= c.oldQ) continue;
+        const uint32_t a = edgeSrc_[c.edge];
+        const uint32_t b = adj_.targets[c.edge];
+        if (b == s || q[a] == kCostInfinity) continue;
+        offer(b, addCost(q[a], c.newQ), h[a] + 1u, c.edge);
+    }
+    runQueue(s, q, h, offer, sc);
+    for (uint32_t x : sc.affectedList) sc.affected[x] = 0;
+
+    for (const auto& [v, before] : sc.touched) {
+        if (pe[v] != before) return true;
+    }
+    return false;
+}
+
+template <typename Offer>
+void TrafficEngineer::runQueue(uint32_t s, const int64_t* q, const uint16_t* h, Offer& offer, Scratch& sc) {
+    while (!sc.pq.empty()) {
+        const auto [cq, u] = sc.pq.top();
+        sc.pq.pop();
+        ++sc.pops;
+        if (!sc.queued[u] || cq != q[u]) continue;
+        sc.queued[u] = 0;
+        for (uint32_t e = adj_.offsets[u]; e < adj_.offsets[u + 1]; ++e) {
+            const uint32_t v = adj_.targets[e];
+            if (v != s) offer(v, addCost(cq, qweight_[e]), h[u] + 1u, e);
+        }
+    }
+}
+
+void TrafficEngineer::buildChildren(const uint32_t* pe, Scratch& sc) const {
+    const uint32_t n = adj_.size();
+    sc.childStart.assign(n + 1, 0);
+    for (uint32_t v = 0; v < n; ++v) {
+        if (pe[v] != kNoEdge) ++sc.childStart[edgeSrc_[pe[v]] + 1];
+    }
+    for (uint32_t v = 0; v < n; ++v) sc.childStart[v + 1] += sc.childStart[v];
+    sc.children.resize(n);
+    sc.stack.assign(sc.childStart.begin(), sc.childStart.end() - 1);
+    for (uint32_t v = 0; v < n; ++v) {
+        if (pe[v] != kNoEdge) sc.children[sc.stack[edgeSrc_[pe[v]]]++] = v;
+    }
+}
+
+void TrafficEngineer::finishTree(uint32_t slot, Scratch& sc, std::vector<double>& load) {
+    const uint32_t n = adj_.size();
+    const uint32_t s = sources_[slot];
+    const uint32_t* pe = &parentEdge_[size_t{slot} * n];
+
+    // Parent-before-child order from the stored parent edges.
+    buildChildren(pe, sc);
+    sc.order.clear();
+    sc.order.push_back(s);
+    for (size_t i = 0; i < sc.order.size(); ++i) {
+        const uint32_t x = sc.order[i];
+        for (uint32_t k = sc.childStart[x]; k < sc.childStart[x + 1]; ++k) sc.order.push_back(sc.children[k]);
+    }
+
+    const std::vector<Link>& links = graph_->links();
+    for (uint32_t i = sinkStart_[slot]; i < sinkStart_[slot + 1]; ++i) {
+        const auto [dst, rate] = sinks_[i];
+        if (pe[dst] == kNoEdge) sc.unroutable += rate;
+        else sc.acc[dst] += rate;
+    }
+    for (size_t i = sc.order.size(); i-- > 1;) {
+        const uint32_t v = sc.order[i];
+        const double a = sc.acc[v];
+        if (a == 0.0) continue;
+        sc.acc[v] = 0.0;
+        const uint32_t p = edgeSrc_[pe[v]];
+        const uint32_t li = adj_.linkIndex[pe[v]];
+        load[2 * li + (links[li].u == adj_.ids[p] ? 0 : 1)] += a;
+        sc.acc[p] += a;
+    }
+    sc.acc[s] = 0.0;
+}
+
+void TrafficEngineer::routeAll(const std::vector<ChangedEdge>* changed, TeIteration& it) {
+    const uint32_t n = adj_.size();
+    const size_t m = graph_->links().size();
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<Scratch> scratch(pool.size());
+    pool.parallelFor(sources_.size(), [&](size_t begin, size_t end, unsigned w) {
+        Scratch& sc = scratch[w];
+        if (sc.load.empty()) {
+            sc.load.assign(2 * m, 0.0);
+            sc.acc.assign(n, 0.0);
+            sc.affected.assign(n, 0);
+            sc.queued.assign(n, 0);
+            sc.touchMark.assign(n, 0);
+        }
+        for (size_t k = begin; k < end; ++k) {
+            const uint32_t slot = static_cast<uint32_t>(k);
+            if (updateTree(slot, changed, sc)) ++sc.changedTrees;
+            finishTree(slot, sc, sc.load);
+        }
+        OLSR_COUNT(SpfRuns, end - begin);
+        OLSR_COUNT(HeapPushes, sc.pushes);
+        OLSR_COUNT(HeapPops, sc.pops);
+        OLSR_COUNT(Relaxations, sc.relaxations);
+        sc.pushes = sc.pops = sc.relaxations = 0;
+    }, 4);
+
+    loads_.assign(m, LinkLoad{});
+    for (const Scratch& sc : scratch) {
+        it.changedTrees += sc.changedTrees;
+        if (sc.load.empty()) continue;
+        for (size_t i = 0; i < m; ++i) {
+            loads_[i].forward += sc.load[2 * i];
+            loads_[i].reverse += sc.load[2 * i + 1];
+        }
+    }
+    const std::vector<Link>& links = graph_->links();
+    it.maxUtilization = 0.0;
+    for (size_t i = 0; i < m; ++i) {
+        const double cap = links[i].capacity > 0.0 ? links[i].capacity : params_.defaultCapacity;
+        if (cap > 0.0) loads_[i].utilization = std::max(loads_[i].forward, loads_[i].reverse) / cap;
+        it.maxUtilization = std::max(it.maxUtilization, loads_[i].utilization);
+    }
+}
+
+TeResult TrafficEngineer::run(Graph& g, const TrafficMatrix& tm) {
+    TeResult result;
+    graph_ = &g;
+    adj_ = Adjacency::build(g);
+    const uint32_t n = adj_.size();
+    const size_t halfEdges = adj_.halfEdges();
+
+    edgeSrc_.resize(halfEdges);
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t e = adj_.offsets[u]; e < adj_.offsets[u + 1]; ++e) edgeSrc_[e] = u;
+    }
+    std::vector<uint32_t> linkHalf(2 * g.links().size(), kNoEdge);
+    for (uint32_t e = 0; e < halfEdges; ++e) {
+        const uint32_t li = adj_.linkIndex[e];
+        linkHalf[2 * li + (linkHalf[2 * li] == kNoEdge ? 0 : 1)] = e;
+    }
+    twin_.resize(halfEdges);
+    for (size_t li = 0; li < g.links().size(); ++li) {
+        if (linkHalf[2 * li] == kNoEdge) continue;
+        twin_[linkHalf[2 * li]] = linkHalf[2 * li + 1];
+        twin_[linkHalf[2 * li + 1]] = linkHalf[2 * li];
+    }
+    qweight_.resize(halfEdges);
+    for (size_t e = 0; e < halfEdges; ++e) qweight_[e] = quantizeCost(adj_.weights[e]);
+
+    // Demands grouped by source slot; slots follow vertex order.
+    std::vector<uint32_t> slotOf(n, kNoEdge);
+    std::vector<std::pair<uint32_t, std::pair<uint32_t, double>>> flat;
+    for (const TrafficDemand& d : tm.demands) {
+        auto s = adj_.index.find(d.src);
+        auto t = adj_.index.find(d.dst);
+        if (s == adj_.index.end() || t == adj_.index.end() || s->second == t->second) continue;
+        slotOf[s->second] = 0;
+        flat.push_back({s->second, {t->second, d.rate}});
+    }
+    sources_.clear();
+    for (uint32_t v = 0; v < n; ++v) {
+        if (slotOf[v] == kNoEdge) continue;
+        slotOf[v] = static_cast<uint32_t>(sources_.size());
+        sources_.push_back(v);
+    }
+    sinkStart_.assign(sources_.size() + 1, 0);
+    for (const auto& f : flat) ++sinkStart_[slotOf[f.first] + 1];
+    for (size_t i = 0; i < sources_.size(); ++i) sinkStart_[i + 1] += sinkStart_[i];
+    sinks_.resize(flat.size());
+    {
+        std::vector<uint32_t> fill(sinkStart_.begin(), sinkStart_.end() - 1);
+        for (const auto& f : flat) sinks_[fill[slotOf[f.first]]++] = f.second;
+    }
+
+    q_.assign(sources_.size() * n, kCostInfinity);
+    parentEdge_.assign(sources_.size() * n, kNoEdge);
+    hops_.assign(sources_.size() * n, 0);
+
+    using Clock = std::chrono::steady_clock;
+    auto route = [&](const std::vector<ChangedEdge>* changed, uint32_t changedLinks, Clock::time_point start) {
+        OLSR_PHASE(TeIteration);
+        TeIteration it;
+        it.changedLinks = changedLinks;
+        routeAll(changed, it);
+        it.wallMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        result.iterations.push_back(it);
+    };
+    route(nullptr, 0, Clock::now());
+
+    std::vector<double> base(g.links().size());
+    for (size_t i = 0; i < base.size(); ++i) base[i] = g.links()[i].weight;
+    // Rerouting can make things worse; the best weights seen are what is kept.
+    std::vector<double> bestWeights = base;
+    std::vector<LinkLoad> bestLoads = loads_;
+    result.bestIteration = 0;
+    std::vector<ChangedEdge> changed;
+    for (uint32_t iter = 0; iter < params_.maxIterations; ++iter) {
+        const Clock::time_point start = Clock::now();
+        changed.clear();
+        uint32_t changedLinks = 0;
+        const double damping = params_.damping / (1.0 + iter * params_.dampingDecay);
+        for (size_t li = 0; li < g.links().size(); ++li) {
+            const uint32_t e0 = linkHalf[2 * li];
+            if (e0 == kNoEdge) continue; // DOWN links carry nothing
+            Link& l = g.links()[li];
+            const double u = std::min(loads_[li].utilization, params_.utilizationCap);
+            const double target = base[li] * (1.0 + params_.gain * std::pow(u, params_.power));
+            double next = l.weight + damping * (target - l.weight);
+            if (params_.metricStep > 0.0) {
+                const double step = params_.metricStep * base[li];
+                next = base[li] + std::round((next - base[li]) / step) * step;
+            }
+            const int64_t oldQ = qweight_[e0];
+            const int64_t newQ = quantizeCost(next);
+            if (newQ == oldQ) continue;
+            l.weight = next;
+            ++changedLinks;
+            for (uint32_t e : {e0, linkHalf[2 * li + 1]}) {
+                adj_.weights[e] = next;
+                qweight_[e] = newQ;
+                changed.push_back(ChangedEdge{e, oldQ, newQ});
+            }
+        }
+        if (changed.empty()) {
+            result.converged = true;
+            break;
+        }
+        route(&changed, changedLinks, start);
+        if (result.iterations.back().maxUtilization < result.iterations[result.bestIteration].maxUtilization) {
+            result.bestIteration = static_cast<uint32_t>(result.iterations.size() - 1);
+            for (size_t li = 0; li < bestWeights.size(); ++li) bestWeights[li] = g.links()[li].weight;
+            bestLoads = loads_;
+        }
+    }
+    if (result.bestIteration + 1 != result.iterations.size()) {
+        for (size_t li = 0; li < bestWeights.size(); ++li) g.links()[li].weight = bestWeights[li];
+        loads_ = std::move(bestLoads);
+    }
+    graph_ = nullptr;
+    return result;
+}
+
+} // namespace olsr
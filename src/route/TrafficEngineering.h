@@ -0,0 +1,98 @@
+#pragma once
+
+#include "core/Adjacency.h"
+#include "core/Graph.h"
+#include "route/Dijkstra.h"
+#include "route/LinkLoad.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace olsr {
+
+struct TeParams {
+    uint32_t maxIterations = 50;
+    // Target weight = base * (1 + gain * utilization^power); iteration k moves
+    // a link damping / (1 + k * dampingDecay) of the way there, which settles
+    // the oscillation rerouting otherwise causes.
+    double gain = 2.0;
+    double power = 2.0;
+    double damping = 0.3;
+    double dampingDecay = 0.2;
+    double utilizationCap = 1.5;  // overload beyond this no longer raises the target
+    // Weights move in steps of this fraction of the base weight, like integer
+    // router metrics; an iteration where no link changes step has converged.
+    double metricStep = 0.1;
+    double defaultCapacity = 0.0; // for links without one; 0 leaves them at base weight
+};
+
+struct TeIteration {
+    double maxUtilization = 0.0;
+    uint32_t changedLinks = 0;    // weights moved before this iteration's routing
+    uint32_t changedTrees = 0;    // sources whose shortest-path tree changed shape
+    double wallMs = 0.0;
+};
+
+struct TeResult {
+    std::vector<TeIteration> iterations; // [0] is the initial routing
+    uint32_t bestIteration = 0;          // lowest max utilization; its weights are kept
+    bool converged = false;
+};
+
+// Load-aware rerouting: alternates routing the traffic matrix over the UP
+// links and raising the weight of busy links, like a TE controller pushing
+// metrics. Shortest-path trees of every demand source are kept between
+// iterations and repaired in place from the changed links (dynamic SPF,
+// canonical tie-break preserved) rather than recomputed from scratch.
+class TrafficEngineer {
+public:
+    explicit TrafficEngineer(const TeParams& params = TeParams{}) : params_(params) {}
+
+    // Runs until convergence or maxIterations and writes the weights of the
+    // best iteration into g (orig_weight is kept).
+    TeResult run(Graph& g, const TrafficMatrix& tm);
+
+    // Loads under the weights left in g, indexed like g.links().
+    const std::vector<LinkLoad>& loads() const { return loads_; }
+
+    const TeParams& params() const { return params_; }
+    void setParams(const TeParams& p) { params_ = p; }
+
+private:
+    struct Scratch;
+    struct ChangedEdge {
+        uint32_t edge;
+        int64_t oldQ;
+        int64_t newQ;
+    };
+
+    // Brings slot's tree up to date with the changed half-edges (nullptr:
+    // build from scratch). Returns whether any parent edge moved.
+    bool updateTree(uint32_t slot, const std::vector<ChangedEdge>* changed, Scratch& sc);
+    template <typename Offer>
+    void runQueue(uint32_t s, const int64_t* q, const uint16_t* h, Offer& offer, Scratch& sc);
+    void buildChildren(const uint32_t* pe, Scratch& sc) const;
+    void finishTree(uint32_t slot, Scratch& sc, std::vector<double>& load);
+    void routeAll(const std::vector<ChangedEdge>* changed, TeIteration& it);
+
+    TeParams params_;
+    const Graph* graph_ = nullptr;
+    Adjacency adj_;
+    std::vector<uint32_t> edgeSrc_;  // tail of each half-edge
+    std::vector<uint32_t> twin_;     // reverse half-edge
+    std::vector<int64_t> qweight_;   // quantized half-edge weights
+
+    // Demands grouped by source slot.
+    std::vector<uint32_t> sources_;
+    std::vector<uint32_t> sinkStart_;
+    std::vector<std::pair<uint32_t, double>> sinks_;
+
+    // Warm state per source slot, n entries each.
+    std::vector<int64_t> q_;
+    std::vector<uint32_t> parentEdge_; // kNoEdge for the source / unreachable
+    std::vector<uint16_t> hops_;
+
+    std::vector<LinkLoad> loads_;
+};
+
+} // namespace olsr
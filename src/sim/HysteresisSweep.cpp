@@ -0,0 +1,247 @@
+#include "sim/HysteresisSweep.h"
+
+#include "core/Adjacency.h"
+#include "core/ThreadPool.h"
+#include "route/Dijkstra.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace olsr {
+
+namespace {
+
+// splitmix64; one stream per run index so every parameter set sees the same noise
+struct Rng {
+    uint64_t s;
+
+    uint64_t next() {
+        uint64_t z = (s += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+    double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+    // Marsaglia polar method; the second deviate of each pair is kept for the next call.
+    double gauss() {
+        if (hasSpare) {
+            hasSpare = false;
+            return spare;
+        }
+        double u, v, q;
+        do {
+            u = 2.0 * uniform() - 1.0;
+            v = 2.0 * uniform() - 1.0;
+            q = u * u + v * v;
+        } while (q >= 1.0 || q == 0.0);
+        const double f = std::sqrt(-2.0 * std::log(q) / q);
+        spare = v * f;
+        hasSpare = true;
+        return u * f;
+    }
+
+    double spare = 0.0;
+    bool hasSpare = false;
+};
+
+// Everything a run keeps between steps.
+struct RunState {
+    std::vector<HysteresisState> links;
+    std::vector<uint32_t> faultUntil;   // step at which the ground-truth fault clears
+    std::vector<int32_t> pendingSince;  // step of an untracked ground-truth change, -1 none
+    std::vector<NodeId> nextHops;       // observers x N, 0 = unreachable
+};
+
+struct RunTally {
+    uint64_t flaps = 0;
+    uint64_t spurious = 0;
+    uint64_t routeChanges = 0;
+    uint64_t faults = 0;
+    uint64_t missed = 0;
+    uint64_t converged = 0;
+    double delaySumMs = 0.0;
+    double delayMaxMs = 0.0;
+};
+
+struct Scratch {
+    RunState state;
+    Adjacency adj;      // UP links of the current step, filtered weights
+    std::vector<NodeId> row;
+};
+
+} // namespace
+
+std::vector<HysteresisParams> SweepGrid::expand() const {
+    std::vector<HysteresisParams> out;
+    for (double a : alpha)
+        for (double up : thetaUp)
+            for (double down : thetaDown)
+                for (double hold : holdMs) {
+                    if (down > up) continue;
+                    HysteresisParams p;
+                    p.alpha = a;
+                    p.thetaUp = up;
+                    p.thetaDown = down;
+                    p.holdMs = hold;
+                    out.push_back(p);
+                }
+    return out;
+}
+
+size_t HysteresisSweep::runStateBytes(const Graph& g) const {
+    return g.links().size() * (sizeof(HysteresisState) + sizeof(uint32_t) + sizeof(int32_t)) +
+           static_cast<size_t>(model_.observers) * g.nodes().size() * sizeof(NodeId);
+}
+
+std::vector<SweepResult> HysteresisSweep::run(const Graph& g, const SweepGrid& grid, uint32_t runsPerSet) const {
+    const std::vector<HysteresisParams> sets = grid.expand();
+    std::vector<SweepResult> results(sets.size());
+    if (sets.empty() || runsPerSet == 0) return results;
+
+    // Topology with every link present; per-step status comes from the filter.
+    Graph full = g;
+    for (Link& l : full.links()) l.status = LinkStatus::UP;
+    const Adjacency base = Adjacency::build(full);
+    const std::vector<Link>& links = g.links();
+    const size_t m = links.size();
+    const uint32_t n = base.size();
+
+    std::vector<uint32_t> observers;
+    const uint32_t obsCount = std::min<uint32_t>(model_.observers, n);
+    for (uint32_t k = 0; k < obsCount; ++k) observers.push_back(static_cast<uint32_t>(uint64_t{k} * n / obsCount));
+
+    const double stepMs = model_.stepMs > 0.0 ? model_.stepMs : 100.0;
+    const uint32_t steps = static_cast<uint32_t>(std::ceil(model_.durationMs / stepMs));
+    const double pFault = model_.faultsPerLinkHour * stepMs / 3.6e6;
+
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<Scratch> scratch(pool.size());
+    std::vector<RunTally> tallies(sets.size() * runsPerSet);
+    DijkstraEngine spf;
+
+    pool.parallelFor(tallies.size(), [&](size_t begin, size_t end, unsigned worker) {
+        Scratch& sc = scratch[worker];
+        RunState& st = sc.state;
+        sc.adj.ids = base.ids;
+        sc.adj.byId = base.byId;
+        sc.row.resize(n);
+        for (size_t task = begin; task < end; ++task) {
+            const HysteresisParams& params = sets[task / runsPerSet];
+            const uint32_t runIdx = static_cast<uint32_t>(task % runsPerSet);
+            const HysteresisController ctl(params);
+            Rng rng{model_.seed * 0x2545f4914f6cdd1dull + runIdx};
+            RunTally& t = tallies[task];
+
+            st.links.assign(m, HysteresisState{});
+            for (size_t i = 0; i < m; ++i) {
+                st.links[i].filtered = links[i].weight;
+                st.links[i].lastChangeMs = -params.holdMs;
+            }
+            st.faultUntil.assign(m, 0);
+            st.pendingSince.assign(m, -1);
+            st.nextHops.assign(observers.size() * n, 0);
+
+            for (uint32_t s = 1; s <= steps; ++s) {
+                const double nowMs = s * stepMs;
+                for (size_t i = 0; i < m; ++i) {
+                    const bool wasDown = s - 1 < st.faultUntil[i];
+                    if (!wasDown && rng.uniform() < pFault) {
+                        const double len = -model_.faultMeanMs * std::log(1.0 - rng.uniform());
+                        st.faultUntil[i] = s + std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(len / stepMs)));
+                    }
+                    const bool truthDown = s < st.faultUntil[i];
+                    const double noise = std::max(0.01, 1.0 + model_.sigma * rng.gauss());
+                    const double raw = links[i].weight * noise * (truthDown ? model_.faultFactor : 1.0);
+
+                    HysteresisState& hs = st.links[i];
+                    const LinkStatus before = hs.status;
+                    ctl.update(hs, raw, nowMs);
+                    const bool effDown = hs.status == LinkStatus::DOWN;
+                    if (hs.status != before) {
+                        ++t.flaps;
+                        if (effDown != truthDown) ++t.spurious;
+                    }
+
+                    int32_t& pending = st.pendingSince[i];
+                    if (truthDown != wasDown) {
+                        ++t.faults;
+                        if (pending >= 0) {
+                            ++t.missed;
+                            pending = -1;
+                        } else {
+                            pending = static_cast<int32_t>(s);
+                        }
+                    }
+                    if (pending >= 0 && effDown == truthDown) {
+                        const double delay = (s - static_cast<uint32_t>(pending)) * stepMs;
+                        t.delaySumMs += delay;
+                        t.delayMaxMs = std::max(t.delayMaxMs, delay);
+                        ++t.converged;
+                        pending = -1;
+                    }
+                }
+                if (observers.empty()) continue;
+
+                // Filtered topology for this step, then next hops of each observer.
+                sc.adj.offsets.assign(n + 1, 0);
+                sc.adj.targets.clear();
+                sc.adj.weights.clear();
+                for (uint32_t u = 0; u < n; ++u) {
+                    for (uint32_t e = base.offsets[u]; e < base.offsets[u + 1]; ++e) {
+                        const HysteresisState& hs = st.links[base.linkIndex[e]];
+                        if (hs.status != LinkStatus::UP) continue;
+                        sc.adj.targets.push_back(base.targets[e]);
+                        sc.adj.weights.push_back(hs.filtered);
+                    }
+                    sc.adj.offsets[u + 1] = static_cast<uint32_t>(sc.adj.targets.size());
+                }
+                for (size_t k = 0; k < observers.size(); ++k) {
+                    std::fill(sc.row.begin(), sc.row.end(), 0);
+                    for (const RouteEntry& e : spf.compute(sc.adj, observers[k])) {
+                        sc.row[base.index.at(e.destination)] = e.next_hop;
+                    }
+                    NodeId* prev = &st.nextHops[k * n];
+                    if (s > 1) {
+                        for (uint32_t d = 0; d < n; ++d) t.routeChanges += prev[d] != sc.row[d];
+                    }
+                    std::copy(sc.row.begin(), sc.row.end(), prev);
+                }
+            }
+        }
+    });
+
+    for (size_t p = 0; p < sets.size(); ++p) {
+        SweepResult& r = results[p];
+        r.params = sets[p];
+        r.runs = runsPerSet;
+        uint64_t converged = 0;
+        double delaySum = 0.0;
+        for (uint32_t k = 0; k < runsPerSet; ++k) {
+            const RunTally& t = tallies[p * runsPerSet + k];
+            r.flapsPerRun += t.flaps;
+            r.spuriousPerRun += t.spurious;
+            r.routeChangesPerRun += t.routeChanges;
+            r.faultsPerRun += t.faults;
+            r.missedPerRun += t.missed;
+            converged += t.converged;
+            delaySum += t.delaySumMs;
+            r.maxConvergenceMs = std::max(r.maxConvergenceMs, t.delayMaxMs);
+        }
+        r.flapsPerRun /= runsPerSet;
+        r.spuriousPerRun /= runsPerSet;
+        r.routeChangesPerRun /= runsPerSet;
+        r.faultsPerRun /= runsPerSet;
+        r.missedPerRun /= runsPerSet;
+        r.meanConvergenceMs = converged ? delaySum / converged : 0.0;
+    }
+    for (SweepResult& r : results) {
+        r.pareto = std::none_of(results.begin(), results.end(), [&](const SweepResult& o) {
+            return o.flapsPerRun <= r.flapsPerRun && o.meanConvergenceMs <= r.meanConvergenceMs &&
+                   (o.flapsPerRun < r.flapsPerRun || o.meanConvergenceMs < r.meanConvergenceMs);
+        });
+    }
+    return results;
+}
+
+} // namespace olsr
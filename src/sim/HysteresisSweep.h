@@ -0,0 +1,68 @@
+#pragma once
+
+#include "core/Graph.h"
+#include "hyst/Hysteresis.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace olsr {
+
+// Stochastic link model shared by every run of a sweep.
+struct JitterModel {
+    double stepMs = 100.0;             // sampling interval (one hysteresis update)
+    double durationMs = 60000.0;
+    double sigma = 0.15;               // relative Gaussian noise on each weight sample
+    double faultsPerLinkHour = 6.0;    // ground-truth degradations
+    double faultMeanMs = 5000.0;       // mean (exponential) degradation length
+    double faultFactor = 3.0;          // weight multiplier while degraded
+    uint32_t observers = 1;            // sources whose next hops are tracked for route flaps
+    uint64_t seed = 1;
+};
+
+// Cartesian grid of hysteresis settings; combinations with thetaDown > thetaUp are skipped.
+struct SweepGrid {
+    std::vector<double> alpha{HysteresisParams{}.alpha};
+    std::vector<double> thetaUp{HysteresisParams{}.thetaUp};
+    std::vector<double> thetaDown{HysteresisParams{}.thetaDown};
+    std::vector<double> holdMs{HysteresisParams{}.holdMs};
+
+    std::vector<HysteresisParams> expand() const;
+};
+
+struct SweepResult {
+    HysteresisParams params;
+    uint32_t runs = 0;
+    double flapsPerRun = 0.0;          // filtered UP/DOWN transitions
+    double spuriousPerRun = 0.0;       // transitions away from the ground-truth status
+    double routeChangesPerRun = 0.0;   // observer next-hop changes
+    double faultsPerRun = 0.0;         // ground-truth status changes
+    double missedPerRun = 0.0;         // ground-truth changes reverted before being tracked
+    double meanConvergenceMs = 0.0;    // ground-truth change -> matching filtered status
+    double maxConvergenceMs = 0.0;
+    bool pareto = false;               // no other set has both fewer flaps and faster convergence
+};
+
+// Monte Carlo study of hysteresis settings under link jitter. Every run owns
+// its own controller and per-link state and is replayed against the same
+// seeded noise for each parameter set, so sets are compared on identical
+// inputs. Runs execute in parallel on the shared ThreadPool.
+class HysteresisSweep {
+public:
+    explicit HysteresisSweep(const JitterModel& model = JitterModel{}) : model_(model) {}
+
+    // One result per expanded grid entry, in grid order. g's links define the
+    // topology and base weights; their current status is ignored.
+    std::vector<SweepResult> run(const Graph& g, const SweepGrid& grid, uint32_t runsPerSet) const;
+
+    // Resident state of a single run on g, in bytes.
+    size_t runStateBytes(const Graph& g) const;
+
+    const JitterModel& model() const { return model_; }
+    void setModel(const JitterModel& m) { model_ = m; }
+
+private:
+    JitterModel model_;
+};
+
+} // namespace olsr
@@ -0,0 +1,286 @@
+#include "sim/Mobility.h"
+
+#include "core/Metrics.h"
+#include "io/MappedFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace olsr {
+
+namespace {
+
+uint64_t linkKey(NodeId a, NodeId b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+uint32_t cellBucket(int32_t cx, int32_t cy, uint32_t mask) {
+    return (static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u) & mask;
+}
+
+// Next comma-separated field of [p, end), trimmed.
+bool nextField(const char*& p, const char* end, const char*& b, const char*& e) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    b = p;
+    while (p < end && *p != ',') ++p;
+    e = p;
+    while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r')) --e;
+    if (p < end) ++p;
+    return b != e;
+}
+
+} // namespace
+
+MobilityModel::MobilityModel(Graph& g, const MobilityParams& params)
+    : graph_(g), params_(params), rng_(params.seed) {
+    const auto& nodes = g.nodes();
+    const size_t n = nodes.size();
+    ids_.resize(n);
+    px_.resize(n);
+    py_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        ids_[i] = nodes[i].id;
+        px_[i] = std::isfinite(nodes[i].x) ? nodes[i].x : 0.0;
+        py_[i] = std::isfinite(nodes[i].y) ? nodes[i].y : 0.0;
+    }
+    if (n > 0) {
+        minX_ = *std::min_element(px_.begin(), px_.end());
+        maxX_ = *std::max_element(px_.begin(), px_.end());
+        minY_ = *std::min_element(py_.begin(), py_.end());
+        maxY_ = *std::max_element(py_.begin(), py_.end());
+    }
+    // pi r^2 N / area = 8 neighbours on average.
+    const double area = std::max((maxX_ - minX_) * (maxY_ - minY_), 1.0);
+    range_ = params_.range > 0.0 ? params_.range : std::sqrt(8.0 * area / (3.14159265358979 * std::max<size_t>(n, 1)));
+    maxX_ = std::max(maxX_, minX_ + range_);
+    maxY_ = std::max(maxY_, minY_ + range_);
+
+    walkers_.resize(n);
+    for (Walker& w : walkers_) pickWaypoint(w);
+
+    links_.reserve(g.links().size());
+    for (const Link& l : g.links()) links_.push_back(InRange{linkKey(l.u, l.v), l.weight});
+    std::sort(links_.begin(), links_.end(), [](const InRange& a, const InRange& b) { return a.key < b.key; });
+}
+
+bool MobilityModel::loadTrace(const std::string& path, std::string* errorMsg) {
+    MappedFile file;
+    if (!file.open(path, errorMsg)) return false;
+    std::unordered_map<NodeId, uint32_t> pos;
+    pos.reserve(ids_.size());
+    for (uint32_t i = 0; i < ids_.size(); ++i) pos.emplace(ids_[i], i);
+
+    std::vector<std::vector<Sample>> samples(ids_.size());
+    size_t count = 0;
+    double first = 0.0;
+    const char* p = file.data();
+    const char* end = p + file.size();
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        const char* lineEnd = nl ? nl : end;
+        const char* f = p;
+        p = nl ? nl + 1 : end;
+        const char *b, *e;
+        if (!nextField(f, lineEnd, b, e) || *b == '#') continue;
+        if (!((*b >= '0' && *b <= '9') || *b == '.' || *b == '-')) continue; // header
+        Sample s{};
+        NodeId id = 0;
+        bool ok = std::from_chars(b, e, s.t).ec == std::errc{};
+        ok = ok && nextField(f, lineEnd, b, e) && std::from_chars(b, e, id).ec == std::errc{};
+        ok = ok && nextField(f, lineEnd, b, e) && std::from_chars(b, e, s.x).ec == std::errc{};
+        ok = ok && nextField(f, lineEnd, b, e) && std::from_chars(b, e, s.y).ec == std::errc{};
+        if (!ok) {
+            ++stats_.malformed;
+            continue;
+        }
+        auto it = pos.find(id);
+        if (it == pos.end()) continue;
+        first = count ? std::min(first, s.t) : s.t;
+        samples[it->second].push_back(s);
+        ++count;
+    }
+    if (count == 0) {
+        if (errorMsg) *errorMsg = "No position samples for nodes of this topology";
+        return false;
+    }
+    for (auto& s : samples) {
+        std::stable_sort(s.begin(), s.end(), [](const Sample& a, const Sample& b) { return a.t < b.t; });
+    }
+    samples_ = std::move(samples);
+    cursor_.assign(ids_.size(), 0);
+    traced_ = true;
+    nowMs_ = first - params_.tickMs;
+    return true;
+}
+
+void MobilityModel::pickWaypoint(Walker& w) {
+    std::uniform_real_distribution<double> ux(minX_, maxX_), uy(minY_, maxY_);
+    std::uniform_real_distribution<double> us(params_.minSpeed, std::max(params_.minSpeed, params_.maxSpeed));
+    w.tx = ux(rng_);
+    w.ty = uy(rng_);
+    w.speed = std::max(us(rng_), 0.0) / 1000.0;
+}
+
+void MobilityModel::moveRandomWaypoint(double dtMs) {
+    for (size_t i = 0; i < walkers_.size(); ++i) {
+        Walker& w = walkers_[i];
+        double left = dtMs;
+        while (left > 0.0) {
+            if (w.pauseLeftMs > 0.0) {
+                const double wait = std::min(w.pauseLeftMs, left);
+                w.pauseLeftMs -= wait;
+                left -= wait;
+                continue;
+            }
+            const double dx = w.tx - px_[i], dy = w.ty - py_[i];
+            const double dist = std::sqrt(dx * dx + dy * dy);
+            if (w.speed <= 0.0) break;
+            const double step = w.speed * left;
+            if (step < dist) {
+                px_[i] += dx * (step / dist);
+                py_[i] += dy * (step / dist);
+                break;
+            }
+            px_[i] = w.tx;
+            py_[i] = w.ty;
+            left -= dist / w.speed;
+            w.pauseLeftMs = params_.pauseMs;
+            pickWaypoint(w);
+        }
+    }
+}
+
+void MobilityModel::moveTrace() {
+    for (size_t i = 0; i < samples_.size(); ++i) {
+        const std::vector<Sample>& s = samples_[i];
+        if (s.empty()) continue;
+        uint32_t& c = cursor_[i];
+        while (c + 1 < s.size() && s[c + 1].t <= nowMs_) ++c;
+        if (nowMs_ <= s[c].t || c + 1 == s.size()) {
+            px_[i] = s[c].x;
+            py_[i] = s[c].y;
+            continue;
+        }
+        const double f = (nowMs_ - s[c].t) / (s[c + 1].t - s[c].t);
+        px_[i] = s[c].x + f * (s[c + 1].x - s[c].x);
+        py_[i] = s[c].y + f * (s[c + 1].y - s[c].y);
+    }
+}
+
+double MobilityModel::weightFor(double dist) const {
+    const double rel = dist / range_;
+    if (params_.weightLevels == 0) return std::max(rel, 1e-6);
+    const uint32_t band = static_cast<uint32_t>(rel * params_.weightLevels);
+    return 1.0 + std::min(band, params_.weightLevels - 1);
+}
+
+void MobilityModel::discover() {
+    const uint32_t n = static_cast<uint32_t>(ids_.size());
+    uint32_t buckets = 1;
+    while (buckets < 2 * n) buckets <<= 1;
+    const uint32_t mask = buckets - 1;
+
+    cx_.resize(n);
+    cy_.resize(n);
+    bucketStart_.assign(buckets + 1, 0);
+    bucketNodes_.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        cx_[i] = static_cast<int32_t>(std::floor((px_[i] - minX_) / range_));
+        cy_[i] = static_cast<int32_t>(std::floor((py_[i] - minY_) / range_));
+        ++bucketStart_[cellBucket(cx_[i], cy_[i], mask) + 1];
+    }
+    for (uint32_t b = 0; b < buckets; ++b) bucketStart_[b + 1] += bucketStart_[b];
+    bucketFill_.assign(bucketStart_.begin(), bucketStart_.end() - 1);
+    for (uint32_t i = 0; i < n; ++i) bucketNodes_[bucketFill_[cellBucket(cx_[i], cy_[i], mask)]++] = i;
+
+    const double r2 = range_ * range_;
+    uint64_t candidates = 0;
+    found_.clear();
+    for (uint32_t i = 0; i < n; ++i) {
+        for (int32_t dy = -1; dy <= 1; ++dy) {
+            for (int32_t dx = -1; dx <= 1; ++dx) {
+                const int32_t x = cx_[i] + dx, y = cy_[i] + dy;
+                const uint32_t b = cellBucket(x, y, mask);
+                for (uint32_t k = bucketStart_[b]; k < bucketStart_[b + 1]; ++k) {
+                    const uint32_t j = bucketNodes_[k];
+                    // Each pair once, and only from the cell it is really in:
+                    // other cells can share the bucket.
+                    if (j <= i || cx_[j] != x || cy_[j] != y) continue;
+                    ++candidates;
+                    const double ddx = px_[j] - px_[i], ddy = py_[j] - py_[i];
+                    const double d2 = ddx * ddx + ddy * ddy;
+                    if (d2 >= r2) continue;
+                    found_.push_back(InRange{linkKey(ids_[i], ids_[j]), weightFor(std::sqrt(d2))});
+                }
+            }
+        }
+    }
+    stats_.candidates += candidates;
+    std::sort(found_.begin(), found_.end(), [](const InRange& a, const InRange& b) { return a.key < b.key; });
+}
+
+GraphChangeLog MobilityModel::tick() {
+    OLSR_PHASE(Mobility);
+    auto t0 = std::chrono::steady_clock::now();
+    nowMs_ += params_.tickMs;
+    if (traced_) moveTrace();
+    else moveRandomWaypoint(params_.tickMs);
+    discover();
+
+    // Merge the sorted neighbour sets of the last and this tick.
+    edits_.clear();
+    size_t a = 0, b = 0;
+    while (a < links_.size() || b < found_.size()) {
+        GraphEdit e;
+        if (b == found_.size() || (a < links_.size() && links_[a].key < found_[b].key)) {
+            e.op = GraphEdit::Op::RemoveLink;
+            e.u = static_cast<NodeId>(links_[a].key >> 32);
+            e.v = static_cast<NodeId>(links_[a].key);
+            ++a;
+            ++stats_.linksRemoved;
+        } else if (a == links_.size() || found_[b].key < links_[a].key) {
+            e.op = GraphEdit::Op::AddLink;
+            e.u = static_cast<NodeId>(found_[b].key >> 32);
+            e.v = static_cast<NodeId>(found_[b].key);
+            e.weight = found_[b].weight;
+            ++b;
+            ++stats_.linksAdded;
+        } else {
+            const bool same = links_[a].weight == found_[b].weight;
+            e.op = GraphEdit::Op::SetWeight;
+            e.u = static_cast<NodeId>(found_[b].key >> 32);
+            e.v = static_cast<NodeId>(found_[b].key);
+            e.weight = found_[b].weight;
+            ++a;
+            ++b;
+            if (same) continue;
+            ++stats_.weightChanges;
+        }
+        edits_.push_back(e);
+    }
+    links_.swap(found_);
+    auto t1 = std::chrono::steady_clock::now();
+
+    graph_.begin();
+    graph_.applyBatch(edits_);
+    GraphChangeLog log = graph_.commit();
+    auto& nodes = graph_.nodes();
+    for (size_t i = 0; i < nodes.size() && i < ids_.size(); ++i) {
+        if (nodes[i].id != ids_[i]) continue;
+        nodes[i].x = static_cast<float>(px_[i]);
+        nodes[i].y = static_cast<float>(py_[i]);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    ++stats_.ticks;
+    stats_.discoveryMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+    stats_.applyMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+    return log;
+}
+
+} // namespace olsr
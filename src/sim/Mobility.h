@@ -0,0 +1,114 @@
+#pragma once
+
+#include "core/Graph.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace olsr {
+
+struct MobilityParams {
+    double tickMs = 100.0;
+    double range = 0.0;          // radio range in coordinate units; <= 0: about 8 neighbours per node
+    double minSpeed = 5.0;       // random waypoint speed, coordinate units per second
+    double maxSpeed = 20.0;
+    double pauseMs = 0.0;        // dwell at each waypoint
+    uint32_t weightLevels = 4;   // weight 1..levels by distance band; 0: distance / range
+    uint64_t seed = 1;
+};
+
+struct MobilityStats {
+    uint64_t ticks = 0;
+    uint64_t linksAdded = 0;
+    uint64_t linksRemoved = 0;
+    uint64_t weightChanges = 0;
+    uint64_t candidates = 0;     // pairs distance-checked through the spatial hash
+    uint64_t malformed = 0;      // unparsable position trace lines
+    double discoveryMs = 0.0;    // wall time moving nodes and diffing neighbour sets
+    double applyMs = 0.0;        // wall time applying the differences to the graph
+};
+
+// Moves nodes and keeps the links equal to the set of node pairs within
+// radio range. Nodes follow random waypoints inside the bounding box of their
+// starting positions, or a position trace. Each tick bins the nodes into a
+// uniform grid of range-sized cells, hashed into about 2N buckets, and
+// distance-checks only pairs in adjacent cells: O(N) at a fixed density
+// instead of O(N^2). The result is diffed against the previous tick, and
+// only the links that appeared, disappeared or changed weight band are
+// applied to the graph, in one transaction whose log goes to
+// Router::applyChanges.
+//
+// Links present at construction count as the previous tick: those out of
+// range go on the first tick. Link status is left alone, so a jammed link in
+// range stays DOWN. The node set must not change while the model runs, and
+// tick() must not be called inside a transaction.
+class MobilityModel {
+public:
+    explicit MobilityModel(Graph& g, const MobilityParams& params = MobilityParams{});
+
+    // Trace-driven motion instead of random waypoints. CSV, one
+    // "time_ms,node,x,y" per line, with blank lines, '#' comments and a header
+    // skipped. Nodes move linearly between their samples and hold their first
+    // and last positions outside them; nodes without samples stay put. The
+    // clock starts at the earliest sample. Returns true on success.
+    bool loadTrace(const std::string& path, std::string* errorMsg = nullptr);
+
+    // Advances the clock by one tick, moves every node and applies the link
+    // differences to the graph. Returns the transaction's change log.
+    GraphChangeLog tick();
+
+    double nowMs() const { return nowMs_; }
+    double range() const { return range_; }
+    size_t linkCount() const { return links_.size(); }
+    const MobilityStats& stats() const { return stats_; }
+
+private:
+    struct Walker {
+        double tx, ty;         // waypoint
+        double speed;          // units per ms
+        double pauseLeftMs;
+    };
+    struct Sample {
+        double t;
+        double x, y;
+    };
+    struct InRange {
+        uint64_t key;          // (lower id << 32) | higher id
+        double weight;
+    };
+
+    void moveRandomWaypoint(double dtMs);
+    void moveTrace();
+    void pickWaypoint(Walker& w);
+    void discover();
+    double weightFor(double dist) const;
+
+    Graph& graph_;
+    MobilityParams params_;
+    MobilityStats stats_;
+    std::mt19937_64 rng_;
+    double nowMs_ = 0.0;
+    double range_ = 0.0;
+    double minX_ = 0.0, minY_ = 0.0, maxX_ = 0.0, maxY_ = 0.0;
+
+    std::vector<NodeId> ids_;              // by node position at construction
+    std::vector<double> px_, py_;
+    std::vector<Walker> walkers_;
+    bool traced_ = false;
+    std::vector<std::vector<Sample>> samples_; // by position; empty = stationary
+    std::vector<uint32_t> cursor_;
+
+    // Spatial hash, rebuilt every tick.
+    std::vector<int32_t> cx_, cy_;
+    std::vector<uint32_t> bucketStart_;
+    std::vector<uint32_t> bucketNodes_;
+    std::vector<uint32_t> bucketFill_;
+
+    std::vector<InRange> links_;           // previous tick, sorted by key
+    std::vector<InRange> found_;           // this tick
+    std::vector<GraphEdit> edits_;
+};
+
+} // namespace olsr
@@ -0,0 +1,344 @@
+#include "sim/OlsrSim.h"
+
+#include "core/Metrics.h"
+
+#include <algorithm>
+
+namespace olsr {
+
+namespace {
+
+// RFC 3626 section 19: s1 is newer than s2 under 16-bit wrap-around.
+bool seqNewer(uint16_t s1, uint16_t s2) {
+    return static_cast<int16_t>(static_cast<uint16_t>(s1 - s2)) > 0;
+}
+
+uint64_t msToUs(double ms) { return static_cast<uint64_t>(std::max(0.0, ms) * 1000.0); }
+
+} // namespace
+
+OlsrSimulator::OlsrSimulator(const OlsrSimParams& params)
+    : params_(params), wheel_(params.tickUs) {}
+
+double OlsrSimulator::uniform() {
+    // splitmix64
+    uint64_t z = (rng_ += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * 0x1.0p-53;
+}
+
+void OlsrSimulator::reset(const Graph& g) {
+    wheel_ = TimingWheel(params_.tickUs);
+    stats_ = OlsrSimStats{};
+    nowUs_ = 0;
+    rng_ = params_.seed;
+
+    // Physical view includes DOWN links; their state lives in linkUp_.
+    Graph phys = g;
+    for (auto& l : phys.links()) l.status = LinkStatus::UP;
+    adj_ = Adjacency::build(phys);
+    const uint32_t n = adj_.size();
+    const size_t m = adj_.halfEdges();
+
+    linkUp_.assign(g.links().size(), 0);
+    for (size_t li = 0; li < g.links().size(); ++li) linkUp_[li] = g.links()[li].status == LinkStatus::UP;
+    std::vector<uint32_t> firstHalf(g.links().size(), UINT32_MAX);
+    reverse_.assign(m, 0);
+    for (uint32_t e = 0; e < m; ++e) {
+        uint32_t& f = firstHalf[adj_.linkIndex[e]];
+        if (f == UINT32_MAX) {
+            f = e;
+        } else {
+            reverse_[e] = f;
+            reverse_[f] = e;
+        }
+    }
+    if (params_.useMpr) mpr_.computeAll(g);
+    heardUs_.assign(m, 0);
+    sym_.assign(m, 0);
+
+    ansn_.assign(n, 0);
+    msgSeq_.assign(n, 0);
+    tcPending_.assign(n, 0);
+    spfPending_.assign(n, 0);
+    known_.assign(n, 0);
+    payloads_.assign(n, {});
+    lsdb_.assign(static_cast<size_t>(n) * n, 0);
+    relayed_.assign(params_.useMpr ? static_cast<size_t>(n) * n : 0, 0);
+    routes_.assign(n, {});
+    hasRoutes_.assign(n, 0);
+
+    spfView_ = Adjacency{};
+    spfView_.ids = adj_.ids;
+    spfView_.byId = adj_.byId;
+
+    // Desynchronized timers, as real nodes boot at different times.
+    for (uint32_t i = 0; i < n; ++i) {
+        at(msToUs(uniform() * params_.helloIntervalMs), HelloTimer, i);
+        at(msToUs(params_.helloIntervalMs + uniform() * params_.tcIntervalMs), TcTimer, i);
+    }
+}
+
+bool OlsrSimulator::syncLinks(const Graph& g) {
+    if (g.links().size() != linkUp_.size() || g.nodes().size() != adj_.size()) return false;
+    for (uint32_t e = 0; e < adj_.halfEdges(); ++e) {
+        const Link& l = g.links()[adj_.linkIndex[e]];
+        linkUp_[adj_.linkIndex[e]] = l.status == LinkStatus::UP;
+        if (adj_.weights[e] != l.weight) {
+            adj_.weights[e] = l.weight;
+            // Re-advertise with the new metric if the neighbor is established.
+            uint32_t owner = adj_.targets[reverse_[e]];
+            if (sym_[e]) neighborsChanged(owner);
+        }
+    }
+    if (params_.useMpr) mpr_.sync(g);
+    return true;
+}
+
+void OlsrSimulator::at(uint64_t timeUs, uint32_t kind, uint32_t node, uint32_t a, uint32_t b, uint32_t c) {
+    wheel_.schedule(SimEvent{timeUs, kind, node, a, b, c});
+}
+
+void OlsrSimulator::runUntil(double ms) {
+    OLSR_PHASE(SimRun);
+    const uint64_t limit = msToUs(ms);
+    const uint64_t before = stats_.events;
+    SimEvent e;
+    while (wheel_.popUntil(limit, e)) {
+        nowUs_ = std::max(nowUs_, e.timeUs);
+        ++stats_.events;
+        handle(e);
+    }
+    OLSR_COUNT(SimEvents, stats_.events - before);
+    nowUs_ = std::max(nowUs_, limit);
+}
+
+void OlsrSimulator::handle(const SimEvent& e) {
+    switch (e.kind) {
+    case HelloTimer:
+        onHelloTimer(e.node);
+        break;
+    case HelloRx:
+        heardUs_[e.a] = nowUs_;
+        if (!sym_[e.a]) {
+            sym_[e.a] = 1;
+            neighborsChanged(e.node);
+        }
+        break;
+    case TcTimer:
+        originate(e.node);
+        at(nowUs_ + msToUs(params_.tcIntervalMs), TcTimer, e.node);
+        break;
+    case TcOriginate:
+        tcPending_[e.node] = 0;
+        originate(e.node);
+        break;
+    case TcRx:
+        onTcRx(e.node, e.a, e.b, e.c);
+        release(e.a, static_cast<uint16_t>(e.b & 0xFFFF));
+        break;
+    case SpfRun:
+        spfPending_[e.node] = 0;
+        runSpf(e.node);
+        break;
+    }
+}
+
+void OlsrSimulator::onHelloTimer(uint32_t n) {
+    const uint64_t hold = msToUs(params_.neighborHoldMs);
+    bool changed = false;
+    for (uint32_t e = adj_.offsets[n]; e < adj_.offsets[n + 1]; ++e) {
+        if (sym_[e] && nowUs_ - heardUs_[e] > hold) {
+            sym_[e] = 0;
+            changed = true;
+        }
+    }
+    if (changed) neighborsChanged(n);
+    for (uint32_t e = adj_.offsets[n]; e < adj_.offsets[n + 1]; ++e) {
+        transmit(e, HelloRx, reverse_[e], 0, n);
+    }
+    ++stats_.helloSent;
+    at(nowUs_ + msToUs(params_.helloIntervalMs), HelloTimer, n);
+}
+
+void OlsrSimulator::neighborsChanged(uint32_t n) {
+    const uint16_t previous = ansn_[n];
+    if (++ansn_[n] == 0) ansn_[n] = 1;
+    // A version nothing refers to any more takes the new neighbor set; after
+    // an ANSN wrap the entry of the same number is overwritten, as before.
+    auto& versions = payloads_[n];
+    TcVersion* slot = nullptr;
+    for (TcVersion& v : versions) {
+        if (v.ansn == ansn_[n]) {
+            slot = &v;
+            break;
+        }
+        if (!slot && v.refs == 0) slot = &v;
+    }
+    if (!slot) slot = &versions.emplace_back();
+    if (slot->ansn != ansn_[n]) *slot = TcVersion{ansn_[n], 0, std::move(slot->payload)};
+    ++slot->refs;
+    TcPayload& p = slot->payload;
+    p.neighbors.clear();
+    p.weights.clear();
+    for (uint32_t e = adj_.offsets[n]; e < adj_.offsets[n + 1]; ++e) {
+        if (!sym_[e]) continue;
+        p.neighbors.push_back(adj_.targets[e]);
+        p.weights.push_back(adj_.weights[e]);
+    }
+    if (previous != 0) release(n, previous);
+    // Triggered TC, coalesced with any other change in the same instant.
+    if (!tcPending_[n]) {
+        tcPending_[n] = 1;
+        at(nowUs_, TcOriginate, n);
+    }
+    scheduleSpf(n);
+}
+
+void OlsrSimulator::originate(uint32_t n) {
+    if (ansn_[n] == 0) return; // nothing to advertise yet
+    if (++msgSeq_[n] == 0) msgSeq_[n] = 1; // 0 marks "never relayed"
+    ++stats_.tcOriginated;
+    const uint32_t packed = (static_cast<uint32_t>(msgSeq_[n]) << 16) | ansn_[n];
+    for (uint32_t e = adj_.offsets[n]; e < adj_.offsets[n + 1]; ++e) {
+        if (sym_[e]) transmit(e, TcRx, n, packed, n);
+    }
+}
+
+void OlsrSimulator::onTcRx(uint32_t n, uint32_t origin, uint32_t packed, uint32_t sender) {
+    ++stats_.tcReceived;
+    if (origin == n) {
+        ++stats_.tcDuplicates;
+        return;
+    }
+    const size_t slot = static_cast<size_t>(n) * adj_.size() + origin;
+    uint32_t& cell = lsdb_[slot];
+    const uint16_t msg = static_cast<uint16_t>(packed >> 16);
+    const uint16_t ansn = static_cast<uint16_t>(packed & 0xFFFF);
+    if (cell != 0 && !seqNewer(msg, static_cast<uint16_t>(cell >> 16))) {
+        ++stats_.tcDuplicates;
+        // A copy of the latest message from an MPR selector must still be
+        // relayed if the first copy came from a non-selector.
+        if (!params_.useMpr || msg != static_cast<uint16_t>(cell >> 16)) return;
+    } else {
+        uint16_t held = static_cast<uint16_t>(cell & 0xFFFF);
+        if (cell == 0) ++known_[n];
+        if (cell == 0 || seqNewer(ansn, held)) {
+            if (cell != 0) release(origin, held);
+            retain(origin, ansn);
+            held = ansn;
+            ++stats_.lsdbUpdates;
+            stats_.lastLsdbUpdateMs = nowMs();
+            scheduleSpf(n);
+        }
+        cell = (static_cast<uint32_t>(msg) << 16) | held;
+    }
+    if (params_.useMpr) {
+        if (relayed_[slot] == msg || !mpr_.selects(sender, n)) return;
+        relayed_[slot] = msg;
+    }
+    forward(n, origin, packed, sender);
+}
+
+void OlsrSimulator::forward(uint32_t n, uint32_t origin, uint32_t packed, uint32_t sender) {
+    ++stats_.tcForwarded;
+    for (uint32_t e = adj_.offsets[n]; e < adj_.offsets[n + 1]; ++e) {
+        if (sym_[e] && adj_.targets[e] != sender) transmit(e, TcRx, origin, packed, n);
+    }
+}
+
+void OlsrSimulator::transmit(uint32_t halfEdge, uint32_t kind, uint32_t a, uint32_t b, uint32_t c) {
+    if (!linkUp_[adj_.linkIndex[halfEdge]] || (params_.lossProb > 0.0 && uniform() < params_.lossProb)) {
+        ++stats_.dropped;
+        return;
+    }
+    if (kind == TcRx) retain(a, static_cast<uint16_t>(b & 0xFFFF));
+    const double delayMs = params_.latencyMs + (params_.jitterMs > 0.0 ? uniform() * params_.jitterMs : 0.0);
+    at(nowUs_ + msToUs(delayMs), kind, adj_.targets[halfEdge], a, b, c);
+}
+
+OlsrSimulator::TcVersion* OlsrSimulator::version(uint32_t origin, uint16_t ansn) {
+    // Every ANSN in a cell or a message is referenced, so its entry is found.
+    for (TcVersion& v : payloads_[origin]) {
+        if (v.ansn == ansn) return &v;
+    }
+    return nullptr;
+}
+
+void OlsrSimulator::scheduleSpf(uint32_t n) {
+    if (params_.spfDelayMs < 0.0 || spfPending_[n]) return;
+    spfPending_[n] = 1;
+    at(nowUs_ + msToUs(params_.spfDelayMs), SpfRun, n);
+}
+
+void OlsrSimulator::runSpf(uint32_t n) {
+    // Topology as n believes it: its own symmetric neighbors plus the
+    // advertised neighbor set of every origin in its LSDB.
+    const uint32_t count = adj_.size();
+    const uint32_t* cells = lsdb_.data() + static_cast<size_t>(n) * count;
+    spfView_.offsets.assign(count + 1, 0);
+    spfView_.targets.clear();
+    spfView_.weights.clear();
+    for (uint32_t u = 0; u < count; ++u) {
+        if (u == n) {
+            for (uint32_t e = adj_.offsets[n]; e < adj_.offsets[n + 1]; ++e) {
+                if (!sym_[e]) continue;
+                spfView_.targets.push_back(adj_.targets[e]);
+                spfView_.weights.push_back(adj_.weights[e]);
+            }
+        } else if (cells[u] != 0) {
+            const TcPayload& p = version(u, static_cast<uint16_t>(cells[u] & 0xFFFF))->payload;
+            spfView_.targets.insert(spfView_.targets.end(), p.neighbors.begin(), p.neighbors.end());
+            spfView_.weights.insert(spfView_.weights.end(), p.weights.begin(), p.weights.end());
+        }
+        spfView_.offsets[u + 1] = static_cast<uint32_t>(spfView_.targets.size());
+    }
+    routes_[n] = spf_.compute(spfView_, n);
+    hasRoutes_[n] = 1;
+    ++stats_.spfRuns;
+}
+
+uint32_t OlsrSimulator::lsdbSize(NodeId id) const {
+    auto it = adj_.index.find(id);
+    return it == adj_.index.end() ? 0 : known_[it->second];
+}
+
+const RouteTable* OlsrSimulator::routes(NodeId id) const {
+    auto it = adj_.index.find(id);
+    if (it == adj_.index.end() || !hasRoutes_[it->second]) return nullptr;
+    return &routes_[it->second];
+}
+
+bool OlsrSimulator::lsdbConverged() const {
+    const uint32_t n = adj_.size();
+    // Physical components over UP links.
+    std::vector<uint32_t> comp(n, UINT32_MAX), stack;
+    for (uint32_t s = 0; s < n; ++s) {
+        if (comp[s] != UINT32_MAX) continue;
+        comp[s] = s;
+        stack.push_back(s);
+        while (!stack.empty()) {
+            uint32_t u = stack.back();
+            stack.pop_back();
+            for (uint32_t e = adj_.offsets[u]; e < adj_.offsets[u + 1]; ++e) {
+                uint32_t v = adj_.targets[e];
+                if (linkUp_[adj_.linkIndex[e]] && comp[v] == UINT32_MAX) {
+                    comp[v] = s;
+                    stack.push_back(v);
+                }
+            }
+        }
+    }
+    for (uint32_t v = 0; v < n; ++v) {
+        const uint32_t* cells = lsdb_.data() + static_cast<size_t>(v) * n;
+        for (uint32_t o = 0; o < n; ++o) {
+            if (o == v || comp[o] != comp[v] || ansn_[o] == 0) continue;
+            if ((cells[o] & 0xFFFF) != ansn_[o]) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace olsr
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "core/Adjacency.h"
+#include "core/Graph.h"
+#include "route/Dijkstra.h"
+#include "route/Mpr.h"
+#include "sim/TimingWheel.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace olsr {
+
+struct OlsrSimParams {
+    double helloIntervalMs = 2000.0;
+    double tcIntervalMs = 5000.0;
+    double neighborHoldMs = 6000.0; // neighbor expires after this long without a HELLO
+    double latencyMs = 1.0;         // per-hop delivery delay
+    double jitterMs = 0.5;          // uniform extra delay in [0, jitterMs)
+    double lossProb = 0.0;          // per-transmission drop probability
+    double spfDelayMs = 50.0;       // debounce before a node reruns SPF; < 0 disables SPF
+    bool useMpr = false;            // forward TCs only when the sender selected us as MPR
+    uint64_t tickUs = 100;          // timing wheel resolution
+    uint64_t seed = 1;
+};
+
+struct OlsrSimStats {
+    uint64_t events = 0;
+    uint64_t helloSent = 0;
+    uint64_t tcOriginated = 0;
+    uint64_t tcForwarded = 0;   // retransmissions by nodes other than the originator
+    uint64_t tcReceived = 0;
+    uint64_t tcDuplicates = 0;
+    uint64_t dropped = 0;       // transmissions lost to lossProb or a DOWN link
+    uint64_t lsdbUpdates = 0;   // LSDB entries replaced by a newer ANSN
+    uint64_t spfRuns = 0;
+    double lastLsdbUpdateMs = 0.0;
+};
+
+// Discrete-event model of OLSR control traffic over the links of a Graph.
+// Nodes discover neighbors with periodic HELLOs, flood TC messages carrying
+// their advertised neighbor set (ANSN-versioned, duplicate-suppressed by
+// message sequence number) and compute routes from their own LSDB only.
+// Sequence numbers are 16-bit with RFC 3626 wrap-around comparison. With
+// useMpr, MPR sets are taken from the current physical topology rather than
+// learned from HELLO-advertised 2-hop information.
+class OlsrSimulator {
+public:
+    explicit OlsrSimulator(const OlsrSimParams& params = OlsrSimParams{});
+
+    // Cold start over g's nodes and links; all protocol state is cleared.
+    void reset(const Graph& g);
+    // Picks up link status and weight changes made to g since reset(). The
+    // node and link lists must be unchanged; returns false otherwise.
+    bool syncLinks(const Graph& g);
+    void runUntil(double ms);
+
+    double nowMs() const { return static_cast<double>(nowUs_) / 1000.0; }
+    const OlsrSimStats& stats() const { return stats_; }
+    const OlsrSimParams& params() const { return params_; }
+    void setParams(const OlsrSimParams& p) { params_ = p; } // applies on reset()
+    size_t pendingEvents() const { return wheel_.size(); }
+
+    size_t nodeCount() const { return adj_.size(); }
+    // Number of origins present in n's LSDB.
+    uint32_t lsdbSize(NodeId n) const;
+    // Routes n computed from its own LSDB (null until its first SPF).
+    const RouteTable* routes(NodeId n) const;
+    // True once every node holds the current ANSN of every origin it is
+    // physically connected to. O(N^2); meant for reporting, not per event.
+    bool lsdbConverged() const;
+
+private:
+    enum Kind : uint32_t { HelloTimer, HelloRx, TcTimer, TcOriginate, TcRx, SpfRun };
+
+    struct TcPayload {
+        std::vector<uint32_t> neighbors;
+        std::vector<double> weights;
+    };
+    // One advertised neighbor set of an origin. refs counts what still names
+    // it: the origin's current ANSN, LSDB cells and TCs in flight. Entries at
+    // zero are reused, so an origin keeps only the versions still in use.
+    struct TcVersion {
+        uint16_t ansn = 0;
+        uint32_t refs = 0;
+        TcPayload payload;
+    };
+
+    void handle(const SimEvent& e);
+    void onHelloTimer(uint32_t n);
+    void onTcRx(uint32_t n, uint32_t origin, uint32_t packed, uint32_t sender);
+    void neighborsChanged(uint32_t n);
+    void originate(uint32_t n);
+    void forward(uint32_t n, uint32_t origin, uint32_t packed, uint32_t sender);
+    void transmit(uint32_t halfEdge, uint32_t kind, uint32_t a, uint32_t b, uint32_t c);
+    TcVersion* version(uint32_t origin, uint16_t ansn);
+    void retain(uint32_t origin, uint16_t ansn) { ++version(origin, ansn)->refs; }
+    void release(uint32_t origin, uint16_t ansn) { --version(origin, ansn)->refs; }
+    void scheduleSpf(uint32_t n);
+    void runSpf(uint32_t n);
+    void at(uint64_t timeUs, uint32_t kind, uint32_t node, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+    double uniform();
+
+    OlsrSimParams params_;
+    OlsrSimStats stats_;
+    TimingWheel wheel_;
+    uint64_t nowUs_ = 0;
+    uint64_t rng_ = 1;
+
+    // Physical topology: every link of the graph, UP or DOWN.
+    Adjacency adj_;
+    std::vector<uint32_t> reverse_;      // half-edge -> opposite half-edge
+    std::vector<uint8_t> linkUp_;        // per Graph link
+    // Per half-edge, seen from the row's node.
+    std::vector<uint64_t> heardUs_;
+    std::vector<uint8_t> sym_;
+
+    // Per node protocol state.
+    std::vector<uint16_t> ansn_;
+    std::vector<uint16_t> msgSeq_;
+    std::vector<uint8_t> tcPending_;
+    std::vector<uint8_t> spfPending_;
+    std::vector<uint32_t> known_;        // origins in the node's LSDB
+    std::vector<std::vector<TcVersion>> payloads_; // per origin, live versions
+    // N x N LSDB cells: (last message seq << 16) | ANSN, 0 = unknown origin.
+    std::vector<uint32_t> lsdb_;
+    // Same layout, useMpr only: message seq last retransmitted (0 = none).
+    std::vector<uint16_t> relayed_;
+    std::vector<RouteTable> routes_;
+    std::vector<uint8_t> hasRoutes_;
+
+    MprSelector mpr_;
+    Adjacency spfView_;                  // scratch CSR rebuilt per SPF
+    DijkstraEngine spf_;
+};
+
+} // namespace olsr
@@ -0,0 +1,62 @@
+#include "sim/TimingWheel.h"
+
+namespace olsr {
+
+TimingWheel::TimingWheel(uint64_t tickUs, uint32_t slotsLog2)
+    : tickUs_(tickUs ? tickUs : 1), mask_((uint64_t{1} << slotsLog2) - 1), slots_(size_t{1} << slotsLog2) {}
+
+void TimingWheel::clear() {
+    for (auto& s : slots_) s.clear();
+    overflow_ = {};
+    curTick_ = 0;
+    readIdx_ = 0;
+    inWheel_ = 0;
+}
+
+void TimingWheel::schedule(const SimEvent& e) {
+    uint64_t t = e.timeUs / tickUs_;
+    if (t < curTick_) t = curTick_;
+    if (t - curTick_ <= mask_) {
+        slots_[t & mask_].push_back(e);
+        ++inWheel_;
+    } else {
+        overflow_.push(e);
+    }
+}
+
+void TimingWheel::advance() {
+    // Give back capacity left over from bursts so idle slots stay small.
+    auto& done = slots_[curTick_ & mask_];
+    if (done.capacity() > kKeepCapacity) std::vector<SimEvent>().swap(done);
+    else done.clear();
+    readIdx_ = 0;
+    // Skip idle stretches straight to the next overflow event.
+    if (inWheel_ == 0 && !overflow_.empty()) curTick_ = overflow_.top().timeUs / tickUs_;
+    else ++curTick_;
+    // Pull overflow events that now fall inside the horizon.
+    while (!overflow_.empty() && overflow_.top().timeUs / tickUs_ - curTick_ <= mask_) {
+        const SimEvent& e = overflow_.top();
+        uint64_t t = e.timeUs / tickUs_;
+        slots_[(t < curTick_ ? curTick_ : t) & mask_].push_back(e);
+        ++inWheel_;
+        overflow_.pop();
+    }
+}
+
+bool TimingWheel::popUntil(uint64_t limitUs, SimEvent& out) {
+    while (size() > 0) {
+        if (curTick_ * tickUs_ > limitUs) return false;
+        auto& slot = slots_[curTick_ & mask_];
+        if (readIdx_ < slot.size()) {
+            out = slot[readIdx_++];
+            --inWheel_;
+            return true;
+        }
+        const uint64_t next = (inWheel_ == 0) ? overflow_.top().timeUs / tickUs_ : curTick_ + 1;
+        if (next * tickUs_ > limitUs) return false;
+        advance();
+    }
+    return false;
+}
+
+} // namespace olsr
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+namespace olsr {
+
+struct SimEvent {
+    uint64_t timeUs;
+    uint32_t kind;
+    uint32_t node;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+};
+
+// Single-level timing wheel with an overflow heap for events beyond the wheel
+// horizon. Events are released in tick order; within one tick they come out
+// in scheduling order, which keeps runs deterministic.
+class TimingWheel {
+public:
+    explicit TimingWheel(uint64_t tickUs = 100, uint32_t slotsLog2 = 14);
+
+    void clear();
+    void schedule(const SimEvent& e);
+    // Pops the next event due at or before limitUs; false if there is none.
+    bool popUntil(uint64_t limitUs, SimEvent& out);
+
+    uint64_t nowUs() const { return curTick_ * tickUs_; }
+    uint64_t tickUs() const { return tickUs_; }
+    size_t size() const { return inWheel_ + overflow_.size(); }
+
+private:
+    struct Later {
+        bool operator()(const SimEvent& a, const SimEvent& b) const { return a.timeUs > b.timeUs; }
+    };
+
+    void advance();
+
+    static constexpr size_t kKeepCapacity = 256;
+
+    uint64_t tickUs_;
+    uint64_t mask_;
+    uint64_t curTick_ = 0;
+    size_t readIdx_ = 0;
+    size_t inWheel_ = 0;
+    std::vector<std::vector<SimEvent>> slots_;
+    std::priority_queue<SimEvent, std::vector<SimEvent>, Later> overflow_;
+};
+
+} // namespace olsr
@@ -0,0 +1,207 @@
+#include "sim/TraceReplay.h"
+
+#include "core/Metrics.h"
+#include "io/TraceReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+
+namespace olsr {
+
+namespace {
+
+constexpr size_t kLatencyReservoir = 1 << 16;
+
+uint64_t linkKey(NodeId a, NodeId b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+} // namespace
+
+TraceReplayer::TraceReplayer(Graph& g, Router& router, const ReplayParams& params)
+    : graph_(g), router_(router), params_(params), hyst_(params.hyst) {}
+
+bool TraceReplayer::run(const std::string& path, std::string* errorMsg) {
+    TraceReader reader;
+    if (!reader.open(path, errorMsg)) return false;
+
+    stats_ = ReplayStats{};
+    hyst_ = HysteresisController(params_.hyst);
+    latencies_.clear();
+    latencySeen_ = 0;
+    lastChangeMs_ = 0.0;
+
+    std::vector<Link>& links = graph_.links();
+    std::unordered_map<uint64_t, uint32_t> linkIndex;
+    linkIndex.reserve(links.size() * 2);
+    for (uint32_t i = 0; i < links.size(); ++i) linkIndex.emplace(linkKey(links[i].u, links[i].v), i);
+
+    working_ = graph_;
+    lastWeight_.assign(links.size(), kCostInfinity);
+    lastUp_.assign(links.size(), 2); // forces the first recompute
+    nextHops_.clear();
+
+    auto start = std::chrono::steady_clock::now();
+    TraceEvent ev;
+    bool started = false;
+    double t0 = 0.0;
+    double stepEnd = 0.0;
+    double now = 0.0;
+    double last = 0.0;
+    const bool perTimestamp = params_.stepMs <= 0.0;
+    while (reader.next(ev)) {
+        if (!started) {
+            started = true;
+            t0 = ev.timeMs;
+            last = t0;
+            now = t0;
+            stepEnd = perTimestamp ? t0 : t0 + params_.stepMs;
+        }
+        if (perTimestamp) {
+            if (ev.timeMs > stepEnd) {
+                step(stepEnd, stepEnd - now);
+                now = stepEnd;
+                stepEnd = ev.timeMs;
+            }
+        } else if (ev.timeMs >= stepEnd) {
+            step(stepEnd, params_.stepMs);
+            stepEnd += params_.stepMs;
+            // Quiet stretches still advance the filter until it settles and no
+            // hold-down can release a pending flip, then jump to the next event.
+            while (ev.timeMs >= stepEnd) {
+                if (stepEnd - lastChangeMs_ >= params_.hyst.holdMs + params_.stepMs) {
+                    stepEnd += std::floor((ev.timeMs - stepEnd) / params_.stepMs) * params_.stepMs;
+                    if (ev.timeMs >= stepEnd) stepEnd += params_.stepMs;
+                    break;
+                }
+                step(stepEnd, params_.stepMs);
+                stepEnd += params_.stepMs;
+            }
+        }
+
+        ++stats_.events;
+        last = std::max(last, ev.timeMs);
+        auto it = linkIndex.find(linkKey(ev.u, ev.v));
+        if (it == linkIndex.end()) {
+            ++stats_.skipped;
+            continue;
+        }
+        Link& l = links[it->second];
+        if (!std::isnan(ev.weight)) {
+            l.weight = ev.weight;
+            if (!l.jammed) l.orig_weight = ev.weight;
+        }
+        if (ev.status >= 0) {
+            l.status = ev.status ? LinkStatus::UP : LinkStatus::DOWN;
+            l.manually_jammed = (l.status == LinkStatus::DOWN);
+            graph_.invalidateConnectivity();
+        }
+    }
+    if (started) {
+        step(stepEnd, perTimestamp ? stepEnd - now : params_.stepMs);
+        stats_.virtualMs = last - t0;
+    }
+
+    stats_.malformed = reader.malformed();
+    OLSR_COUNT(BytesImported, reader.bytesRead());
+    stats_.wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!latencies_.empty()) {
+        std::sort(latencies_.begin(), latencies_.end());
+        auto pct = [&](double p) {
+            return latencies_[std::min(latencies_.size() - 1, static_cast<size_t>(p * latencies_.size()))];
+        };
+        stats_.latencyP50Us = pct(0.50);
+        stats_.latencyP99Us = pct(0.99);
+    }
+    return true;
+}
+
+void TraceReplayer::step(double nowMs, double dtMs) {
+    OLSR_PHASE(ReplayStep);
+    ++stats_.steps;
+    const std::vector<Link>& raw = graph_.links();
+    std::vector<Link>& eff = working_.links();
+    for (size_t i = 0; i < raw.size(); ++i) {
+        eff[i].weight = raw[i].weight;
+        eff[i].orig_weight = raw[i].orig_weight;
+        eff[i].status = raw[i].status;
+        eff[i].manually_jammed = raw[i].manually_jammed;
+    }
+    working_.invalidateConnectivity();
+    if (params_.hysteresis) hyst_.apply(working_, nowMs, dtMs);
+    if (effectiveChanged()) {
+        lastChangeMs_ = nowMs;
+        recompute();
+    }
+}
+
+bool TraceReplayer::effectiveChanged() {
+    bool changed = false;
+    const std::vector<Link>& eff = working_.links();
+    for (size_t i = 0; i < eff.size(); ++i) {
+        const int64_t w = quantizeCost(eff[i].weight);
+        const uint8_t up = eff[i].status == LinkStatus::UP;
+        if (up != lastUp_[i]) {
+            if (lastUp_[i] != 2) ++stats_.statusFlips;
+            lastUp_[i] = up;
+            changed = true;
+        }
+        if (w != lastWeight_[i]) {
+            lastWeight_[i] = w;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void TraceReplayer::recompute() {
+    auto t = std::chrono::steady_clock::now();
+    router_.recomputeAll(working_);
+    sampleLatency(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t).count());
+    ++stats_.recomputes;
+
+    const std::vector<Node>& nodes = working_.nodes();
+    const size_t n = nodes.size();
+    std::unordered_map<NodeId, uint32_t> index;
+    index.reserve(n * 2);
+    for (uint32_t i = 0; i < n; ++i) index.emplace(nodes[i].id, i);
+
+    const bool first = nextHops_.empty();
+    std::vector<NodeId> row(n);
+    if (first) nextHops_.assign(n * n, 0);
+    for (size_t s = 0; s < n; ++s) {
+        std::fill(row.begin(), row.end(), 0);
+        if (const RouteTable* tbl = router_.table(nodes[s].id)) {
+            for (const RouteEntry& e : *tbl) {
+                auto it = index.find(e.destination);
+                if (it != index.end()) row[it->second] = e.next_hop;
+            }
+        }
+        NodeId* prev = &nextHops_[s * n];
+        if (!first) {
+            for (size_t d = 0; d < n; ++d) stats_.routeChanges += prev[d] != row[d];
+        }
+        std::copy(row.begin(), row.end(), prev);
+    }
+}
+
+void TraceReplayer::sampleLatency(double us) {
+    stats_.latencyMaxUs = std::max(stats_.latencyMaxUs, us);
+    ++latencySeen_;
+    if (latencies_.size() < kLatencyReservoir) {
+        latencies_.push_back(us);
+        return;
+    }
+    // splitmix64 keeps the sample reproducible for a given recompute count
+    uint64_t z = (rng_ += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    const uint64_t slot = z % latencySeen_;
+    if (slot < kLatencyReservoir) latencies_[slot] = us;
+}
+
+} // namespace olsr
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "core/Graph.h"
+#include "hyst/Hysteresis.h"
+#include "route/Router.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace olsr {
+
+struct ReplayParams {
+    // Virtual interval between hysteresis updates and recomputes. Events within
+    // one step are coalesced; <= 0 steps once per distinct event timestamp.
+    double stepMs = 1000.0;
+    bool hysteresis = true;
+    HysteresisParams hyst;
+};
+
+struct ReplayStats {
+    uint64_t events = 0;
+    uint64_t skipped = 0;       // events naming a link that is not in the graph
+    uint64_t malformed = 0;     // unparsable CSV lines
+    uint64_t steps = 0;
+    uint64_t recomputes = 0;    // steps whose effective links changed
+    uint64_t routeChanges = 0;  // (source, destination) next hops that changed
+    uint64_t statusFlips = 0;   // effective UP/DOWN transitions after hysteresis
+    double virtualMs = 0.0;     // trace time covered
+    double wallS = 0.0;
+    double latencyP50Us = 0.0;  // per-recompute wall time
+    double latencyP99Us = 0.0;
+    double latencyMaxUs = 0.0;
+
+    double eventsPerSecond() const { return wallS > 0.0 ? static_cast<double>(events) / wallS : 0.0; }
+    // Effective status flips per link per virtual hour.
+    double flapRate(size_t linkCount) const {
+        return (linkCount && virtualMs > 0.0) ? statusFlips / (linkCount * virtualMs / 3.6e6) : 0.0;
+    }
+};
+
+// Replays a link-metric trace (see TraceReader) through HysteresisController
+// and Router on a virtual clock, headless and as fast as the input streams.
+// Trace weights and statuses land on the graph with setLinkWeight and
+// setLinkStatus semantics; the graph's nodes and links are fixed up front.
+class TraceReplayer {
+public:
+    TraceReplayer(Graph& g, Router& router, const ReplayParams& params = ReplayParams{});
+
+    // Returns true on success; g is left holding the last raw link state and
+    // router the routes of the last effective (filtered) topology.
+    bool run(const std::string& path, std::string* errorMsg = nullptr);
+
+    const ReplayStats& stats() const { return stats_; }
+    // Graph after hysteresis at the last step.
+    const Graph& effective() const { return working_; }
+
+private:
+    void step(double nowMs, double dtMs);
+    bool effectiveChanged();
+    void recompute();
+    void sampleLatency(double us);
+
+    Graph& graph_;
+    Router& router_;
+    ReplayParams params_;
+    HysteresisController hyst_;
+    Graph working_;
+    ReplayStats stats_;
+
+    std::vector<int64_t> lastWeight_;   // quantized effective weights at the last recompute
+    std::vector<uint8_t> lastUp_;
+    std::vector<NodeId> nextHops_;      // N x N, 0 = unreachable
+    std::vector<double> latencies_;     // reservoir sample
+    uint64_t latencySeen_ = 0;
+    uint64_t rng_ = 0x9e3779b97f4a7c15ull;
+    double lastChangeMs_ = 0.0;
+};
+
+} // namespace olsr
@@ -3,12 +3,30 @@
 #include <imgui.h>
 #include <algorithm> 
 #include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#include "core/Metrics.h"
 #include "io/JsonImporter.h"
+#include "route/TrafficEngineering.h"
 
 namespace olsr {
 
 UiOverlay::UiOverlay(Graph& graph, Router& router)
-    : graph_(graph), router_(router) {}
+    : graph_(graph), router_(router) {
+    mpr_.computeAll(graph_);
+    exporter_.attachMpr(&mpr_);
+}
+
+void UiOverlay::record(const GraphChangeLog& cl) {
+    if (journal_ && journal_->isOpen()) journal_->append(graph_, cl);
+}
+
+void UiOverlay::setSelectedLinkStatus(LinkStatus status) {
+    graph_.begin();
+    graph_.setLinkStatus(selU_, selV_, status);
+    record(graph_.commit());
+    log(std::string(status == LinkStatus::DOWN ? "Link jammed" : "Link unjammed") + " (recompute " + recomputeTimed() + ")");
+}
 
 void UiOverlay::log(const std::string& msg) {
     events_.push_back(UiEvent{msg});
@@ -24,12 +42,86 @@ void UiOverlay::draw() {
         prevMs = nowMs;
         hyst_.apply(graph_, nowMs, dtMs);
     }
+    if (simActive_ && simRunning_) {
+        if (!sim_.syncLinks(graph_)) {
+            sim_.reset(graph_);
+            log("Protocol sim restarted (topology changed)");
+        }
+        sim_.runUntil(sim_.nowMs() + ImGui::GetIO().DeltaTime * 1000.0 * simSpeed_);
+    }
+    if (mpr_.sync(graph_) > 0) floodStatsValid_ = false;
+    if (trafficLoaded_) refreshLoads();
+    refreshPlanes();
+    trackComponents();
     drawMenuBar();
     if (showActions_) drawActions();
     if (showTopology_) drawTopologyCanvas();
     if (showInspector_) drawInspector();
     if (showRouting_) drawRoutingTable();
     if (showLog_) drawEventLog();
+    if (showSim_) drawProtocolSim();
+    if (showMetrics_) drawMetrics();
+}
+
+std::string UiOverlay::recomputeTimed() {
+    // Without metrics there is no RecomputeAll phase to read; time it here.
+    auto start = std::chrono::steady_clock::now();
+    router_.recomputeAll(graph_);
+    uint64_t us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    if (metrics::enabled()) us = metrics::snapshot()[metrics::Phase::RecomputeAll].lastNs / 1000;
+    return us >= 1000 ? std::to_string(us / 1000) + " ms" : std::to_string(us) + " micro-s";
+}
+
+void UiOverlay::logSaturated() {
+    const size_t n = router_.saturatedRoutes();
+    if (!n) return;
+    log(std::to_string(n) + " routes cost 2.3e9 or more: their totals are past the cost grid"
+        " and compare as equal");
+}
+
+void UiOverlay::trackComponents() {
+    const uint32_t count = graph_.connectivity().componentCount();
+    if (count == lastComponents_) return;
+    if (lastComponents_ != 0) {
+        if (count > lastComponents_) log("Network partitioned: " + std::to_string(count) + " components");
+        else if (count > 1) log("Partitions merged: " + std::to_string(count) + " components");
+        else log("Network connected again");
+    }
+    lastComponents_ = count;
+}
+
+void UiOverlay::refreshLoads() {
+    // FNV-1a over what routing depends on; loads are redone only when it moves.
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](uint64_t x) { h = (h ^ x) * 1099511628211ull; };
+    mix(graph_.nodes().size());
+    for (const auto& l : graph_.links()) {
+        mix((static_cast<uint64_t>(l.u) << 32) | l.v);
+        mix(static_cast<uint64_t>(quantizeCost(l.weight)));
+        mix(l.status == LinkStatus::UP);
+    }
+    if (h == loadsFingerprint_ && loads_.loads().size() == graph_.links().size()) return;
+    loadsFingerprint_ = h;
+    loads_.compute(graph_, traffic_);
+}
+
+void UiOverlay::refreshPlanes() {
+    if (plane_ >= (int)graph_.planeCount()) plane_ = 0;
+    exporter_.attachPlanes(plane_ > 0 ? &planes_ : nullptr, (uint32_t)plane_);
+    if (plane_ == 0) return;
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](uint64_t x) { h = (h ^ x) * 1099511628211ull; };
+    mix(graph_.nodes().size());
+    mix(graph_.planeCount());
+    for (const auto& l : graph_.links()) {
+        mix((static_cast<uint64_t>(l.u) << 32) | l.v);
+        for (uint32_t p = 0; p < graph_.planeCount(); ++p) mix(static_cast<uint64_t>(quantizeCost(l.metric(p))));
+        mix(l.status == LinkStatus::UP);
+    }
+    if (h == planesFingerprint_ && planes_.planeCount() == graph_.planeCount()) return;
+    planesFingerprint_ = h;
+    planes_.recomputeAll(graph_);
 }
 
 void UiOverlay::drawMenuBar() {
@@ -41,8 +133,24 @@ void UiOverlay::drawMenuBar() {
                 Graph newG;
                 if (imp.loadTopology(loadPathBuf_, newG, &err)) {
                     graph_ = newG;
+                    // The topology says what its weights mean; one without a
+                    // policy is routed by shortest paths.
+                    RoutePolicy policy = RoutePolicy::Shortest;
+                    parseRoutePolicy(imp.policy(), policy);
+                    router_.setPolicy(policy);
                     router_.recomputeAll(graph_);
-                    log(std::string("Loaded topo: ") + loadPathBuf_);
+                    log(std::string("Loaded topo: ") + loadPathBuf_ + " (" + routePolicyName(policy) + " paths)");
+                    // The journal's records continue the previous topology.
+                    if (journal_ && journal_->isOpen()) {
+                        if (journal_->create(journal_->path(), 0, &err)) log("Journal restarted: " + journal_->path());
+                        else log("Journal restart failed: " + err);
+                    }
+                    if (imp.heavyLinks() && policy != RoutePolicy::Reliable) {
+                        log(std::to_string(imp.heavyLinks()) +
+                            " links weigh 2.3e9 or more: the cost grid ends there,"
+                            " so paths over them compare as equal");
+                    }
+                    logSaturated();
                 } else {
                     log(std::string("Load failed: ") + err);
                 }
@@ -64,6 +172,8 @@ void UiOverlay::drawMenuBar() {
             ImGui::MenuItem("Routing Table", nullptr, &showRouting_);
             ImGui::MenuItem("Actions", nullptr, &showActions_);
             ImGui::MenuItem("Event Log", nullptr, &showLog_);
+            ImGui::MenuItem("Protocol Sim", nullptr, &showSim_);
+            ImGui::MenuItem("Metrics", nullptr, &showMetrics_);
             ImGui::Separator();
             ImGui::MenuItem("Enable Hysteresis", nullptr, &hystEnabled_);
             ImGui::EndMenu();
@@ -75,15 +185,7 @@ void UiOverlay::drawMenuBar() {
 void UiOverlay::drawActions() {
     ImGui::Begin("Actions");
     if (ImGui::Button("Recompute")) {
-        auto start = std::chrono::high_resolution_clock::now();
-        router_.recomputeAll(graph_);
-        auto end = std::chrono::high_resolution_clock::now();
-        auto dur_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        if (dur_us >= 1000) {
-            log("Recomputed routes (" + std::to_string(dur_us / 1000) + " ms)");
-        } else {
-            log("Recomputed routes (" + std::to_string(dur_us) + " micro-s)");
-        }
+        log("Recomputed routes (" + recomputeTimed() + ")");
     }
     ImGui::SameLine();
     ImGui::InputText("Export path", exportPathBuf_, sizeof(exportPathBuf_));
@@ -97,12 +199,53 @@ void UiOverlay::drawActions() {
     }
 
     ImGui::Separator();
+    if (ImGui::CollapsingHeader("Traffic")) {
+        ImGui::InputText("Traffic matrix", trafficPathBuf_, sizeof(trafficPathBuf_));
+        if (ImGui::Button("Load traffic")) {
+            JsonImporter imp; std::string err;
+            if (imp.loadTraffic(trafficPathBuf_, traffic_, &err)) {
+                trafficLoaded_ = true;
+                loadsFingerprint_ = 0;
+                refreshLoads();
+                exporter_.attachLoads(&loads_);
+                log("Loaded " + std::to_string(traffic_.demands.size()) + " demands");
+            } else {
+                log(std::string("Traffic load failed: ") + err);
+            }
+        }
+        if (trafficLoaded_) {
+            ImGui::SameLine();
+            if (ImGui::Button("Clear traffic")) {
+                trafficLoaded_ = false;
+                traffic_.demands.clear();
+                exporter_.attachLoads(nullptr);
+            }
+            if (ImGui::Button("Rebalance (TE)")) {
+                TrafficEngineer te;
+                TeResult res = te.run(graph_, traffic_);
+                router_.recomputeAll(graph_);
+                double total = 0.0;
+                for (const auto& it : res.iterations) total += it.wallMs;
+                char msg[160];
+                std::snprintf(msg, sizeof(msg), "TE %s after %zu iterations: max utilization %.1f%% -> %.1f%% (%.0f ms)",
+                              res.converged ? "converged" : "stopped", res.iterations.size() - 1,
+                              100.0 * res.iterations.front().maxUtilization, 100.0 * res.iterations[res.bestIteration].maxUtilization, total);
+                log(msg);
+            }
+            ImGui::SameLine();
+            ImGui::Checkbox("Color links by utilization", &colorByLoad_);
+            ImGui::Text("Max utilization: %.1f%%  max load: %.2f  unroutable: %.2f", 100.0 * loads_.maxUtilization(),
+                        loads_.maxLoad(), loads_.unroutable());
+        }
+    }
     if (ImGui::CollapsingHeader("Topology Management", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::InputText("New node label", newNodeLabel_, sizeof(newNodeLabel_));
         if (ImGui::Button("Add Node")) {
             float x = 100.0f + 20.0f * (float)graph_.nodes().size();
             float y = 100.0f;
+            graph_.begin();
             NodeId nid = graph_.addNode(newNodeLabel_, x, y);
+            record(graph_.commit());
             router_.recomputeAll(graph_);
             log("Added node id=" + std::to_string(nid));
         }
@@ -110,7 +253,10 @@ void UiOverlay::drawActions() {
         ImGui::InputInt("Link v", &newLinkV_);
         ImGui::InputDouble("Link weight", &newLinkWeight_);
         if (ImGui::Button("Add Link")) {
-            if (graph_.addLink((NodeId)newLinkU_, (NodeId)newLinkV_, newLinkWeight_)) {
+            graph_.begin();
+            const bool added = graph_.addLink((NodeId)newLinkU_, (NodeId)newLinkV_, newLinkWeight_);
+            record(graph_.commit());
+            if (added) {
                 router_.recomputeAll(graph_);
                 log("Added link");
             } else {
@@ -119,7 +265,9 @@ void UiOverlay::drawActions() {
         }
         if (selectedNode_) {
             if (ImGui::Button("Delete Selected Node")) {
+                graph_.begin();
                 graph_.removeNode(selectedNode_);
+                record(graph_.commit());
                 selectedNode_ = 0; selU_ = selV_ = 0;
                 router_.recomputeAll(graph_);
                 log("Deleted node");
@@ -127,14 +275,59 @@ void UiOverlay::drawActions() {
         }
         if (selU_ && selV_) {
             if (ImGui::Button("Delete Selected Link")) {
-                // No explicit remove API; emulate by rebuilding links sans selected
-                auto& links = graph_.links();
-                links.erase(std::remove_if(links.begin(), links.end(), [&](const Link& l){ return (l.u == selU_ && l.v == selV_) || (l.u == selV_ && l.v == selU_); }), links.end());
+                graph_.begin();
+                graph_.removeLink(selU_, selV_);
+                record(graph_.commit());
                 selU_ = selV_ = 0;
                 router_.recomputeAll(graph_);
                 log("Deleted link");
             }
         }
+        ImGui::Separator();
+        ImGui::InputText("Change set", changesPathBuf_, sizeof(changesPathBuf_));
+        if (ImGui::Button("Apply change set")) {
+            JsonImporter imp;
+            std::vector<GraphEdit> edits;
+            std::string err;
+            if (!imp.loadChanges(changesPathBuf_, edits, &err)) {
+                log("Change set failed: " + err);
+            } else {
+                graph_.begin();
+                size_t rejected = 0;
+                for (const GraphEdit& e : edits) rejected += !graph_.apply(e);
+                const GraphChangeLog cl = graph_.commit();
+                record(cl);
+                // Hysteresis rewrites weights every frame without recomputing,
+                // so the tables need not match the graph the log starts from.
+                size_t sources = graph_.nodes().size();
+                if (hystEnabled_) router_.recomputeAll(graph_);
+                else sources = router_.applyChanges(graph_, cl);
+                if (!cl.removedNodes.empty()) {
+                    selectedNode_ = 0;
+                    selU_ = selV_ = 0;
+                }
+                char msg[160];
+                std::snprintf(msg, sizeof(msg), "Applied %zu edits (%zu rejected): %zu links changed, %zu sources recomputed",
+                              cl.operations, rejected, cl.links.size(), sources);
+                log(msg);
+            }
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Connectivity")) {
+        const Connectivity& conn = graph_.connectivity();
+        ImGui::Text("Components: %u", conn.componentCount());
+        ImGui::Checkbox("Color nodes by component", &colorByComponent_);
+        if (conn.partitioned()) {
+            const auto comps = conn.components();
+            for (size_t c = 0; c < comps.size() && c < 32; ++c) {
+                std::string list;
+                for (size_t i = 0; i < comps[c].size() && i < 8; ++i) list += (i ? ", " : "") + std::to_string(comps[c][i]);
+                if (comps[c].size() > 8) list += ", ...";
+                ImGui::Text("#%zu: %zu nodes (%s)", c + 1, comps[c].size(), list.c_str());
+            }
+            if (comps.size() > 32) ImGui::Text("... %zu more", comps.size() - 32);
+        }
     }
 
     ImGui::Separator();
@@ -154,31 +347,9 @@ void UiOverlay::drawActions() {
         const Link* l = graph_.findLink(selU_, selV_);
         if (l) {
             if (l->status == LinkStatus::UP) {
-                if (ImGui::Button("Jam Link")) {
-                    auto start = std::chrono::high_resolution_clock::now();
-                    graph_.setLinkStatus(selU_, selV_, LinkStatus::DOWN);
-                    router_.recomputeAll(graph_);
-                    auto end = std::chrono::high_resolution_clock::now();
-                    auto dur_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-                    if (dur_us >= 1000) {
-                        log("Link jammed (recompute " + std::to_string(dur_us / 1000) + " ms)");
-                    } else {
-                        log("Link jammed (recompute " + std::to_string(dur_us) + " micro-s)");
-                    }
-                }
+                if (ImGui::Button("Jam Link")) setSelectedLinkStatus(LinkStatus::DOWN);
             } else {
-                if (ImGui::Button("Unjam Link")) {
-                    auto start = std::chrono::high_resolution_clock::now();
-                    graph_.setLinkStatus(selU_, selV_, LinkStatus::UP);
-                    router_.recomputeAll(graph_);
-                    auto end = std::chrono::high_resolution_clock::now();
-                    auto dur_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-                    if (dur_us >= 1000) {
-                        log("Link unjammed (recompute " + std::to_string(dur_us / 1000) + " ms)");
-                    } else {
-                        log("Link unjammed (recompute " + std::to_string(dur_us) + " micro-s)");
-                    }
-                }
+                if (ImGui::Button("Unjam Link")) setSelectedLinkStatus(LinkStatus::UP);
             }
         }
     }
@@ -195,7 +366,9 @@ void UiOverlay::drawTopologyCanvas() {
     const bool isHovered = ImGui::IsItemHovered();
 
     // Draw links
-    for (const auto& l : graph_.links()) {
+    const bool byLoad = trafficLoaded_ && colorByLoad_ && loads_.loads().size() == graph_.links().size();
+    for (size_t i = 0; i < graph_.links().size(); ++i) {
+        const Link& l = graph_.links()[i];
         const Node* nu = nullptr;
         const Node* nv = nullptr;
         for (const auto& n : graph_.nodes()) {
@@ -204,14 +377,46 @@ void UiOverlay::drawTopologyCanvas() {
         }
         if (!nu || !nv) continue;
         ImU32 col = (l.status == LinkStatus::UP) ? IM_COL32(0,200,0,255) : IM_COL32(200,0,0,255);
-        drawList->AddLine(ImVec2(origin.x + nu->x, origin.y + nu->y), ImVec2(origin.x + nv->x, origin.y + nv->y), col, 2.0f);
+        float thickness = 2.0f;
+        if (byLoad && l.status == LinkStatus::UP) {
+            // Green -> yellow -> red with utilization (relative to the busiest link without capacities).
+            const LinkLoad& ld = loads_.loads()[i];
+            double u = l.capacity > 0.0 ? ld.utilization
+                                        : (loads_.maxLoad() > 0.0 ? std::max(ld.forward, ld.reverse) / loads_.maxLoad() : 0.0);
+            float f = (float)std::min(u, 1.0);
+            col = IM_COL32((int)(255 * std::min(1.0f, 2.0f * f)), (int)(200 * std::min(1.0f, 2.0f - 2.0f * f)), 0, 255);
+            thickness = 2.0f + 4.0f * f;
+        }
+        drawList->AddLine(ImVec2(origin.x + nu->x, origin.y + nu->y), ImVec2(origin.x + nv->x, origin.y + nv->y), col, thickness);
     }
 
-    // Draw nodes
+    // Draw nodes; while the network is split, every component but the largest
+    // gets its own hue.
+    static const ImU32 kComponentColors[] = {
+        IM_COL32(240, 160, 60, 255), IM_COL32(200, 90, 200, 255), IM_COL32(90, 200, 190, 255),
+        IM_COL32(230, 220, 80, 255), IM_COL32(160, 110, 70, 255), IM_COL32(240, 120, 150, 255),
+    };
+    std::unordered_map<NodeId, size_t> componentRank;
+    const Connectivity& conn = graph_.connectivity();
+    if (colorByComponent_ && conn.partitioned()) {
+        const auto comps = conn.components();
+        for (size_t c = 0; c < comps.size(); ++c) componentRank[conn.component(comps[c].front())] = c;
+    }
     const float r = 12.0f;
     for (const auto& n : graph_.nodes()) {
         ImVec2 p(origin.x + n.x, origin.y + n.y);
-        drawList->AddCircleFilled(p, r, IM_COL32(80, 140, 250, 255));
+        ImU32 fill = IM_COL32(80, 140, 250, 255);
+        if (!componentRank.empty()) {
+            const size_t c = componentRank[conn.component(n.id)];
+            if (c > 0) fill = kComponentColors[(c - 1) % (sizeof(kComponentColors) / sizeof(kComponentColors[0]))];
+        }
+        if (simActive_ && graph_.nodes().size() > 1) {
+            // Fade toward grey while the node's own LSDB is incomplete.
+            float f = (float)sim_.lsdbSize(n.id) / (float)(graph_.nodes().size() - 1);
+            if (f > 1.0f) f = 1.0f;
+            fill = IM_COL32((int)(120 - 40 * f), (int)(120 + 20 * f), (int)(120 + 130 * f), 255);
+        }
+        drawList->AddCircleFilled(p, r, fill);
         drawList->AddText(ImVec2(p.x + r + 4, p.y - r), IM_COL32(255,255,255,255), n.label.c_str());
         // selection
         if (isHovered && ImGui::IsMouseClicked(0)) {
@@ -279,6 +484,14 @@ void UiOverlay::drawInspector() {
             const RouteTable* tbl = router_.table(sel->id);
             int rc = tbl ? (int)tbl->size() : 0;
             ImGui::Text("Routes: %d", rc);
+            const Connectivity& conn = graph_.connectivity();
+            ImGui::Text("Component: %u of %u nodes", conn.componentSize(sel->id), (unsigned)graph_.nodes().size());
+            ImGui::Text("2-hop neighbors: %u", mpr_.twoHopCount(sel->id));
+            if (const auto* m = mpr_.mprs(sel->id)) {
+                std::string list;
+                for (NodeId id : *m) list += (list.empty() ? "" : ", ") + std::to_string(id);
+                ImGui::Text("MPRs: %s", list.empty() ? "(none)" : list.c_str());
+            }
         }
     } else if (selU_ && selV_) {
         const Link* l = graph_.findLink(selU_, selV_);
@@ -286,18 +499,21 @@ void UiOverlay::drawInspector() {
             ImGui::Text("Link (%u,%u)", l->u, l->v);
             double w = l->weight;
             if (ImGui::InputDouble("Weight", &w)) {
+                graph_.begin();
                 graph_.setLinkWeight(l->u, l->v, w);
-                auto start = std::chrono::high_resolution_clock::now();
-                router_.recomputeAll(graph_);
-                auto end = std::chrono::high_resolution_clock::now();
-                auto dur_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-                if (dur_us >= 1000) {
-                    log("Weight edited; recomputed (" + std::to_string(dur_us / 1000) + " ms)");
-                } else {
-                    log("Weight edited; recomputed (" + std::to_string(dur_us) + " micro-s)");
+                record(graph_.commit());
+                log("Weight edited; recomputed (" + recomputeTimed() + ")");
+                if (!(w < kCostLimit) && router_.policy() != RoutePolicy::Reliable) {
+                    log("Weight 2.3e9 or more: the cost grid ends there, so paths over this link compare as equal");
                 }
+                logSaturated();
             }
             ImGui::Text("Status: %s", l->status == LinkStatus::UP ? "UP" : "DOWN");
+            if (trafficLoaded_ && loads_.loads().size() == graph_.links().size()) {
+                const LinkLoad& ld = loads_.loads()[l - graph_.links().data()];
+                ImGui::Text("Load u->v: %.2f  v->u: %.2f", ld.forward, ld.reverse);
+                if (l->capacity > 0.0) ImGui::Text("Utilization: %.1f%% of %.2f", 100.0 * ld.utilization, l->capacity);
+            }
             if (hystEnabled_) {
                 if (const HysteresisState* hs = hyst_.state(l->u, l->v)) {
                     ImGui::Text("Filtered: %.3f", hs->filtered);
@@ -307,6 +523,15 @@ void UiOverlay::drawInspector() {
     } else {
         ImGui::Text("Select a node or link");
     }
+    ImGui::Separator();
+    if (ImGui::Button("Measure flooding")) {
+        floodStats_ = mpr_.floodingStats();
+        floodStatsValid_ = true;
+    }
+    if (floodStatsValid_) {
+        ImGui::Text("TC forwards: pure %llu, MPR %llu (-%.1f%%)", (unsigned long long)floodStats_.pureForwards,
+                    (unsigned long long)floodStats_.mprForwards, 100.0 * floodStats_.reduction());
+    }
     ImGui::End();
 }
 
@@ -319,8 +544,13 @@ void UiOverlay::drawRoutingTable() {
         labels.reserve(graph_.nodes().size());
         for (const auto& n : graph_.nodes()) labels.push_back(n.label.c_str());
         ImGui::Combo("Source", &srcIndex, labels.data(), (int)labels.size());
+        if (graph_.planeCount() > 1) {
+            std::vector<const char*> names;
+            for (uint32_t p = 0; p < graph_.planeCount(); ++p) names.push_back(graph_.planeName(p).c_str());
+            if (ImGui::Combo("Plane", &plane_, names.data(), (int)names.size())) refreshPlanes();
+        }
         NodeId src = graph_.nodes()[srcIndex].id;
-        const RouteTable* tbl = router_.table(src);
+        const RouteTable* tbl = plane_ > 0 ? planes_.table((uint32_t)plane_, src) : router_.table(src);
         if (tbl) {
             if (ImGui::BeginTable("rt", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
                 ImGui::TableSetupColumn("Dest");
@@ -348,32 +578,170 @@ void UiOverlay::drawEventLog() {
     ImGui::End();
 }
 
+void UiOverlay::drawProtocolSim() {
+    ImGui::Begin("Protocol Sim");
+    ImGui::InputDouble("Latency ms", &simLatencyMs_);
+    ImGui::InputDouble("Loss prob", &simLossProb_);
+    ImGui::InputDouble("HELLO interval ms", &simHelloMs_);
+    ImGui::InputDouble("TC interval ms", &simTcMs_);
+    ImGui::Checkbox("MPR flooding", &simUseMpr_);
+    if (ImGui::Button(simActive_ ? "Restart" : "Start")) {
+        OlsrSimParams p = sim_.params();
+        p.latencyMs = simLatencyMs_;
+        p.lossProb = simLossProb_;
+        p.helloIntervalMs = simHelloMs_;
+        p.tcIntervalMs = simTcMs_;
+        p.neighborHoldMs = 3.0 * simHelloMs_;
+        p.useMpr = simUseMpr_;
+        sim_.setParams(p);
+        sim_.reset(graph_);
+        simActive_ = simRunning_ = true;
+        log("Protocol sim started");
+    }
+    if (simActive_) {
+        ImGui::SameLine();
+        if (ImGui::Button(simRunning_ ? "Pause" : "Resume")) simRunning_ = !simRunning_;
+        ImGui::SameLine();
+        if (ImGui::Button("Stop")) simActive_ = simRunning_ = false;
+    }
+    ImGui::SliderFloat("Speed (x real time)", &simSpeed_, 0.1f, 100.0f, "%.1f");
+
+    if (simActive_) {
+        const OlsrSimStats& st = sim_.stats();
+        ImGui::Separator();
+        ImGui::Text("Sim time: %.1f ms (%zu pending events)", sim_.nowMs(), sim_.pendingEvents());
+        ImGui::Text("Events: %llu  HELLO: %llu", (unsigned long long)st.events, (unsigned long long)st.helloSent);
+        ImGui::Text("TC originated: %llu  forwarded: %llu", (unsigned long long)st.tcOriginated, (unsigned long long)st.tcForwarded);
+        ImGui::Text("TC received: %llu  duplicates: %llu  dropped: %llu", (unsigned long long)st.tcReceived,
+                    (unsigned long long)st.tcDuplicates, (unsigned long long)st.dropped);
+        ImGui::Text("LSDB updates: %llu  SPF runs: %llu", (unsigned long long)st.lsdbUpdates, (unsigned long long)st.spfRuns);
+        ImGui::Text("Last LSDB change: %.1f ms", st.lastLsdbUpdateMs);
+        if (ImGui::Button("Check convergence")) {
+            log(sim_.lsdbConverged() ? "Protocol sim: all LSDBs converged" : "Protocol sim: LSDBs not converged");
+        }
+        if (selectedNode_) {
+            ImGui::Separator();
+            ImGui::Text("Node %u LSDB: %u origins", selectedNode_, sim_.lsdbSize(selectedNode_));
+            const RouteTable* own = sim_.routes(selectedNode_);
+            const RouteTable* oracle = router_.table(selectedNode_);
+            if (own) {
+                size_t agree = 0;
+                if (oracle) {
+                    for (const auto& e : *own) {
+                        auto it = std::lower_bound(oracle->begin(), oracle->end(), e.destination,
+                            [](const RouteEntry& a, NodeId d){ return a.destination < d; });
+                        if (it != oracle->end() && it->destination == e.destination && it->next_hop == e.next_hop) ++agree;
+                    }
+                }
+                ImGui::Text("Own routes: %zu (%zu agree with oracle of %zu)", own->size(), agree, oracle ? oracle->size() : (size_t)0);
+            } else {
+                ImGui::Text("Own routes: none yet");
+            }
+        }
+    }
+    ImGui::End();
+}
+
+void UiOverlay::drawMetrics() {
+    ImGui::Begin("Metrics");
+    if (!metrics::enabled()) {
+        ImGui::TextUnformatted("Built without OLSR_LITE_ENABLE_METRICS");
+        ImGui::End();
+        return;
+    }
+    const metrics::Snapshot s = metrics::snapshot();
+
+    // Rates over roughly the last half second
+    const double nowS = ImGui::GetTime();
+    if (metricsPrev_.size() != metrics::kCounters) {
+        metricsPrev_.assign(s.counters.begin(), s.counters.end());
+        metricsRate_.assign(metrics::kCounters, 0.0);
+        metricsPrevS_ = nowS;
+    } else if (nowS - metricsPrevS_ >= 0.5) {
+        for (size_t c = 0; c < metrics::kCounters; ++c) {
+            const uint64_t prev = std::min(metricsPrev_[c], s.counters[c]); // reset in between
+            metricsRate_[c] = static_cast<double>(s.counters[c] - prev) / (nowS - metricsPrevS_);
+            metricsPrev_[c] = s.counters[c];
+        }
+        metricsPrevS_ = nowS;
+    }
+
+    if (ImGui::Button("Reset")) {
+        metrics::reset();
+        metricsPrev_.clear();
+    }
+    ImGui::SameLine();
+    if (metrics::tracing()) {
+        if (ImGui::Button("Stop trace")) {
+            metrics::stopTrace();
+            std::string err;
+            if (metrics::writeChromeTrace(traceOutBuf_, &err)) {
+                log("Wrote " + std::to_string(metrics::traceEventCount()) + " trace events to " + traceOutBuf_);
+            } else {
+                log(err);
+            }
+        }
+        ImGui::SameLine();
+        ImGui::Text("recording (%zu events)", metrics::traceEventCount());
+    } else if (ImGui::Button("Record trace")) {
+        metrics::startTrace();
+    }
+    ImGui::InputText("Trace file", traceOutBuf_, sizeof(traceOutBuf_));
+
+    if (ImGui::CollapsingHeader("Counters", ImGuiTreeNodeFlags_DefaultOpen) &&
+        ImGui::BeginTable("counters", 3, ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Counter");
+        ImGui::TableSetupColumn("Total");
+        ImGui::TableSetupColumn("Per second");
+        ImGui::TableHeadersRow();
+        for (size_t c = 0; c < metrics::kCounters; ++c) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(metrics::name(static_cast<metrics::Counter>(c)));
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%llu", static_cast<unsigned long long>(s.counters[c]));
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.0f", c < metricsRate_.size() ? metricsRate_[c] : 0.0);
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::CollapsingHeader("Phases", ImGuiTreeNodeFlags_DefaultOpen) &&
+        ImGui::BeginTable("phases", 6, ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("Last us");
+        ImGui::TableSetupColumn("p50 us");
+        ImGui::TableSetupColumn("p99 us");
+        ImGui::TableSetupColumn("Max us");
+        ImGui::TableHeadersRow();
+        for (size_t p = 0; p < metrics::kPhases; ++p) {
+            const metrics::PhaseStats& ph = s.phases[p];
+            if (ph.count == 0) continue;
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(metrics::name(static_cast<metrics::Phase>(p)));
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%llu", static_cast<unsigned long long>(ph.count));
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.1f", ph.lastNs * 1e-3);
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%.1f", ph.percentileNs(0.5) * 1e-3);
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%.1f", ph.percentileNs(0.99) * 1e-3);
+            ImGui::TableSetColumnIndex(5);
+            ImGui::Text("%.1f", ph.maxNs * 1e-3);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
 void UiOverlay::toggleSelectedLinkJam() {
     if (!(selU_ && selV_)) return;
     const Link* l = graph_.findLink(selU_, selV_);
     if (!l) return;
-    auto start = std::chrono::high_resolution_clock::now();
-    if (l->status == LinkStatus::UP) {
-        graph_.setLinkStatus(selU_, selV_, LinkStatus::DOWN);
-        router_.recomputeAll(graph_);
-        auto end = std::chrono::high_resolution_clock::now();
-        auto dur_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        if (dur_us >= 1000) {
-            log("Link jammed (recompute " + std::to_string(dur_us / 1000) + " ms)");
-        } else {
-            log("Link jammed (recompute " + std::to_string(dur_us) + " micro-s)");
-        }
-    } else {
-        graph_.setLinkStatus(selU_, selV_, LinkStatus::UP);
-        router_.recomputeAll(graph_);
-        auto end = std::chrono::high_resolution_clock::now();
-        auto dur_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        if (dur_us >= 1000) {
-            log("Link unjammed (recompute " + std::to_string(dur_us / 1000) + " ms)");
-        } else {
-            log("Link unjammed (recompute " + std::to_string(dur_us) + " micro-s)");
-        }
-    }
+    setSelectedLinkStatus(l->status == LinkStatus::UP ? LinkStatus::DOWN : LinkStatus::UP);
 }
 
 } // namespace olsr
@@ -2,8 +2,13 @@
 
 #include "core/Graph.h"
 #include "route/Router.h"
+#include "io/ChangeJournal.h"
 #include "io/JsonExporter.h"
 #include "hyst/Hysteresis.h"
+#include "route/LinkLoad.h"
+#include "route/Mpr.h"
+#include "route/MultiPlaneSpf.h"
+#include "sim/OlsrSim.h"
 
 #include <string>
 #include <vector>
@@ -25,6 +30,13 @@ public:
     // Keyboard actions
     void toggleSelectedLinkJam();
 
+    // Appends every recorded topology edit made from the panels to journal
+    // (null stops). TE rebalancing and hysteresis write weights directly and
+    // are not journaled; loading a topology restarts the journal.
+    void attachJournal(ChangeJournal* journal) { journal_ = journal; }
+    // False while hysteresis rewrites weights without recomputing routes.
+    bool routesCurrent() const { return !hystEnabled_; }
+
     // State access
     const std::vector<UiEvent>& events() const { return events_; }
 
@@ -35,13 +47,34 @@ private:
     void drawRoutingTable();
     void drawActions();
     void drawEventLog();
+    void drawProtocolSim();
+    void drawMetrics();
+    void refreshLoads();
+    // Reroutes every metric plane when a plane other than 0 is selected and
+    // the links moved; points the exporter at the selected plane.
+    void refreshPlanes();
+    // Logs partitions and merges as the component count moves.
+    void trackComponents();
+    // Recomputes all routes; returns the duration for the event log.
+    std::string recomputeTimed();
+    // Logs routes whose cost reached the end of the cost grid, if any.
+    void logSaturated();
+
+    // Sets the selected link's status inside a journaled transaction.
+    void setSelectedLinkStatus(LinkStatus status);
+    // Hands a committed edit to the journal, if one is attached.
+    void record(const GraphChangeLog& cl);
 
     void log(const std::string& msg);
 
     Graph& graph_;
     Router& router_;
+    ChangeJournal* journal_ = nullptr;
     JsonExporter exporter_;
     HysteresisController hyst_{HysteresisParams{}};
+    MprSelector mpr_;
+    FloodingStats floodStats_;
+    bool floodStatsValid_ = false;
     bool hystEnabled_ = false;
 
     // Selection
@@ -54,6 +87,17 @@ private:
     bool showRouting_ = true;
     bool showActions_ = true;
     bool showLog_ = true;
+    bool showSim_ = true;
+    bool showMetrics_ = false;
+
+    // Metric planes shown in the Routing Table panel and exported
+    MultiPlaneRouter planes_;
+    int plane_ = 0;
+    uint64_t planesFingerprint_ = 0;
+
+    // Connectivity: node colours per component while the network is split
+    bool colorByComponent_ = true;
+    uint32_t lastComponents_ = 0;
 
     // Menu state
     char loadPathBuf_[256] = "assets/topologies/sample_small.json";
@@ -69,6 +113,32 @@ private:
     double hystThetaDown_ = 1.3;
     int hystHoldMs_ = 1000;
 
+    // Protocol simulator (runs alongside the oracle router when started)
+    OlsrSimulator sim_;
+    bool simActive_ = false;   // sim state exists and is drawn
+    bool simRunning_ = false;  // advancing every frame
+    float simSpeed_ = 1.0f;    // simulated ms per wall-clock ms
+    double simLatencyMs_ = 1.0;
+    double simLossProb_ = 0.0;
+    double simHelloMs_ = 2000.0;
+    double simTcMs_ = 5000.0;
+    bool simUseMpr_ = false;
+
+    // Traffic matrix and per-link loads (recomputed when links change)
+    TrafficMatrix traffic_;
+    LinkLoadEngine loads_;
+    bool trafficLoaded_ = false;
+    bool colorByLoad_ = true;
+    uint64_t loadsFingerprint_ = 0;
+    char trafficPathBuf_[256] = "assets/traffic/sample_small.json";
+    char changesPathBuf_[256] = "assets/changes/sample_small.json";
+
+    // Metrics panel: counter rates are taken between refreshes
+    std::vector<uint64_t> metricsPrev_;
+    std::vector<double> metricsRate_;
+    double metricsPrevS_ = 0.0;
+    char traceOutBuf_[256] = "build/olsr_trace.json";
+
     std::vector<UiEvent> events_;
 };
 